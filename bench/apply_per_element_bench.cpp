@@ -0,0 +1,39 @@
+#include "bench.h"
+
+#include <xlib/core/static_soa.h>
+
+#include <string>
+#include <vector>
+
+// Scaling of static_soa::apply_per_element from 1 to all threads of the pool
+XLIB_BENCHMARK(apply_per_element_threads, static_soa)
+{
+   using TestBucket = xlib::static_soa<char*, std::vector<double>, int*, char*, long double*>;
+
+   TestBucket bucket;
+   bucket.resize(state.size());
+
+   auto kernel = [](char& c, double& d, int& i, char& c2, long double& ld, size_t index, double dt)
+   {
+      c = index & 0x3f;
+      d += dt * i;
+      i = index + 1;
+      c2 = c * 2;
+      ld = 1. / (d + 1.);
+   };
+
+   state.measure("seq", [&]{ bucket.apply_per_element(kernel, 1e-3); });
+
+   size_t max_threads = xlib::thread_pool::default_concurrency();
+   std::vector<size_t> thread_counts;
+   for(size_t t = 1; t < max_threads; t *= 2) thread_counts.push_back(t);
+   thread_counts.push_back(max_threads);
+
+   for(size_t t: thread_counts)
+   {
+      std::string threads = std::to_string(t);
+      state.measure("par/" + threads, [&]{ bucket.apply_per_element(xlib::execution::par.threads(t), kernel, 1e-3); });
+      state.measure("par.deterministic/" + threads, [&]{ bucket.apply_per_element(xlib::execution::par.threads(t).deterministic(), kernel, 1e-3); });
+      state.measure("par_unseq/" + threads, [&]{ bucket.apply_per_element(xlib::execution::par_unseq.threads(t), kernel, 1e-3); });
+   }
+}
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <xlib/core/timer.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace xlib
+{
+namespace bench
+{
+
+/** Timing of one benchmark variant at one size
+ */
+struct result
+{
+   std::string group;
+   std::string variant;
+   size_t size;
+   size_t iterations;
+   /** Items processed per iteration, size unless set with state::set_items */
+   size_t items;
+   double mean_ns;
+   double min_ns;
+   double max_ns;
+};
+
+/** Run settings shared by all benchmarks
+ */
+struct settings
+{
+   double min_time = 0.1;
+   size_t min_iterations = 3;
+   size_t max_iterations = 1000000;
+};
+
+/** Passed to every benchmark function, times the measured code and collects
+ * the results
+ */
+class state
+{
+public:
+   state(const std::string& group, const std::string& variant, size_t size, const settings& s, std::vector<result>& results):
+      _group(group), _variant(variant), _size(size), _items(size), _settings(s), _results(results)
+   {}
+
+   /** Number of elements the benchmark should work on
+    */
+   size_t size() const noexcept { return _size; }
+
+   /** Items processed by each iteration of the following measurements
+    */
+   void set_items(size_t items) noexcept { _items = items; }
+
+   /** Time f until the minimum time and iteration count are reached
+    */
+   template < class F >
+   void measure(F&& f)
+   {
+      this->measure(std::string(), std::forward<F>(f), []{});
+   }
+
+   /** Time f, calling reset untimed before every iteration
+    */
+   template < class F, class Reset,
+      class = std::enable_if_t<!std::is_convertible<F, std::string>::value> >
+   void measure(F&& f, Reset&& reset)
+   {
+      this->measure(std::string(), std::forward<F>(f), std::forward<Reset>(reset));
+   }
+
+   /** Time f as a sub variant of the benchmark, reported as variant/label
+    */
+   template < class F >
+   void measure(const std::string& label, F&& f)
+   {
+      this->measure(label, std::forward<F>(f), []{});
+   }
+
+   template < class F, class Reset >
+   void measure(const std::string& label, F&& f, Reset&& reset);
+
+private:
+   std::string _group;
+   std::string _variant;
+   size_t _size;
+   size_t _items;
+   const settings& _settings;
+   std::vector<result>& _results;
+};
+
+using function = void (*)(state&);
+
+/** Add a benchmark to the suite, done by XLIB_BENCHMARK
+ */
+bool register_benchmark(const char* group, const char* variant, function f);
+
+/** Keep the compiler from optimizing away the computation of value
+ */
+template < class T >
+inline void do_not_optimize(T&& value)
+{
+   asm volatile("" : : "g"(&value) : "memory");
+}
+
+/** Keep the compiler from optimizing away or reordering writes to memory
+ */
+inline void clobber_memory()
+{
+   asm volatile("" : : : "memory");
+}
+
+template < class F, class Reset >
+void state::measure(const std::string& label, F&& f, Reset&& reset)
+{
+   reset();
+   f();
+
+   xlib::timer timer;
+   double total = 0, min = 0, max = 0;
+   size_t iterations = 0;
+   while(iterations < _settings.min_iterations ||
+         (total < 1e9 * _settings.min_time && iterations < _settings.max_iterations))
+   {
+      reset();
+      clobber_memory();
+      timer.tic();
+      f();
+      clobber_memory();
+      timer.toc();
+      double ns = timer.elapsed<std::chrono::nanoseconds>();
+      min = iterations ? std::min(min, ns) : ns;
+      max = std::max(max, ns);
+      total += ns;
+      iterations++;
+   }
+   _results.push_back(result{_group, label.empty() ? _variant : _variant + "/" + label,
+      _size, iterations, _items, total / iterations, min, max});
+}
+
+} // namespace bench
+} // namespace xlib
+
+#define XLIB_BENCHMARK_NAME(GROUP, VARIANT) xlib_bench_##GROUP##_##VARIANT
+
+/** Define a benchmark function run for every size of the suite
+ * @param GROUP name of the operation, variants of the same group are compared
+ * @param VARIANT name of the implementation
+ */
+#define XLIB_BENCHMARK(GROUP, VARIANT) \
+   static void XLIB_BENCHMARK_NAME(GROUP, VARIANT)(::xlib::bench::state&); \
+   static const bool XLIB_BENCHMARK_NAME(GROUP, VARIANT##_registered) = \
+      ::xlib::bench::register_benchmark(#GROUP, #VARIANT, XLIB_BENCHMARK_NAME(GROUP, VARIANT)); \
+   static void XLIB_BENCHMARK_NAME(GROUP, VARIANT)(::xlib::bench::state& state)
@@ -0,0 +1,54 @@
+#include "bench.h"
+
+#include <xlib/core/double_buffer.h>
+
+#include <algorithm>
+
+// One explicit Euler step of positions and velocities, copying the new state
+// over the old one against swapping the buffers of double_buffer columns
+
+namespace
+{
+
+void step(const double* x, const double* v, double* x_new, double* v_new, size_t n)
+{
+   const double dt = 1e-3;
+   for(size_t i = 0; i < n; ++i)
+   {
+      x_new[i] = x[i] + dt * v[i];
+      v_new[i] = v[i] - dt * x[i];
+   }
+}
+
+} // namespace
+
+XLIB_BENCHMARK(time_step, copy_state)
+{
+   xlib::static_soa<double*, double*> old_state, new_state;
+   old_state.resize(state.size());
+   new_state.resize(state.size());
+   state.measure([&]
+   {
+      double* x = old_state.get_data<0>();
+      double* v = old_state.get_data<1>();
+      step(x, v, new_state.get_data<0>(), new_state.get_data<1>(), state.size());
+      std::copy_n(new_state.get_data<0>(), state.size(), x);
+      std::copy_n(new_state.get_data<1>(), state.size(), v);
+      xlib::bench::do_not_optimize(x);
+   });
+}
+
+XLIB_BENCHMARK(time_step, double_buffer)
+{
+   xlib::static_soa<xlib::double_buffer<double*>, xlib::double_buffer<double*>> soa;
+   soa.resize(state.size());
+   state.measure([&]
+   {
+      auto& x = soa.get_data<0>();
+      auto& v = soa.get_data<1>();
+      step(x.current(), v.current(), x.next(), v.next(), soa.size());
+      x.swap_buffers();
+      v.swap_buffers();
+      xlib::bench::do_not_optimize(x.current());
+   });
+}
@@ -0,0 +1,186 @@
+#include "bench.h"
+
+#include <xlib/core/execution.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <ostream>
+
+namespace xlib
+{
+namespace bench
+{
+
+struct benchmark
+{
+   const char* group;
+   const char* variant;
+   function f;
+};
+
+static std::vector<benchmark>& registry()
+{
+   static std::vector<benchmark> benchmarks;
+   return benchmarks;
+}
+
+bool register_benchmark(const char* group, const char* variant, function f)
+{
+   registry().push_back(benchmark{group, variant, f});
+   return true;
+}
+
+static void write_string(std::ostream& os, const std::string& s)
+{
+   os << '"';
+   for(char c: s)
+   {
+      if(c == '"' || c == '\\') os << '\\';
+      os << c;
+   }
+   os << '"';
+}
+
+static void write_json(std::ostream& os, const std::vector<result>& results)
+{
+   char date[64];
+   std::time_t now = std::time(nullptr);
+   std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+
+   os << "{\n  \"context\": {\n";
+   os << "    \"date\": "; write_string(os, date); os << ",\n";
+#if defined(__VERSION__)
+   os << "    \"compiler\": "; write_string(os, __VERSION__); os << ",\n";
+#endif
+#if defined(NDEBUG)
+   os << "    \"build_type\": \"release\",\n";
+#else
+   os << "    \"build_type\": \"debug\",\n";
+#endif
+   os << "    \"threads\": " << xlib::thread_pool::default_concurrency() << "\n  },\n";
+   os << "  \"benchmarks\": [";
+   char number[64];
+   for(size_t i = 0; i < results.size(); ++i)
+   {
+      const result& r = results[i];
+      os << (i ? ",\n" : "\n") << "    {\"group\": ";
+      write_string(os, r.group);
+      os << ", \"variant\": ";
+      write_string(os, r.variant);
+      os << ", \"size\": " << r.size << ", \"items\": " << r.items << ", \"iterations\": " << r.iterations;
+      std::snprintf(number, sizeof(number), "%.3f", r.mean_ns);
+      os << ", \"mean_ns\": " << number;
+      std::snprintf(number, sizeof(number), "%.3f", r.min_ns);
+      os << ", \"min_ns\": " << number;
+      std::snprintf(number, sizeof(number), "%.3f", r.max_ns);
+      os << ", \"max_ns\": " << number;
+      std::snprintf(number, sizeof(number), "%.6f", r.items ? r.mean_ns / r.items : 0.0);
+      os << ", \"ns_per_item\": " << number << "}";
+   }
+   os << "\n  ]\n}\n";
+}
+
+static void print_result(const result& r)
+{
+   std::printf("%-24s %-36s %12zu %10zu %14.1f %12.4f\n", r.group.c_str(), r.variant.c_str(),
+      r.size, r.iterations, r.mean_ns, r.items ? r.mean_ns / r.items : 0.0);
+   std::fflush(stdout);
+}
+
+static void usage(const char* name)
+{
+   std::printf(
+      "usage: %s [options]\n"
+      "  --filter=TEXT     only run benchmarks whose group/variant contains TEXT\n"
+      "  --min-size=N      smallest number of elements (default 1e3)\n"
+      "  --max-size=N      largest number of elements (default 1e8)\n"
+      "  --min-time=S      minimum seconds measured per variant and size (default 0.1)\n"
+      "  --json=FILE       write the results as JSON to FILE, - for stdout\n"
+      "  --list            list the benchmarks\n", name);
+}
+
+} // namespace bench
+} // namespace xlib
+
+// Runs every registered benchmark for sizes in powers of ten
+int main(int argc, char* argv[])
+{
+   using namespace xlib::bench;
+
+   settings s;
+   std::string filter, json;
+   double min_size = 1e3, max_size = 1e8;
+   bool list = false;
+   for(int a = 1; a < argc; ++a)
+   {
+      const char* arg = argv[a];
+      auto value = [arg](const char* option) -> const char*
+      {
+         size_t n = std::strlen(option);
+         return std::strncmp(arg, option, n) == 0 && arg[n] == '=' ? arg + n + 1 : nullptr;
+      };
+      if(const char* v = value("--filter")) filter = v;
+      else if(const char* v = value("--min-size")) min_size = std::strtod(v, nullptr);
+      else if(const char* v = value("--max-size")) max_size = std::strtod(v, nullptr);
+      else if(const char* v = value("--min-time")) s.min_time = std::strtod(v, nullptr);
+      else if(const char* v = value("--json")) json = v;
+      else if(std::strcmp(arg, "--list") == 0) list = true;
+      else
+      {
+         usage(argv[0]);
+         return std::strcmp(arg, "--help") == 0 ? 0 : 1;
+      }
+   }
+
+   std::vector<size_t> sizes;
+   for(double n = min_size; n <= max_size * (1 + 1e-9); n *= 10)
+   {
+      sizes.push_back(static_cast<size_t>(std::llround(n)));
+   }
+
+   bool quiet = json == "-";
+   if(!quiet && !list)
+   {
+      std::printf("%-24s %-36s %12s %10s %14s %12s\n", "group", "variant", "size", "iterations", "ns/iteration", "ns/item");
+   }
+
+   std::vector<result> results;
+   for(auto& b: registry())
+   {
+      std::string name = std::string(b.group) + "/" + b.variant;
+      if(!filter.empty() && name.find(filter) == std::string::npos) continue;
+      if(list)
+      {
+         std::printf("%s\n", name.c_str());
+         continue;
+      }
+      for(size_t n: sizes)
+      {
+         size_t first = results.size();
+         state st(b.group, b.variant, n, s, results);
+         b.f(st);
+         for(size_t r = first; r < results.size() && !quiet; ++r) print_result(results[r]);
+      }
+   }
+
+   if(json == "-")
+   {
+      write_json(std::cout, results);
+   }
+   else if(!json.empty())
+   {
+      std::ofstream os(json);
+      write_json(os, results);
+      if(!os)
+      {
+         std::fprintf(stderr, "could not write %s\n", json.c_str());
+         return 1;
+      }
+   }
+   return 0;
+}
@@ -0,0 +1,71 @@
+#include "bench.h"
+
+#include <xlib/core/static_soa.h>
+
+#include <vector>
+
+// Total mass of a column of doubles and total kinetic energy from two
+// columns, a plain serial loop against static_soa::sum and transform_reduce
+
+namespace
+{
+
+using parcels = xlib::static_soa<double*, double*>;
+
+void fill(parcels& soa, size_t n)
+{
+   soa.resize(n);
+   soa.apply_per_element([](double& m, double& u, size_t i)
+   {
+      m = 1.0 + 1e-3 * (i % 1000);
+      u = 0.5 - 1e-4 * (i % 10000);
+   });
+}
+
+} // namespace
+
+XLIB_BENCHMARK(reduce_sum, serial_loop)
+{
+   parcels soa;
+   fill(soa, state.size());
+   state.measure([&]
+   {
+      const double* m = soa.get_data<0>();
+      double total = 0;
+      for(size_t i = 0; i < soa.size(); ++i) total += m[i];
+      xlib::bench::do_not_optimize(total);
+   });
+}
+
+XLIB_BENCHMARK(reduce_sum, static_soa)
+{
+   parcels soa;
+   fill(soa, state.size());
+   state.measure("seq", [&]{ xlib::bench::do_not_optimize(soa.sum<0>()); });
+   state.measure("par", [&]{ xlib::bench::do_not_optimize(soa.sum<0>(xlib::execution::par)); });
+   state.measure("par.deterministic", [&]{ xlib::bench::do_not_optimize(soa.sum<0>(xlib::execution::par.deterministic())); });
+}
+
+XLIB_BENCHMARK(reduce_energy, serial_loop)
+{
+   parcels soa;
+   fill(soa, state.size());
+   state.measure([&]
+   {
+      const double* m = soa.get_data<0>();
+      const double* u = soa.get_data<1>();
+      double total = 0;
+      for(size_t i = 0; i < soa.size(); ++i) total += 0.5 * m[i] * u[i] * u[i];
+      xlib::bench::do_not_optimize(total);
+   });
+}
+
+XLIB_BENCHMARK(reduce_energy, static_soa)
+{
+   parcels soa;
+   fill(soa, state.size());
+   auto energy = [](double m, double u, size_t) { return 0.5 * m * u * u; };
+   state.measure("seq", [&]{ xlib::bench::do_not_optimize(soa.transform_reduce(energy, std::plus<>())); });
+   state.measure("par", [&]{ xlib::bench::do_not_optimize(soa.transform_reduce(xlib::execution::par, energy, std::plus<>())); });
+   state.measure("par.deterministic", [&]{ xlib::bench::do_not_optimize(soa.transform_reduce(xlib::execution::par.deterministic(), energy, std::plus<>())); });
+}
@@ -0,0 +1,85 @@
+#include "bench.h"
+
+#include <xlib/core/soa_csr_index.h>
+
+#include <map>
+#include <random>
+#include <vector>
+
+// Cell to parcel lookup after one percent of the parcels moved to a random
+// cell, rebuilding a std::map every step against updating a
+// soa_csr_index
+
+namespace
+{
+
+using parcels = xlib::static_soa<std::vector<double>, int32_t*>;
+
+/** Parcels spread over size() / 16 cells
+ */
+size_t fill_cells(parcels& soa, size_t n)
+{
+   size_t num_cells = std::max<size_t>(1, n / 16);
+   soa.resize(n);
+   std::mt19937 rng(1);
+   std::uniform_int_distribution<int32_t> cell(0, static_cast<int32_t>(num_cells - 1));
+   int32_t* cells = soa.get_data<1>();
+   for(size_t i = 0; i < n; ++i) cells[i] = cell(rng);
+   return num_cells;
+}
+
+/** Move every hundredth parcel to a random cell, unstructured cell numbering
+ * puts the new cell anywhere in the key range
+ */
+void step(parcels& soa, size_t num_cells, std::mt19937& rng)
+{
+   int32_t* cells = soa.get_data<1>();
+   std::uniform_int_distribution<int32_t> cell(0, static_cast<int32_t>(num_cells - 1));
+   for(size_t i = rng() % 100; i < soa.size(); i += 100) cells[i] = cell(rng);
+}
+
+} // namespace
+
+XLIB_BENCHMARK(cell_index, map_rebuild)
+{
+   parcels soa;
+   size_t num_cells = fill_cells(soa, state.size());
+   std::mt19937 rng(2);
+   std::map<int32_t, std::vector<size_t>> cell_parcels;
+   state.measure([&]
+   {
+      step(soa, num_cells, rng);
+      cell_parcels.clear();
+      const int32_t* cells = soa.get_data<1>();
+      for(size_t i = 0; i < soa.size(); ++i) cell_parcels[cells[i]].push_back(i);
+      xlib::bench::do_not_optimize(cell_parcels);
+   });
+}
+
+XLIB_BENCHMARK(cell_index, csr_rebuild)
+{
+   parcels soa;
+   size_t num_cells = fill_cells(soa, state.size());
+   std::mt19937 rng(2);
+   xlib::soa_csr_index<parcels, 1> index(soa, num_cells);
+   state.measure([&]
+   {
+      step(soa, num_cells, rng);
+      index.rebuild();
+      xlib::bench::do_not_optimize(index);
+   });
+}
+
+XLIB_BENCHMARK(cell_index, csr_update)
+{
+   parcels soa;
+   size_t num_cells = fill_cells(soa, state.size());
+   std::mt19937 rng(2);
+   xlib::soa_csr_index<parcels, 1> index(soa, num_cells);
+   state.measure([&]
+   {
+      step(soa, num_cells, rng);
+      index.update();
+      xlib::bench::do_not_optimize(index);
+   });
+}
@@ -0,0 +1,445 @@
+#include "bench.h"
+
+#include <xlib/core/static_soa.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <numeric>
+#include <random>
+#include <vector>
+
+// static_soa compared against a std::vector of structs (aos) and a hand
+// written struct of raw arrays (soa_raw) holding the same fields
+
+namespace
+{
+
+struct particle
+{
+   double x, y, z;
+   double mass;
+   int64_t id;
+};
+
+using particles = xlib::static_soa<std::vector<double>, std::vector<double>, std::vector<double>, double*, std::vector<int64_t>>;
+
+// Raw pointer columns, one allocation per column or all of them in one slab
+using pointer_particles = xlib::static_soa<double*, double*, double*, double*, int64_t*>;
+using arena_particles = xlib::arena_static_soa<double*, double*, double*, double*, int64_t*>;
+
+/** Hand written structure of arrays with geometric growth
+ */
+struct raw_particles
+{
+   double* x = nullptr;
+   double* y = nullptr;
+   double* z = nullptr;
+   double* mass = nullptr;
+   int64_t* id = nullptr;
+   size_t size = 0;
+   size_t capacity = 0;
+
+   raw_particles() = default;
+   raw_particles(const raw_particles&) = delete;
+   raw_particles& operator=(const raw_particles&) = delete;
+   ~raw_particles()
+   {
+      this->reallocate(0);
+   }
+
+   template < class F >
+   void for_each_array(F&& f)
+   {
+      f(x); f(y); f(z); f(mass); f(id);
+   }
+
+   void reallocate(size_t n)
+   {
+      this->for_each_array([&](auto*& p)
+      {
+         using T = std::remove_reference_t<decltype(*p)>;
+         if(n == 0)
+         {
+            std::free(p);
+            p = nullptr;
+         }
+         else
+         {
+            p = static_cast<T*>(std::realloc(p, n * sizeof(T)));
+         }
+      });
+      capacity = n;
+   }
+
+   void resize(size_t n)
+   {
+      if(n > capacity) this->reallocate(std::max(n, 2 * capacity));
+      if(n > size)
+      {
+         this->for_each_array([&](auto* p) { std::memset(p + size, 0, (n - size) * sizeof(*p)); });
+      }
+      size = n;
+   }
+
+   void shrink_to_fit()
+   {
+      this->reallocate(size);
+   }
+};
+
+constexpr size_t resize_steps = 16;
+
+template < class Soa >
+void fill(Soa& soa, size_t n)
+{
+   soa.resize(n);
+   soa.apply_per_element([](double& x, double& y, double& z, double& m, int64_t& id, size_t i)
+   {
+      x = i; y = 2. * i; z = 3. * i; m = 1. + (i & 7); id = i;
+   });
+}
+
+void fill(std::vector<particle>& aos, size_t n)
+{
+   aos.resize(n);
+   for(size_t i = 0; i < n; ++i) aos[i] = particle{double(i), 2. * i, 3. * i, 1. + (i & 7), int64_t(i)};
+}
+
+void fill(raw_particles& soa, size_t n)
+{
+   soa.resize(n);
+   for(size_t i = 0; i < n; ++i)
+   {
+      soa.x[i] = i; soa.y[i] = 2. * i; soa.z[i] = 3. * i; soa.mass[i] = 1. + (i & 7); soa.id[i] = i;
+   }
+}
+
+std::vector<size_t> random_permutation(size_t n)
+{
+   std::vector<size_t> map(n);
+   std::iota(map.begin(), map.end(), size_t(0));
+   std::shuffle(map.begin(), map.end(), std::mt19937_64(42));
+   return map;
+}
+
+constexpr double dt = 1e-3;
+
+inline void push(double& x, double& y, double& z, double m, int64_t id)
+{
+   x += dt * m;
+   y -= dt * m;
+   z += dt * id;
+}
+
+} // namespace
+
+// Grow from empty to size() in resize_steps calls of resize
+
+XLIB_BENCHMARK(resize_grow, static_soa)
+{
+   particles soa;
+   size_t n = state.size();
+   state.measure([&]{ for(size_t k = 1; k <= resize_steps; ++k) soa.resize(n * k / resize_steps); },
+                 [&]{ soa.resize(0); soa.shrink_to_fit(); });
+}
+
+XLIB_BENCHMARK(resize_grow, static_soa_pointers)
+{
+   pointer_particles soa;
+   size_t n = state.size();
+   state.measure([&]{ for(size_t k = 1; k <= resize_steps; ++k) soa.resize(n * k / resize_steps); },
+                 [&]{ soa.resize(0); soa.shrink_to_fit(); });
+}
+
+XLIB_BENCHMARK(resize_grow, static_soa_arena)
+{
+   arena_particles soa;
+   size_t n = state.size();
+   state.measure([&]{ for(size_t k = 1; k <= resize_steps; ++k) soa.resize(n * k / resize_steps); },
+                 [&]{ soa.resize(0); soa.shrink_to_fit(); });
+}
+
+XLIB_BENCHMARK(resize_grow, aos)
+{
+   std::vector<particle> aos;
+   size_t n = state.size();
+   state.measure([&]{ for(size_t k = 1; k <= resize_steps; ++k) aos.resize(n * k / resize_steps); },
+                 [&]{ aos.clear(); aos.shrink_to_fit(); });
+}
+
+XLIB_BENCHMARK(resize_grow, soa_raw)
+{
+   raw_particles soa;
+   size_t n = state.size();
+   state.measure([&]{ for(size_t k = 1; k <= resize_steps; ++k) soa.resize(n * k / resize_steps); },
+                 [&]{ soa.resize(0); soa.shrink_to_fit(); });
+}
+
+// Resize from empty to size() in one call, then touch every element with the
+// deterministic schedule the first touch partitions the pages for
+
+XLIB_BENCHMARK(first_touch, static_soa_pointers)
+{
+   pointer_particles soa;
+   auto kernel = [](double& x, double& y, double& z, double& m, int64_t& id, size_t) { push(x, y, z, m, id); };
+   state.measure("seq", [&]
+   {
+      soa.resize(xlib::execution::seq, state.size());
+      soa.apply_per_element(xlib::soa_first_touch_policy, kernel);
+   }, [&]{ soa.resize(0); soa.shrink_to_fit(); });
+   state.measure("par", [&]
+   {
+      soa.resize(xlib::soa_first_touch_policy, state.size());
+      soa.apply_per_element(xlib::soa_first_touch_policy, kernel);
+   }, [&]{ soa.resize(0); soa.shrink_to_fit(); });
+}
+
+XLIB_BENCHMARK(first_touch, static_soa_arena)
+{
+   arena_particles soa;
+   auto kernel = [](double& x, double& y, double& z, double& m, int64_t& id, size_t) { push(x, y, z, m, id); };
+   state.measure("seq", [&]
+   {
+      soa.resize(xlib::execution::seq, state.size());
+      soa.apply_per_element(xlib::soa_first_touch_policy, kernel);
+   }, [&]{ soa.resize(0); soa.shrink_to_fit(); });
+   state.measure("par", [&]
+   {
+      soa.resize(xlib::soa_first_touch_policy, state.size());
+      soa.apply_per_element(xlib::soa_first_touch_policy, kernel);
+   }, [&]{ soa.resize(0); soa.shrink_to_fit(); });
+}
+
+// Shrink from size() to empty in resize_steps calls of resize, then release the storage
+
+XLIB_BENCHMARK(resize_shrink, static_soa)
+{
+   particles soa;
+   size_t n = state.size();
+   state.measure([&]{ for(size_t k = resize_steps; k-- > 0;) soa.resize(n * k / resize_steps); soa.shrink_to_fit(); },
+                 [&]{ soa.resize(n); });
+}
+
+XLIB_BENCHMARK(resize_shrink, aos)
+{
+   std::vector<particle> aos;
+   size_t n = state.size();
+   state.measure([&]{ for(size_t k = resize_steps; k-- > 0;) aos.resize(n * k / resize_steps); aos.shrink_to_fit(); },
+                 [&]{ aos.resize(n); });
+}
+
+XLIB_BENCHMARK(resize_shrink, soa_raw)
+{
+   raw_particles soa;
+   size_t n = state.size();
+   state.measure([&]{ for(size_t k = resize_steps; k-- > 0;) soa.resize(n * k / resize_steps); soa.shrink_to_fit(); },
+                 [&]{ soa.resize(n); });
+}
+
+// Per element update of the positions
+
+XLIB_BENCHMARK(apply, static_soa)
+{
+   particles soa;
+   fill(soa, state.size());
+   auto kernel = [](double& x, double& y, double& z, double& m, int64_t& id, size_t)
+   {
+      push(x, y, z, m, id);
+   };
+   state.measure("apply_per_element", [&]{ soa.apply_per_element(kernel); });
+   state.measure("apply_to_element", [&]
+   {
+      size_t n = soa.size();
+      for(size_t i = 0; i < n; ++i) soa.apply_to_element(i, kernel, i);
+   });
+}
+
+XLIB_BENCHMARK(apply, static_soa_pointers)
+{
+   pointer_particles soa;
+   fill(soa, state.size());
+   state.measure([&]
+   {
+      soa.apply_per_element([](double& x, double& y, double& z, double& m, int64_t& id, size_t) { push(x, y, z, m, id); });
+   });
+}
+
+XLIB_BENCHMARK(apply, static_soa_arena)
+{
+   arena_particles soa;
+   fill(soa, state.size());
+   state.measure([&]
+   {
+      soa.apply_per_element([](double& x, double& y, double& z, double& m, int64_t& id, size_t) { push(x, y, z, m, id); });
+   });
+}
+
+XLIB_BENCHMARK(apply, aos)
+{
+   std::vector<particle> aos;
+   fill(aos, state.size());
+   state.measure([&]
+   {
+      for(auto& p: aos) push(p.x, p.y, p.z, p.mass, p.id);
+   });
+}
+
+XLIB_BENCHMARK(apply, soa_raw)
+{
+   raw_particles soa;
+   fill(soa, state.size());
+   state.measure([&]
+   {
+      for(size_t i = 0; i < soa.size; ++i) push(soa.x[i], soa.y[i], soa.z[i], soa.mass[i], soa.id[i]);
+   });
+}
+
+// Apply a random permutation, element i moves to map[i]
+
+XLIB_BENCHMARK(reorder, static_soa)
+{
+   particles soa;
+   fill(soa, state.size());
+   auto map = random_permutation(state.size());
+   state.measure("seq", [&]{ soa.reorder(map); });
+   state.measure("par", [&]{ soa.reorder(xlib::execution::par, map); });
+}
+
+XLIB_BENCHMARK(reorder, static_soa_pointers)
+{
+   pointer_particles soa;
+   fill(soa, state.size());
+   auto map = random_permutation(state.size());
+   state.measure("par", [&]{ soa.reorder(xlib::execution::par, map); });
+}
+
+XLIB_BENCHMARK(reorder, static_soa_arena)
+{
+   arena_particles soa;
+   fill(soa, state.size());
+   auto map = random_permutation(state.size());
+   state.measure("par", [&]{ soa.reorder(xlib::execution::par, map); });
+}
+
+XLIB_BENCHMARK(reorder, aos)
+{
+   std::vector<particle> aos, scratch(state.size());
+   fill(aos, state.size());
+   auto map = random_permutation(state.size());
+   state.measure([&]
+   {
+      for(size_t i = 0; i < aos.size(); ++i) scratch[map[i]] = aos[i];
+      aos.swap(scratch);
+   });
+}
+
+XLIB_BENCHMARK(reorder, soa_raw)
+{
+   raw_particles soa, scratch;
+   fill(soa, state.size());
+   scratch.resize(state.size());
+   auto map = random_permutation(state.size());
+   state.measure([&]
+   {
+      auto scatter = [&](auto*& src, auto*& dst)
+      {
+         for(size_t i = 0; i < soa.size; ++i) dst[map[i]] = src[i];
+         std::swap(src, dst);
+      };
+      scatter(soa.x, scratch.x);
+      scatter(soa.y, scratch.y);
+      scatter(soa.z, scratch.z);
+      scatter(soa.mass, scratch.mass);
+      scatter(soa.id, scratch.id);
+   });
+}
+
+// Access an array through a type erased handle per element
+
+XLIB_BENCHMARK(handle_data, static_soa)
+{
+   particles soa;
+   fill(soa, state.size());
+   particles::handle h(soa.get_handle<0>());
+   state.measure("handle", [&]
+   {
+      size_t n = soa.size();
+      for(size_t i = 0; i < n; ++i) h.data<std::vector<double>>()[i] += 1.;
+   });
+   state.measure("get_data", [&]
+   {
+      size_t n = soa.size();
+      for(size_t i = 0; i < n; ++i) soa.get_data<0>()[i] += 1.;
+   });
+}
+
+XLIB_BENCHMARK(handle_data, aos)
+{
+   std::vector<particle> aos;
+   fill(aos, state.size());
+   state.measure([&]
+   {
+      for(size_t i = 0; i < aos.size(); ++i) aos[i].x += 1.;
+   });
+}
+
+XLIB_BENCHMARK(handle_data, soa_raw)
+{
+   raw_particles soa;
+   fill(soa, state.size());
+   state.measure([&]
+   {
+      for(size_t i = 0; i < soa.size; ++i) soa.x[i] += 1.;
+   });
+}
+
+// Read whole elements one at a time
+
+XLIB_BENCHMARK(get_element, static_soa)
+{
+   particles soa;
+   fill(soa, state.size());
+   state.measure([&]
+   {
+      double sum = 0;
+      size_t n = soa.size();
+      for(size_t i = 0; i < n; ++i)
+      {
+         auto e = soa.get_element(i);
+         sum += std::get<0>(e) + std::get<3>(e) + std::get<4>(e);
+      }
+      xlib::bench::do_not_optimize(sum);
+   });
+}
+
+XLIB_BENCHMARK(get_element, aos)
+{
+   std::vector<particle> aos;
+   fill(aos, state.size());
+   state.measure([&]
+   {
+      double sum = 0;
+      for(size_t i = 0; i < aos.size(); ++i)
+      {
+         particle p = aos[i];
+         sum += p.x + p.mass + p.id;
+      }
+      xlib::bench::do_not_optimize(sum);
+   });
+}
+
+XLIB_BENCHMARK(get_element, soa_raw)
+{
+   raw_particles soa;
+   fill(soa, state.size());
+   state.measure([&]
+   {
+      double sum = 0;
+      for(size_t i = 0; i < soa.size; ++i)
+      {
+         sum += soa.x[i] + soa.mass[i] + soa.id[i];
+      }
+      xlib::bench::do_not_optimize(sum);
+   });
+}
@@ -1,5 +1,7 @@
+#pragma once
 
+#include <cassert>
 
 #define _XLIB_ASSERT(TYPE, ...) _XLIB_ASSERT_##TYPE ( __VA_ARGS__)
 
-#define _XLIB_ASSERT_RANGE(L_BOUND, U_BOUND, X) assert((L_BOUND) < (X)); assert((U_BOUND) > (X))
+#define _XLIB_ASSERT_RANGE(L_BOUND, U_BOUND, X) assert(!((X) < (L_BOUND))); assert((U_BOUND) > (X))
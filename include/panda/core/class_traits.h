@@ -6,12 +6,18 @@ namespace xlib
 
 class non_copyable
 {
+protected:
+   non_copyable() = default;
+private:
    non_copyable(const non_copyable&) = delete;
    non_copyable& operator=(const non_copyable&) = delete;
 };
 
 class non_moveable
 {
+protected:
+   non_moveable() = default;
+private:
    non_moveable(non_moveable&&) = delete;
    non_moveable& operator=(non_moveable&&) = delete;
 };
@@ -19,4 +25,4 @@ class non_moveable
 class singleton: non_copyable, non_moveable
 {};
 
-}
\ No newline at end of file
+}
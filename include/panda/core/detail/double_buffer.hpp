@@ -0,0 +1,149 @@
+#include <utility>
+
+namespace xlib
+{
+
+template < class Column >
+double_buffer<Column>::double_buffer(double_buffer&& other) noexcept
+{
+   this->swap(other);
+}
+
+template < class Column >
+double_buffer<Column>& double_buffer<Column>::operator=(double_buffer&& other) noexcept
+{
+   // The old buffers are released by other
+   this->swap(other);
+   return *this;
+}
+
+template < class Column >
+double_buffer<Column>::~double_buffer()
+{
+   detail::soa_dtor<Column>()(_current);
+   detail::soa_dtor<Column>()(_next);
+}
+
+template < class Column >
+void double_buffer<Column>::swap_buffers() noexcept
+{
+   using std::swap;
+   swap(_current, _next);
+}
+
+template < class Column >
+auto double_buffer<Column>::data() noexcept
+{
+   return detail::soa_data<Column>()(_current);
+}
+
+template < class Column >
+auto double_buffer<Column>::data() const noexcept
+{
+   if constexpr(std::is_pointer<Column>::value)
+   {
+      return static_cast<const value_type*>(_current);
+   }
+   else
+   {
+      return _current.data();
+   }
+}
+
+template < class Column >
+size_t double_buffer<Column>::size() const noexcept
+{
+   return detail::soa_size_of<Column>()(_current);
+}
+
+template < class Column >
+size_t double_buffer<Column>::capacity() const noexcept
+{
+   return detail::soa_capacity<Column>()(_current);
+}
+
+template < class Column >
+void double_buffer<Column>::resize(size_t n)
+{
+   detail::soa_resize<Column>()(_current, n);
+   detail::soa_resize<Column>()(_next, n);
+}
+
+template < class Column >
+void double_buffer<Column>::resize(size_t n, const value_type& value)
+{
+   detail::soa_initializer<value_type> init;
+   init.value = &value;
+   detail::soa_resize<Column>()(_current, n, init);
+   detail::soa_resize<Column>()(_next, n, init);
+}
+
+template < class Column >
+void double_buffer<Column>::reserve(size_t n)
+{
+   detail::soa_reserve<Column>()(_current, n);
+   detail::soa_reserve<Column>()(_next, n);
+}
+
+template < class Column >
+void double_buffer<Column>::shrink_to_fit()
+{
+   detail::soa_shrink_to_fit<Column>()(_current);
+   detail::soa_shrink_to_fit<Column>()(_next);
+}
+
+template < class Column >
+void double_buffer<Column>::swap(double_buffer& other) noexcept
+{
+   using std::swap;
+   swap(_current, other._current);
+   swap(_next, other._next);
+}
+
+namespace detail
+{
+
+// SOA reorder handler, permutes both buffers
+template < class Column >
+struct soa_reorder<double_buffer<Column>>
+{
+   template < class Int >
+   void operator()(double_buffer<Column>& data, const soa_permutation<Int>& perm)
+   {
+      soa_reorder<Column>()(data.current(), perm);
+      soa_reorder<Column>()(data.next(), perm);
+   }
+
+   template < class ExecutionPolicy, class Int >
+   void operator()(double_buffer<Column>& data, ExecutionPolicy&& policy, const soa_permutation<Int>& perm)
+   {
+      soa_reorder<Column>()(data.current(), policy, perm);
+      soa_reorder<Column>()(data.next(), policy, perm);
+   }
+};
+
+// SOA element move handler, moves the element in both buffers
+template < class Column >
+struct soa_move_element<double_buffer<Column>>
+{
+   void operator()(double_buffer<Column>& data, size_t dst, size_t src)
+   {
+      soa_move_element<Column>()(data.current(), dst, src);
+      soa_move_element<Column>()(data.next(), dst, src);
+   }
+};
+
+// SOA gather handler, gathers both buffers
+template < class Column >
+struct soa_gather<double_buffer<Column>>
+{
+   template < class ExecutionPolicy >
+   void operator()(double_buffer<Column>& data, ExecutionPolicy&& policy, const std::vector<size_t>& src)
+   {
+      soa_gather<Column>()(data.current(), policy, src);
+      soa_gather<Column>()(data.next(), policy, src);
+   }
+};
+
+} // namespace detail
+} // namespace xlib
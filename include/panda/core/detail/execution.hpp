@@ -0,0 +1,98 @@
+#include <algorithm>
+#include <atomic>
+
+namespace xlib
+{
+namespace detail
+{
+
+/** Chunk layout of an index range for a parallel policy
+ */
+struct chunk_layout
+{
+   size_t chunk_size;
+   size_t num_chunks;
+   size_t num_threads;
+};
+
+template < class Derived >
+chunk_layout make_chunk_layout(const execution::basic_parallel_policy<Derived>& policy, size_t n)
+{
+   size_t num_threads = policy.num_threads ? policy.num_threads : thread_pool::default_concurrency();
+   size_t chunk_size = policy.chunk_size;
+   if(chunk_size == 0)
+   {
+      if(policy.sched == execution::schedule::deterministic)
+      {
+         chunk_size = execution::default_deterministic_chunk;
+      }
+      else
+      {
+         chunk_size = std::max(execution::default_min_chunk, (n + 4 * num_threads - 1) / (4 * num_threads));
+      }
+   }
+   size_t num_chunks = (n + chunk_size - 1) / chunk_size;
+   return {chunk_size, num_chunks, std::max<size_t>(1, std::min(num_threads, num_chunks))};
+}
+
+/** Copy of a policy whose chunks over n indices are a multiple of multiple
+ */
+template < class ExecutionPolicy >
+std::remove_cv_t<std::remove_reference_t<ExecutionPolicy>>
+round_chunks(ExecutionPolicy&& policy, size_t n, size_t multiple)
+{
+   std::remove_cv_t<std::remove_reference_t<ExecutionPolicy>> p = policy;
+   if constexpr(!std::is_same_v<decltype(p), execution::sequenced_policy>)
+   {
+      size_t chunk_size = make_chunk_layout(p, n).chunk_size;
+      p.chunk_size = (chunk_size + multiple - 1) / multiple * multiple;
+   }
+   return p;
+}
+
+template < class ExecutionPolicy, class F >
+void parallel_for(ExecutionPolicy&& policy, size_t begin, size_t end, F&& f)
+{
+   using policy_t = std::remove_cv_t<std::remove_reference_t<ExecutionPolicy>>;
+   static_assert(execution::is_execution_policy_v<policy_t>, "parallel_for requires an xlib execution policy");
+
+   if(begin >= end) return;
+
+   if constexpr(std::is_same_v<policy_t, execution::sequenced_policy>)
+   {
+      f(begin, end);
+   }
+   else
+   {
+      size_t n = end - begin;
+      chunk_layout layout = make_chunk_layout(policy, n);
+      auto run_chunk = [&](size_t k)
+      {
+         size_t b = begin + k * layout.chunk_size;
+         f(b, std::min(end, b + layout.chunk_size));
+      };
+
+      if(layout.num_threads == 1)
+      {
+         for(size_t k = 0; k < layout.num_chunks; ++k) run_chunk(k);
+      }
+      else if(policy.sched == execution::schedule::deterministic)
+      {
+         thread_pool::instance().run(layout.num_threads, [&](size_t t, size_t num_threads)
+         {
+            for(size_t k = t; k < layout.num_chunks; k += num_threads) run_chunk(k);
+         });
+      }
+      else
+      {
+         std::atomic<size_t> next{0};
+         thread_pool::instance().run(layout.num_threads, [&](size_t, size_t)
+         {
+            for(size_t k = next++; k < layout.num_chunks; k = next++) run_chunk(k);
+         });
+      }
+   }
+}
+
+} // namespace detail
+} // namespace xlib
@@ -0,0 +1,97 @@
+#include <cstring>
+#include <memory>
+
+namespace xlib
+{
+
+template < class T >
+mapped_column<T>::mapped_column() noexcept:
+   _storage(sizeof(T), soa_alignment_v<T>)
+{}
+
+template < class T >
+mapped_column<T>::mapped_column(const std::string& path, map_mode mode):
+   _storage(path, mode, sizeof(T), soa_alignment_v<T>)
+{}
+
+template < class T >
+void mapped_column<T>::resize(size_t n)
+{
+   size_t old_size = this->size();
+   if(n > this->capacity())
+   {
+      _storage.reallocate(detail::soa_grow_capacity(this->capacity(), n));
+   }
+   if(n < old_size)
+   {
+      // Keep everything past the size zeroed, growing then needs no fill
+      std::memset(static_cast<void*>(this->data() + n), 0, (old_size - n) * sizeof(T));
+   }
+   if(n != old_size) _storage.set_size(n);
+}
+
+template < class T >
+void mapped_column<T>::reserve(size_t n)
+{
+   if(n > this->capacity()) _storage.reallocate(n);
+}
+
+template < class T >
+void mapped_column<T>::shrink_to_fit()
+{
+   if(this->capacity() > this->size()) _storage.reallocate(this->size());
+}
+
+namespace detail
+{
+
+// SOA reorder handler, scatters into scratch memory so the column keeps its mapping
+template < class T >
+struct soa_reorder<mapped_column<T>>
+{
+   template < class Int >
+   void operator()(mapped_column<T>& data, const soa_permutation<Int>& perm)
+   {
+      soa_permute_in_place(data, perm);
+   }
+
+   template < class ExecutionPolicy, class Int >
+   void operator()(mapped_column<T>& data, ExecutionPolicy&& policy, const soa_permutation<Int>& perm)
+   {
+      std::unique_ptr<T[]> scattered(new T[perm.n]);
+      T* src = data.data();
+      parallel_for(policy, 0, perm.n, [&](size_t begin, size_t end)
+      {
+         for(size_t i = begin; i < end; ++i) scattered[perm[i]] = src[i];
+      });
+      parallel_for(policy, 0, perm.n, [&](size_t begin, size_t end)
+      {
+         std::copy(scattered.get() + begin, scattered.get() + end, src + begin);
+      });
+   }
+};
+
+// SOA gather handler, gathers into scratch memory so the column keeps its mapping
+template < class T >
+struct soa_gather<mapped_column<T>>
+{
+   template < class ExecutionPolicy >
+   void operator()(mapped_column<T>& data, ExecutionPolicy&& policy, const std::vector<size_t>& src)
+   {
+      std::unique_ptr<T[]> gathered(new T[src.size()]);
+      const T* in = data.data();
+      parallel_for(policy, 0, src.size(), [&](size_t begin, size_t end)
+      {
+         for(size_t j = begin; j < end; ++j) gathered[j] = in[src[j]];
+      });
+      data.resize(src.size());
+      T* out = data.data();
+      parallel_for(policy, 0, src.size(), [&](size_t begin, size_t end)
+      {
+         std::copy(gathered.get() + begin, gathered.get() + end, out + begin);
+      });
+   }
+};
+
+} // namespace detail
+} // namespace xlib
@@ -0,0 +1,368 @@
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <numeric>
+#include <utility>
+
+namespace xlib
+{
+
+template < class T, size_t Rank >
+template < class... Index >
+T& nd_ref<T,Rank>::operator()(Index... index) const
+{
+   static_assert(sizeof...(Index) == Rank, "nd_ref requires one index per extent");
+   const size_t idx[] = {static_cast<size_t>(index)...};
+   size_t j = 0;
+   for(size_t d = 0; d < Rank; ++d)
+   {
+      _XLIB_ASSERT(RANGE, 0, _extents[d], idx[d]);
+      j = j * _extents[d] + idx[d];
+   }
+   return _p[j * _stride];
+}
+
+template < class T, size_t Rank >
+size_t nd_ref<T,Rank>::size() const noexcept
+{
+   return std::accumulate(_extents.begin(), _extents.end(), size_t(1), std::multiplies<size_t>());
+}
+
+template < class T, size_t Rank >
+typename nd_ref<T,Rank>::value_type nd_ref<T,Rank>::load() const
+{
+   value_type v(this->size());
+   for(size_t j = 0; j < v.size(); ++j) v[j] = _p[j * _stride];
+   return v;
+}
+
+template < class T, size_t Rank >
+const nd_ref<T,Rank>& nd_ref<T,Rank>::operator=(const value_type& v) const
+{
+   assert(v.size() == this->size());
+   for(size_t j = 0; j < v.size(); ++j) _p[j * _stride] = v[j];
+   return *this;
+}
+
+template < class T, size_t Rank >
+const nd_ref<T,Rank>& nd_ref<T,Rank>::operator=(const nd_ref& rhs) const
+{
+   this->assign(rhs);
+   return *this;
+}
+
+template < class T, size_t Rank >
+template < class U >
+const nd_ref<T,Rank>& nd_ref<T,Rank>::operator=(const nd_ref<U,Rank>& rhs) const
+{
+   this->assign(rhs);
+   return *this;
+}
+
+template < class T, size_t Rank >
+template < class U >
+void nd_ref<T,Rank>::assign(const nd_ref<U,Rank>& rhs) const
+{
+   size_t n = this->size();
+   assert(rhs.size() == n);
+   if(_stride == 1 && rhs._stride == 1)
+   {
+      std::copy_n(rhs._p, n, _p);
+   }
+   else
+   {
+      for(size_t j = 0; j < n; ++j) _p[j * _stride] = rhs._p[j * rhs._stride];
+   }
+}
+
+template < class T, size_t Rank >
+void nd_ref<T,Rank>::fill(std::remove_const_t<T> value) const
+{
+   size_t n = this->size();
+   for(size_t j = 0; j < n; ++j) _p[j * _stride] = value;
+}
+
+template < class T, size_t Rank, nd_layout Layout >
+nd_array<T,Rank,Layout>::nd_array(const extents_type& extents, size_t n)
+{
+   this->set_extents(extents);
+   this->resize(n);
+}
+
+template < class T, size_t Rank, nd_layout Layout >
+nd_array<T,Rank,Layout>::nd_array(const nd_array& other):
+   _width(other._width),
+   _extents(other._extents)
+{
+   this->reallocate(round_capacity(other._size));
+   _size = other._size;
+   if constexpr(Layout == nd_layout::row_major)
+   {
+      if(_size) std::memcpy(_data, other._data, _size * _width * sizeof(T));
+   }
+   else
+   {
+      for(size_t j = 0; j < _width; ++j)
+      {
+         if(_size) std::memcpy(this->plane(j), other.plane(j), _size * sizeof(T));
+      }
+   }
+}
+
+template < class T, size_t Rank, nd_layout Layout >
+nd_array<T,Rank,Layout>::nd_array(nd_array&& other) noexcept
+{
+   this->swap(other);
+}
+
+template < class T, size_t Rank, nd_layout Layout >
+nd_array<T,Rank,Layout>& nd_array<T,Rank,Layout>::operator=(const nd_array& other)
+{
+   nd_array copy(other);
+   this->swap(copy);
+   return *this;
+}
+
+template < class T, size_t Rank, nd_layout Layout >
+nd_array<T,Rank,Layout>& nd_array<T,Rank,Layout>::operator=(nd_array&& other) noexcept
+{
+   this->swap(other);
+   return *this;
+}
+
+template < class T, size_t Rank, nd_layout Layout >
+nd_array<T,Rank,Layout>::~nd_array()
+{
+   _size = 0;
+   this->reallocate(0);
+}
+
+template < class T, size_t Rank, nd_layout Layout >
+typename nd_array<T,Rank,Layout>::reference nd_array<T,Rank,Layout>::operator[](size_t i) noexcept
+{
+   assert(i < _size);
+   return reference(_data + this->offset(i, 0), this->stride(), _extents);
+}
+
+template < class T, size_t Rank, nd_layout Layout >
+typename nd_array<T,Rank,Layout>::const_reference nd_array<T,Rank,Layout>::operator[](size_t i) const noexcept
+{
+   assert(i < _size);
+   return const_reference(_data + this->offset(i, 0), this->stride(), _extents);
+}
+
+template < class T, size_t Rank, nd_layout Layout >
+T* nd_array<T,Rank,Layout>::plane(size_t j) noexcept
+{
+   static_assert(Layout == nd_layout::column_major, "only column_major nd_arrays store components in planes");
+   return _data + j * _capacity;
+}
+
+template < class T, size_t Rank, nd_layout Layout >
+const T* nd_array<T,Rank,Layout>::plane(size_t j) const noexcept
+{
+   static_assert(Layout == nd_layout::column_major, "only column_major nd_arrays store components in planes");
+   return _data + j * _capacity;
+}
+
+template < class T, size_t Rank, nd_layout Layout >
+void nd_array<T,Rank,Layout>::set_extents(const extents_type& extents)
+{
+   assert(_size == 0 && "nd_array extents can only be set while the array is empty");
+   this->reallocate(0);
+   _extents = extents;
+   _width = std::accumulate(extents.begin(), extents.end(), size_t(1), std::multiplies<size_t>());
+}
+
+template < class T, size_t Rank, nd_layout Layout >
+void nd_array<T,Rank,Layout>::resize(size_t n)
+{
+   if(n > _capacity)
+   {
+      this->reallocate(round_capacity(detail::soa_grow_capacity(_capacity, n)));
+   }
+   if(n > _size)
+   {
+      if constexpr(Layout == nd_layout::row_major)
+      {
+         std::fill(_data + _size * _width, _data + n * _width, T());
+      }
+      else
+      {
+         for(size_t j = 0; j < _width; ++j) std::fill(this->plane(j) + _size, this->plane(j) + n, T());
+      }
+   }
+   _size = n;
+}
+
+template < class T, size_t Rank, nd_layout Layout >
+void nd_array<T,Rank,Layout>::resize(size_t n, const value_type& value)
+{
+   assert(value.size() == _width);
+   size_t old_size = _size;
+   if(n > _capacity)
+   {
+      this->reallocate(round_capacity(detail::soa_grow_capacity(_capacity, n)));
+   }
+   _size = n;
+   if(n <= old_size) return;
+   if constexpr(Layout == nd_layout::row_major)
+   {
+      for(size_t i = old_size; i < n; ++i) std::copy(value.begin(), value.end(), _data + i * _width);
+   }
+   else
+   {
+      for(size_t j = 0; j < _width; ++j) std::fill(this->plane(j) + old_size, this->plane(j) + n, value[j]);
+   }
+}
+
+template < class T, size_t Rank, nd_layout Layout >
+void nd_array<T,Rank,Layout>::reserve(size_t n)
+{
+   if(n > _capacity) this->reallocate(round_capacity(n));
+}
+
+template < class T, size_t Rank, nd_layout Layout >
+void nd_array<T,Rank,Layout>::shrink_to_fit()
+{
+   size_t capacity = round_capacity(_size);
+   if(capacity < _capacity) this->reallocate(capacity);
+}
+
+template < class T, size_t Rank, nd_layout Layout >
+void nd_array<T,Rank,Layout>::swap(nd_array& other) noexcept
+{
+   std::swap(_data, other._data);
+   std::swap(_size, other._size);
+   std::swap(_capacity, other._capacity);
+   std::swap(_width, other._width);
+   std::swap(_extents, other._extents);
+}
+
+template < class T, size_t Rank, nd_layout Layout >
+size_t nd_array<T,Rank,Layout>::offset(size_t i, size_t j) const noexcept
+{
+   if constexpr(Layout == nd_layout::row_major)
+   {
+      return i * _width + j;
+   }
+   else
+   {
+      return j * _capacity + i;
+   }
+}
+
+template < class T, size_t Rank, nd_layout Layout >
+size_t nd_array<T,Rank,Layout>::round_capacity(size_t n) noexcept
+{
+   // Planes start on an soa_alignment boundary
+   constexpr size_t multiple = Layout == nd_layout::row_major ? 1 : std::max<size_t>(1, soa_alignment_v<T> / sizeof(T));
+   return (n + multiple - 1) / multiple * multiple;
+}
+
+template < class T, size_t Rank, nd_layout Layout >
+void nd_array<T,Rank,Layout>::reallocate(size_t capacity)
+{
+   constexpr std::align_val_t alignment{soa_alignment_v<T>};
+   assert(capacity >= _size);
+
+   T* data = nullptr;
+   if(capacity > 0 && _width > 0)
+   {
+      data = static_cast<T*>(::operator new(_width * capacity * sizeof(T), alignment));
+      if(_size)
+      {
+         if constexpr(Layout == nd_layout::row_major)
+         {
+            std::memcpy(data, _data, _size * _width * sizeof(T));
+         }
+         else
+         {
+            for(size_t j = 0; j < _width; ++j) std::memcpy(data + j * capacity, _data + j * _capacity, _size * sizeof(T));
+         }
+      }
+   }
+   if(_data) ::operator delete(_data, alignment);
+   _data = data;
+   _capacity = capacity;
+}
+
+namespace detail
+{
+
+/** An nd_array of n value initialized elements with the extents of another
+ */
+template < class T, size_t Rank, nd_layout Layout >
+nd_array<T,Rank,Layout> nd_array_like(const nd_array<T,Rank,Layout>& other, size_t n)
+{
+   nd_array<T,Rank,Layout> a(other.extents());
+   a.reserve(n);
+   a.resize(n);
+   return a;
+}
+
+// SOA reorder handler, row_major arrays carry one element along each cycle,
+// column_major arrays permute one plane at a time
+template < class T, size_t Rank, nd_layout Layout >
+struct soa_reorder<nd_array<T,Rank,Layout>>
+{
+   template < class Int >
+   void operator()(nd_array<T,Rank,Layout>& data, const soa_permutation<Int>& perm)
+   {
+      if constexpr(Layout == nd_layout::row_major)
+      {
+         size_t width = data.width();
+         std::vector<T> carry(width), next(width);
+         for(size_t s: perm.cycle_leaders)
+         {
+            std::copy_n(&data.component(s, 0), width, carry.data());
+            for(size_t j = perm[s]; j != s; j = perm[j])
+            {
+               std::copy_n(&data.component(j, 0), width, next.data());
+               std::copy_n(carry.data(), width, &data.component(j, 0));
+               std::swap(carry, next);
+            }
+            std::copy_n(carry.data(), width, &data.component(s, 0));
+         }
+      }
+      else
+      {
+         for(size_t j = 0; j < data.width(); ++j)
+         {
+            T* plane = data.plane(j);
+            soa_permute_in_place(plane, perm);
+         }
+      }
+   }
+
+   template < class ExecutionPolicy, class Int >
+   void operator()(nd_array<T,Rank,Layout>& data, ExecutionPolicy&& policy, const soa_permutation<Int>& perm)
+   {
+      nd_array<T,Rank,Layout> scattered = nd_array_like(data, perm.n);
+      parallel_for(policy, 0, perm.n, [&](size_t begin, size_t end)
+      {
+         for(size_t i = begin; i < end; ++i) scattered[perm[i]] = data[i];
+      });
+      data.swap(scattered);
+   }
+};
+
+// SOA gather handler, keeps the extents of the array
+template < class T, size_t Rank, nd_layout Layout >
+struct soa_gather<nd_array<T,Rank,Layout>>
+{
+   template < class ExecutionPolicy >
+   void operator()(nd_array<T,Rank,Layout>& data, ExecutionPolicy&& policy, const std::vector<size_t>& src)
+   {
+      nd_array<T,Rank,Layout> gathered = nd_array_like(data, src.size());
+      parallel_for(policy, 0, src.size(), [&](size_t begin, size_t end)
+      {
+         for(size_t j = begin; j < end; ++j) gathered[j] = data[src[j]];
+      });
+      data.swap(gathered);
+   }
+};
+
+} // namespace detail
+} // namespace xlib
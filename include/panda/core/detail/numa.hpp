@@ -0,0 +1,57 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
+
+namespace xlib
+{
+namespace detail
+{
+
+/** Pages sampled per chunk to find the node it is placed on
+ */
+constexpr size_t numa_sampled_pages = 64;
+
+/** Node most of the sampled pages of [data, data + bytes) are placed on
+ */
+int numa_majority_node(const char* data, size_t bytes);
+
+} // namespace detail
+
+template < class ExecutionPolicy, class T >
+std::vector<numa_partition> numa_partitions(ExecutionPolicy&& policy, const T* data, size_t n)
+{
+   using policy_t = std::remove_cv_t<std::remove_reference_t<ExecutionPolicy>>;
+   static_assert(execution::is_execution_policy_v<policy_t>, "numa_partitions requires an xlib execution policy");
+
+   std::vector<numa_partition> partitions;
+   if(n == 0) return partitions;
+
+   auto add = [&](size_t begin, size_t end, size_t thread)
+   {
+      const char* bytes = reinterpret_cast<const char*>(data + begin);
+      partitions.push_back(numa_partition{begin, end, thread,
+         detail::numa_majority_node(bytes, (end - begin) * sizeof(T))});
+   };
+
+   if constexpr(std::is_same_v<policy_t, execution::sequenced_policy>)
+   {
+      add(0, n, 0);
+   }
+   else
+   {
+      detail::chunk_layout layout = detail::make_chunk_layout(policy, n);
+      bool deterministic = policy.sched == execution::schedule::deterministic || layout.num_threads == 1;
+      partitions.reserve(layout.num_chunks);
+      for(size_t k = 0; k < layout.num_chunks; ++k)
+      {
+         size_t begin = k * layout.chunk_size;
+         add(begin, std::min(n, begin + layout.chunk_size),
+            deterministic ? k % layout.num_threads : numa_partition::any_thread);
+      }
+   }
+   return partitions;
+}
+
+} // namespace xlib
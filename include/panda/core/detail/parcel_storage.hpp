@@ -0,0 +1,274 @@
+#include <type_traits>
+#include <utility>
+
+namespace xlib
+{
+namespace detail
+{
+
+/** Element i of a column with the constness of the parcel storage, raw
+ * pointer columns hand out const references
+ */
+template < class T >
+const T& parcel_element(T* const& data, size_t i) noexcept
+{
+   return data[i];
+}
+
+template < class Column >
+decltype(auto) parcel_element(const Column& data, size_t i)
+{
+   return data[i];
+}
+
+} // namespace detail
+} // namespace xlib
+
+// Preprocessor helpers, lists hold up to 64 elements
+
+#define XLIB_PP_CAT(a, b) XLIB_PP_CAT_I(a, b)
+#define XLIB_PP_CAT_I(a, b) a##b
+#define XLIB_PP_EXPAND(...) __VA_ARGS__
+#define XLIB_PP_UNPAREN(x) XLIB_PP_EXPAND x
+
+/** Call M(D, x) for every element x of the list
+ */
+#define XLIB_PP_FOR_EACH(M, D, ...) XLIB_PP_CAT(XLIB_PP_FOR_EACH_, XLIB_PP_COUNT(__VA_ARGS__))(M, D, __VA_ARGS__)
+
+/** Comma separated M(x) for every element x of the list
+ */
+#define XLIB_PP_LIST(M, ...) XLIB_PP_CAT(XLIB_PP_LIST_, XLIB_PP_COUNT(__VA_ARGS__))(M, __VA_ARGS__)
+
+#define XLIB_PP_COUNT(...) XLIB_PP_COUNT_I(__VA_ARGS__, 64, 63, 62, 61, 60, 59, 58, 57, 56, 55, 54, 53, 52, 51, 50, 49, 48, 47, 46, 45, 44, 43, 42, 41, 40, 39, 38, 37, 36, 35, 34, 33, 32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17, 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define XLIB_PP_COUNT_I(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, _17, _18, _19, _20, _21, _22, _23, _24, _25, _26, _27, _28, _29, _30, _31, _32, _33, _34, _35, _36, _37, _38, _39, _40, _41, _42, _43, _44, _45, _46, _47, _48, _49, _50, _51, _52, _53, _54, _55, _56, _57, _58, _59, _60, _61, _62, _63, _64, N, ...) N
+
+#define XLIB_PP_FOR_EACH_1(M, D, x) M(D, x)
+#define XLIB_PP_FOR_EACH_2(M, D, x, ...) M(D, x) XLIB_PP_FOR_EACH_1(M, D, __VA_ARGS__)
+#define XLIB_PP_FOR_EACH_3(M, D, x, ...) M(D, x) XLIB_PP_FOR_EACH_2(M, D, __VA_ARGS__)
+#define XLIB_PP_FOR_EACH_4(M, D, x, ...) M(D, x) XLIB_PP_FOR_EACH_3(M, D, __VA_ARGS__)
+#define XLIB_PP_FOR_EACH_5(M, D, x, ...) M(D, x) XLIB_PP_FOR_EACH_4(M, D, __VA_ARGS__)
+#define XLIB_PP_FOR_EACH_6(M, D, x, ...) M(D, x) XLIB_PP_FOR_EACH_5(M, D, __VA_ARGS__)
+#define XLIB_PP_FOR_EACH_7(M, D, x, ...) M(D, x) XLIB_PP_FOR_EACH_6(M, D, __VA_ARGS__)
+#define XLIB_PP_FOR_EACH_8(M, D, x, ...) M(D, x) XLIB_PP_FOR_EACH_7(M, D, __VA_ARGS__)
+#define XLIB_PP_FOR_EACH_9(M, D, x, ...) M(D, x) XLIB_PP_FOR_EACH_8(M, D, __VA_ARGS__)
+#define XLIB_PP_FOR_EACH_10(M, D, x, ...) M(D, x) XLIB_PP_FOR_EACH_9(M, D, __VA_ARGS__)
+#define XLIB_PP_FOR_EACH_11(M, D, x, ...) M(D, x) XLIB_PP_FOR_EACH_10(M, D, __VA_ARGS__)
+#define XLIB_PP_FOR_EACH_12(M, D, x, ...) M(D, x) XLIB_PP_FOR_EACH_11(M, D, __VA_ARGS__)
+#define XLIB_PP_FOR_EACH_13(M, D, x, ...) M(D, x) XLIB_PP_FOR_EACH_12(M, D, __VA_ARGS__)
+#define XLIB_PP_FOR_EACH_14(M, D, x, ...) M(D, x) XLIB_PP_FOR_EACH_13(M, D, __VA_ARGS__)
+#define XLIB_PP_FOR_EACH_15(M, D, x, ...) M(D, x) XLIB_PP_FOR_EACH_14(M, D, __VA_ARGS__)
+#define XLIB_PP_FOR_EACH_16(M, D, x, ...) M(D, x) XLIB_PP_FOR_EACH_15(M, D, __VA_ARGS__)
+#define XLIB_PP_FOR_EACH_17(M, D, x, ...) M(D, x) XLIB_PP_FOR_EACH_16(M, D, __VA_ARGS__)
+#define XLIB_PP_FOR_EACH_18(M, D, x, ...) M(D, x) XLIB_PP_FOR_EACH_17(M, D, __VA_ARGS__)
+#define XLIB_PP_FOR_EACH_19(M, D, x, ...) M(D, x) XLIB_PP_FOR_EACH_18(M, D, __VA_ARGS__)
+#define XLIB_PP_FOR_EACH_20(M, D, x, ...) M(D, x) XLIB_PP_FOR_EACH_19(M, D, __VA_ARGS__)
+#define XLIB_PP_FOR_EACH_21(M, D, x, ...) M(D, x) XLIB_PP_FOR_EACH_20(M, D, __VA_ARGS__)
+#define XLIB_PP_FOR_EACH_22(M, D, x, ...) M(D, x) XLIB_PP_FOR_EACH_21(M, D, __VA_ARGS__)
+#define XLIB_PP_FOR_EACH_23(M, D, x, ...) M(D, x) XLIB_PP_FOR_EACH_22(M, D, __VA_ARGS__)
+#define XLIB_PP_FOR_EACH_24(M, D, x, ...) M(D, x) XLIB_PP_FOR_EACH_23(M, D, __VA_ARGS__)
+#define XLIB_PP_FOR_EACH_25(M, D, x, ...) M(D, x) XLIB_PP_FOR_EACH_24(M, D, __VA_ARGS__)
+#define XLIB_PP_FOR_EACH_26(M, D, x, ...) M(D, x) XLIB_PP_FOR_EACH_25(M, D, __VA_ARGS__)
+#define XLIB_PP_FOR_EACH_27(M, D, x, ...) M(D, x) XLIB_PP_FOR_EACH_26(M, D, __VA_ARGS__)
+#define XLIB_PP_FOR_EACH_28(M, D, x, ...) M(D, x) XLIB_PP_FOR_EACH_27(M, D, __VA_ARGS__)
+#define XLIB_PP_FOR_EACH_29(M, D, x, ...) M(D, x) XLIB_PP_FOR_EACH_28(M, D, __VA_ARGS__)
+#define XLIB_PP_FOR_EACH_30(M, D, x, ...) M(D, x) XLIB_PP_FOR_EACH_29(M, D, __VA_ARGS__)
+#define XLIB_PP_FOR_EACH_31(M, D, x, ...) M(D, x) XLIB_PP_FOR_EACH_30(M, D, __VA_ARGS__)
+#define XLIB_PP_FOR_EACH_32(M, D, x, ...) M(D, x) XLIB_PP_FOR_EACH_31(M, D, __VA_ARGS__)
+#define XLIB_PP_FOR_EACH_33(M, D, x, ...) M(D, x) XLIB_PP_FOR_EACH_32(M, D, __VA_ARGS__)
+#define XLIB_PP_FOR_EACH_34(M, D, x, ...) M(D, x) XLIB_PP_FOR_EACH_33(M, D, __VA_ARGS__)
+#define XLIB_PP_FOR_EACH_35(M, D, x, ...) M(D, x) XLIB_PP_FOR_EACH_34(M, D, __VA_ARGS__)
+#define XLIB_PP_FOR_EACH_36(M, D, x, ...) M(D, x) XLIB_PP_FOR_EACH_35(M, D, __VA_ARGS__)
+#define XLIB_PP_FOR_EACH_37(M, D, x, ...) M(D, x) XLIB_PP_FOR_EACH_36(M, D, __VA_ARGS__)
+#define XLIB_PP_FOR_EACH_38(M, D, x, ...) M(D, x) XLIB_PP_FOR_EACH_37(M, D, __VA_ARGS__)
+#define XLIB_PP_FOR_EACH_39(M, D, x, ...) M(D, x) XLIB_PP_FOR_EACH_38(M, D, __VA_ARGS__)
+#define XLIB_PP_FOR_EACH_40(M, D, x, ...) M(D, x) XLIB_PP_FOR_EACH_39(M, D, __VA_ARGS__)
+#define XLIB_PP_FOR_EACH_41(M, D, x, ...) M(D, x) XLIB_PP_FOR_EACH_40(M, D, __VA_ARGS__)
+#define XLIB_PP_FOR_EACH_42(M, D, x, ...) M(D, x) XLIB_PP_FOR_EACH_41(M, D, __VA_ARGS__)
+#define XLIB_PP_FOR_EACH_43(M, D, x, ...) M(D, x) XLIB_PP_FOR_EACH_42(M, D, __VA_ARGS__)
+#define XLIB_PP_FOR_EACH_44(M, D, x, ...) M(D, x) XLIB_PP_FOR_EACH_43(M, D, __VA_ARGS__)
+#define XLIB_PP_FOR_EACH_45(M, D, x, ...) M(D, x) XLIB_PP_FOR_EACH_44(M, D, __VA_ARGS__)
+#define XLIB_PP_FOR_EACH_46(M, D, x, ...) M(D, x) XLIB_PP_FOR_EACH_45(M, D, __VA_ARGS__)
+#define XLIB_PP_FOR_EACH_47(M, D, x, ...) M(D, x) XLIB_PP_FOR_EACH_46(M, D, __VA_ARGS__)
+#define XLIB_PP_FOR_EACH_48(M, D, x, ...) M(D, x) XLIB_PP_FOR_EACH_47(M, D, __VA_ARGS__)
+#define XLIB_PP_FOR_EACH_49(M, D, x, ...) M(D, x) XLIB_PP_FOR_EACH_48(M, D, __VA_ARGS__)
+#define XLIB_PP_FOR_EACH_50(M, D, x, ...) M(D, x) XLIB_PP_FOR_EACH_49(M, D, __VA_ARGS__)
+#define XLIB_PP_FOR_EACH_51(M, D, x, ...) M(D, x) XLIB_PP_FOR_EACH_50(M, D, __VA_ARGS__)
+#define XLIB_PP_FOR_EACH_52(M, D, x, ...) M(D, x) XLIB_PP_FOR_EACH_51(M, D, __VA_ARGS__)
+#define XLIB_PP_FOR_EACH_53(M, D, x, ...) M(D, x) XLIB_PP_FOR_EACH_52(M, D, __VA_ARGS__)
+#define XLIB_PP_FOR_EACH_54(M, D, x, ...) M(D, x) XLIB_PP_FOR_EACH_53(M, D, __VA_ARGS__)
+#define XLIB_PP_FOR_EACH_55(M, D, x, ...) M(D, x) XLIB_PP_FOR_EACH_54(M, D, __VA_ARGS__)
+#define XLIB_PP_FOR_EACH_56(M, D, x, ...) M(D, x) XLIB_PP_FOR_EACH_55(M, D, __VA_ARGS__)
+#define XLIB_PP_FOR_EACH_57(M, D, x, ...) M(D, x) XLIB_PP_FOR_EACH_56(M, D, __VA_ARGS__)
+#define XLIB_PP_FOR_EACH_58(M, D, x, ...) M(D, x) XLIB_PP_FOR_EACH_57(M, D, __VA_ARGS__)
+#define XLIB_PP_FOR_EACH_59(M, D, x, ...) M(D, x) XLIB_PP_FOR_EACH_58(M, D, __VA_ARGS__)
+#define XLIB_PP_FOR_EACH_60(M, D, x, ...) M(D, x) XLIB_PP_FOR_EACH_59(M, D, __VA_ARGS__)
+#define XLIB_PP_FOR_EACH_61(M, D, x, ...) M(D, x) XLIB_PP_FOR_EACH_60(M, D, __VA_ARGS__)
+#define XLIB_PP_FOR_EACH_62(M, D, x, ...) M(D, x) XLIB_PP_FOR_EACH_61(M, D, __VA_ARGS__)
+#define XLIB_PP_FOR_EACH_63(M, D, x, ...) M(D, x) XLIB_PP_FOR_EACH_62(M, D, __VA_ARGS__)
+#define XLIB_PP_FOR_EACH_64(M, D, x, ...) M(D, x) XLIB_PP_FOR_EACH_63(M, D, __VA_ARGS__)
+
+#define XLIB_PP_LIST_1(M, x) M(x)
+#define XLIB_PP_LIST_2(M, x, ...) M(x), XLIB_PP_LIST_1(M, __VA_ARGS__)
+#define XLIB_PP_LIST_3(M, x, ...) M(x), XLIB_PP_LIST_2(M, __VA_ARGS__)
+#define XLIB_PP_LIST_4(M, x, ...) M(x), XLIB_PP_LIST_3(M, __VA_ARGS__)
+#define XLIB_PP_LIST_5(M, x, ...) M(x), XLIB_PP_LIST_4(M, __VA_ARGS__)
+#define XLIB_PP_LIST_6(M, x, ...) M(x), XLIB_PP_LIST_5(M, __VA_ARGS__)
+#define XLIB_PP_LIST_7(M, x, ...) M(x), XLIB_PP_LIST_6(M, __VA_ARGS__)
+#define XLIB_PP_LIST_8(M, x, ...) M(x), XLIB_PP_LIST_7(M, __VA_ARGS__)
+#define XLIB_PP_LIST_9(M, x, ...) M(x), XLIB_PP_LIST_8(M, __VA_ARGS__)
+#define XLIB_PP_LIST_10(M, x, ...) M(x), XLIB_PP_LIST_9(M, __VA_ARGS__)
+#define XLIB_PP_LIST_11(M, x, ...) M(x), XLIB_PP_LIST_10(M, __VA_ARGS__)
+#define XLIB_PP_LIST_12(M, x, ...) M(x), XLIB_PP_LIST_11(M, __VA_ARGS__)
+#define XLIB_PP_LIST_13(M, x, ...) M(x), XLIB_PP_LIST_12(M, __VA_ARGS__)
+#define XLIB_PP_LIST_14(M, x, ...) M(x), XLIB_PP_LIST_13(M, __VA_ARGS__)
+#define XLIB_PP_LIST_15(M, x, ...) M(x), XLIB_PP_LIST_14(M, __VA_ARGS__)
+#define XLIB_PP_LIST_16(M, x, ...) M(x), XLIB_PP_LIST_15(M, __VA_ARGS__)
+#define XLIB_PP_LIST_17(M, x, ...) M(x), XLIB_PP_LIST_16(M, __VA_ARGS__)
+#define XLIB_PP_LIST_18(M, x, ...) M(x), XLIB_PP_LIST_17(M, __VA_ARGS__)
+#define XLIB_PP_LIST_19(M, x, ...) M(x), XLIB_PP_LIST_18(M, __VA_ARGS__)
+#define XLIB_PP_LIST_20(M, x, ...) M(x), XLIB_PP_LIST_19(M, __VA_ARGS__)
+#define XLIB_PP_LIST_21(M, x, ...) M(x), XLIB_PP_LIST_20(M, __VA_ARGS__)
+#define XLIB_PP_LIST_22(M, x, ...) M(x), XLIB_PP_LIST_21(M, __VA_ARGS__)
+#define XLIB_PP_LIST_23(M, x, ...) M(x), XLIB_PP_LIST_22(M, __VA_ARGS__)
+#define XLIB_PP_LIST_24(M, x, ...) M(x), XLIB_PP_LIST_23(M, __VA_ARGS__)
+#define XLIB_PP_LIST_25(M, x, ...) M(x), XLIB_PP_LIST_24(M, __VA_ARGS__)
+#define XLIB_PP_LIST_26(M, x, ...) M(x), XLIB_PP_LIST_25(M, __VA_ARGS__)
+#define XLIB_PP_LIST_27(M, x, ...) M(x), XLIB_PP_LIST_26(M, __VA_ARGS__)
+#define XLIB_PP_LIST_28(M, x, ...) M(x), XLIB_PP_LIST_27(M, __VA_ARGS__)
+#define XLIB_PP_LIST_29(M, x, ...) M(x), XLIB_PP_LIST_28(M, __VA_ARGS__)
+#define XLIB_PP_LIST_30(M, x, ...) M(x), XLIB_PP_LIST_29(M, __VA_ARGS__)
+#define XLIB_PP_LIST_31(M, x, ...) M(x), XLIB_PP_LIST_30(M, __VA_ARGS__)
+#define XLIB_PP_LIST_32(M, x, ...) M(x), XLIB_PP_LIST_31(M, __VA_ARGS__)
+#define XLIB_PP_LIST_33(M, x, ...) M(x), XLIB_PP_LIST_32(M, __VA_ARGS__)
+#define XLIB_PP_LIST_34(M, x, ...) M(x), XLIB_PP_LIST_33(M, __VA_ARGS__)
+#define XLIB_PP_LIST_35(M, x, ...) M(x), XLIB_PP_LIST_34(M, __VA_ARGS__)
+#define XLIB_PP_LIST_36(M, x, ...) M(x), XLIB_PP_LIST_35(M, __VA_ARGS__)
+#define XLIB_PP_LIST_37(M, x, ...) M(x), XLIB_PP_LIST_36(M, __VA_ARGS__)
+#define XLIB_PP_LIST_38(M, x, ...) M(x), XLIB_PP_LIST_37(M, __VA_ARGS__)
+#define XLIB_PP_LIST_39(M, x, ...) M(x), XLIB_PP_LIST_38(M, __VA_ARGS__)
+#define XLIB_PP_LIST_40(M, x, ...) M(x), XLIB_PP_LIST_39(M, __VA_ARGS__)
+#define XLIB_PP_LIST_41(M, x, ...) M(x), XLIB_PP_LIST_40(M, __VA_ARGS__)
+#define XLIB_PP_LIST_42(M, x, ...) M(x), XLIB_PP_LIST_41(M, __VA_ARGS__)
+#define XLIB_PP_LIST_43(M, x, ...) M(x), XLIB_PP_LIST_42(M, __VA_ARGS__)
+#define XLIB_PP_LIST_44(M, x, ...) M(x), XLIB_PP_LIST_43(M, __VA_ARGS__)
+#define XLIB_PP_LIST_45(M, x, ...) M(x), XLIB_PP_LIST_44(M, __VA_ARGS__)
+#define XLIB_PP_LIST_46(M, x, ...) M(x), XLIB_PP_LIST_45(M, __VA_ARGS__)
+#define XLIB_PP_LIST_47(M, x, ...) M(x), XLIB_PP_LIST_46(M, __VA_ARGS__)
+#define XLIB_PP_LIST_48(M, x, ...) M(x), XLIB_PP_LIST_47(M, __VA_ARGS__)
+#define XLIB_PP_LIST_49(M, x, ...) M(x), XLIB_PP_LIST_48(M, __VA_ARGS__)
+#define XLIB_PP_LIST_50(M, x, ...) M(x), XLIB_PP_LIST_49(M, __VA_ARGS__)
+#define XLIB_PP_LIST_51(M, x, ...) M(x), XLIB_PP_LIST_50(M, __VA_ARGS__)
+#define XLIB_PP_LIST_52(M, x, ...) M(x), XLIB_PP_LIST_51(M, __VA_ARGS__)
+#define XLIB_PP_LIST_53(M, x, ...) M(x), XLIB_PP_LIST_52(M, __VA_ARGS__)
+#define XLIB_PP_LIST_54(M, x, ...) M(x), XLIB_PP_LIST_53(M, __VA_ARGS__)
+#define XLIB_PP_LIST_55(M, x, ...) M(x), XLIB_PP_LIST_54(M, __VA_ARGS__)
+#define XLIB_PP_LIST_56(M, x, ...) M(x), XLIB_PP_LIST_55(M, __VA_ARGS__)
+#define XLIB_PP_LIST_57(M, x, ...) M(x), XLIB_PP_LIST_56(M, __VA_ARGS__)
+#define XLIB_PP_LIST_58(M, x, ...) M(x), XLIB_PP_LIST_57(M, __VA_ARGS__)
+#define XLIB_PP_LIST_59(M, x, ...) M(x), XLIB_PP_LIST_58(M, __VA_ARGS__)
+#define XLIB_PP_LIST_60(M, x, ...) M(x), XLIB_PP_LIST_59(M, __VA_ARGS__)
+#define XLIB_PP_LIST_61(M, x, ...) M(x), XLIB_PP_LIST_60(M, __VA_ARGS__)
+#define XLIB_PP_LIST_62(M, x, ...) M(x), XLIB_PP_LIST_61(M, __VA_ARGS__)
+#define XLIB_PP_LIST_63(M, x, ...) M(x), XLIB_PP_LIST_62(M, __VA_ARGS__)
+#define XLIB_PP_LIST_64(M, x, ...) M(x), XLIB_PP_LIST_63(M, __VA_ARGS__)
+
+// Pieces of a parcel field (name, type...) and of a member (name, init, type...)
+
+#define XLIB_PARCEL_FIELD_NAME_I(NAME, ...) NAME
+#define XLIB_PARCEL_FIELD_TYPE_I(NAME, ...) __VA_ARGS__
+#define XLIB_PARCEL_FIELD_TYPE(FIELD) XLIB_PARCEL_FIELD_TYPE_I FIELD
+
+#define XLIB_PARCEL_FIELD_ENUM(D, FIELD) XLIB_PARCEL_FIELD_NAME_I FIELD,
+#define XLIB_PARCEL_FIELD_STRING(D, FIELD) XLIB_PARCEL_FIELD_STRING_I(XLIB_PARCEL_FIELD_NAME_I FIELD)
+#define XLIB_PARCEL_FIELD_STRING_I(NAME) XLIB_PARCEL_FIELD_STRING_II(NAME)
+#define XLIB_PARCEL_FIELD_STRING_II(NAME) #NAME,
+#define XLIB_PARCEL_FIELD_VISIT(D, FIELD) XLIB_PARCEL_FIELD_VISIT_I(XLIB_PARCEL_FIELD_NAME_I FIELD)
+#define XLIB_PARCEL_FIELD_VISIT_I(NAME) XLIB_PARCEL_FIELD_VISIT_II(NAME)
+#define XLIB_PARCEL_FIELD_VISIT_II(NAME) f(#NAME, this->NAME());
+
+#define XLIB_PARCEL_FIELD_ACCESSORS(D, FIELD) XLIB_PARCEL_FIELD_ACCESSORS_I(XLIB_PARCEL_FIELD_NAME_I FIELD)
+#define XLIB_PARCEL_FIELD_ACCESSORS_I(NAME) XLIB_PARCEL_FIELD_ACCESSORS_II(NAME)
+#define XLIB_PARCEL_FIELD_ACCESSORS_II(NAME) \
+   storage_type::reference<static_cast<size_t>(field::NAME)> NAME() noexcept \
+   { \
+      return _data.get_data<static_cast<size_t>(field::NAME)>(); \
+   } \
+   storage_type::const_reference<static_cast<size_t>(field::NAME)> NAME() const noexcept \
+   { \
+      return _data.get_data<static_cast<size_t>(field::NAME)>(); \
+   } \
+   decltype(auto) NAME(size_t i) \
+   { \
+      return _data.get_data<static_cast<size_t>(field::NAME)>()[i]; \
+   } \
+   decltype(auto) NAME(size_t i) const \
+   { \
+      return ::xlib::detail::parcel_element(_data.get_data<static_cast<size_t>(field::NAME)>(), i); \
+   }
+
+#define XLIB_PARCEL_MEMBER_DECL(D, MEMBER) XLIB_PARCEL_MEMBER_DECL_I MEMBER
+#define XLIB_PARCEL_MEMBER_DECL_I(NAME, INIT, ...) __VA_ARGS__ NAME = INIT;
+#define XLIB_PARCEL_MEMBER_STRING(D, MEMBER) XLIB_PARCEL_MEMBER_STRING_I MEMBER
+#define XLIB_PARCEL_MEMBER_STRING_I(NAME, ...) #NAME,
+#define XLIB_PARCEL_MEMBER_VISIT(D, MEMBER) XLIB_PARCEL_MEMBER_VISIT_I MEMBER
+#define XLIB_PARCEL_MEMBER_VISIT_I(NAME, ...) f(#NAME, this->NAME);
+
+#define XLIB_PARCEL_STORAGE_2(TYPE, PDATA) XLIB_PARCEL_STORAGE_IMPL(TYPE, PDATA, , , 0)
+#define XLIB_PARCEL_STORAGE_3(TYPE, PDATA, MDATA) \
+   XLIB_PARCEL_STORAGE_IMPL(TYPE, PDATA, \
+      XLIB_PP_FOR_EACH(XLIB_PARCEL_MEMBER_DECL, ~, XLIB_PP_UNPAREN(MDATA)), \
+      XLIB_PP_FOR_EACH(XLIB_PARCEL_MEMBER_VISIT, ~, XLIB_PP_UNPAREN(MDATA)), \
+      XLIB_PP_COUNT(XLIB_PP_UNPAREN(MDATA)))
+
+#define XLIB_PARCEL_STORAGE_IMPL(TYPE, PDATA, MEMBER_DECLS, MEMBER_VISITS, NUM_MEMBERS) \
+struct TYPE \
+{ \
+   /** Index of every field in storage_type */ \
+   enum class field: size_t \
+   { \
+      XLIB_PP_FOR_EACH(XLIB_PARCEL_FIELD_ENUM, ~, XLIB_PP_UNPAREN(PDATA)) \
+   }; \
+   static constexpr size_t num_fields = XLIB_PP_COUNT(XLIB_PP_UNPAREN(PDATA)); \
+   static constexpr size_t num_members = NUM_MEMBERS; \
+   static constexpr const char* field_names[] = { XLIB_PP_FOR_EACH(XLIB_PARCEL_FIELD_STRING, ~, XLIB_PP_UNPAREN(PDATA)) }; \
+   static constexpr const char* type_name() noexcept { return #TYPE; } \
+ \
+   using storage_type = ::xlib::static_soa<XLIB_PP_LIST(XLIB_PARCEL_FIELD_TYPE, XLIB_PP_UNPAREN(PDATA))>; \
+ \
+   XLIB_PP_FOR_EACH(XLIB_PARCEL_FIELD_ACCESSORS, ~, XLIB_PP_UNPAREN(PDATA)) \
+ \
+   template < field F > \
+   storage_type::reference<static_cast<size_t>(F)> get() noexcept \
+   { \
+      return _data.get_data<static_cast<size_t>(F)>(); \
+   } \
+   template < field F > \
+   storage_type::const_reference<static_cast<size_t>(F)> get() const noexcept \
+   { \
+      return _data.get_data<static_cast<size_t>(F)>(); \
+   } \
+ \
+   storage_type& storage() noexcept { return _data; } \
+   const storage_type& storage() const noexcept { return _data; } \
+   size_t size() const noexcept { return _data.size(); } \
+   void resize(size_t n) { _data.resize(n); } \
+   void reserve(size_t n) { _data.reserve(n); } \
+ \
+   template < class F > \
+   void for_each_field(F&& f) \
+   { \
+      (void)f; \
+      XLIB_PP_FOR_EACH(XLIB_PARCEL_FIELD_VISIT, ~, XLIB_PP_UNPAREN(PDATA)) \
+   } \
+   template < class F > \
+   void for_each_member(F&& f) \
+   { \
+      (void)f; \
+      MEMBER_VISITS \
+   } \
+ \
+   MEMBER_DECLS \
+ \
+private: \
+   storage_type _data; \
+}
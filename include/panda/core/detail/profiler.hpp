@@ -0,0 +1,335 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <new>
+
+namespace xlib
+{
+namespace detail
+{
+
+inline thread_profile::thread_profile(size_t index):
+   thread_index(index)
+{
+   this->clear();
+}
+
+inline uint32_t thread_profile::enter(const char* name)
+{
+   uint32_t c = nodes[current].first_child;
+   while(c != npos && nodes[c].name != name)
+   {
+      c = nodes[c].next_sibling;
+   }
+   if(c == npos)
+   {
+      c = static_cast<uint32_t>(nodes.size());
+      nodes.push_back(profile_node{name, current, npos, nodes[current].first_child, 0, 0, 0});
+      nodes[current].first_child = c;
+   }
+   current = c;
+   return c;
+}
+
+inline void thread_profile::leave(uint32_t node, uint64_t begin, uint64_t end)
+{
+   profile_node& n = nodes[node];
+   uint64_t ticks = end - begin;
+   n.calls++;
+   n.inclusive += ticks;
+   nodes[n.parent].children += ticks;
+   current = n.parent;
+
+   if(profiler::instance().tracing())
+   {
+      bool recorded = false;
+      if(events.size() < profiler::instance().max_events())
+      {
+         // Called from a destructor, an event that can not be stored is
+         // dropped like one past max_events
+         try
+         {
+            events.push_back(profile_event{n.name, begin, end});
+            recorded = true;
+         }
+         catch(const std::bad_alloc&)
+         {
+         }
+      }
+      if(!recorded) dropped_events++;
+   }
+}
+
+inline void thread_profile::clear()
+{
+   nodes.assign(1, profile_node{"", npos, npos, npos, 0, 0, 0});
+   events.clear();
+   dropped_events = 0;
+   current = 0;
+}
+
+/** Call tree of all threads merged by region name
+ */
+struct merged_profile_node
+{
+   std::string name;
+   std::vector<size_t> children;
+   uint64_t calls = 0;
+   uint64_t inclusive = 0;
+   uint64_t child_ticks = 0;
+};
+
+} // namespace detail
+
+inline profiler& profiler::instance()
+{
+   static profiler p;
+   return p;
+}
+
+inline detail::thread_profile& profiler::local()
+{
+   static thread_local detail::thread_profile* profile = nullptr;
+   if(!profile)
+   {
+      profile = &instance().add_thread();
+   }
+   return *profile;
+}
+
+inline detail::thread_profile& profiler::add_thread()
+{
+   std::lock_guard<std::mutex> lk(_lock);
+   _threads.push_back(std::make_unique<detail::thread_profile>(_threads.size()));
+   return *_threads.back();
+}
+
+inline void profiler::enable(bool trace, size_t max_events_per_thread)
+{
+   std::lock_guard<std::mutex> lk(_lock);
+   _trace = trace;
+   _max_events = max_events_per_thread;
+   if(_start_ticks == 0)
+   {
+      _start_time = std::chrono::steady_clock::now();
+      _start_ticks = tsc_clock::now();
+   }
+   _enabled.store(true, std::memory_order_release);
+}
+
+inline void profiler::disable() noexcept
+{
+   _enabled.store(false, std::memory_order_release);
+}
+
+inline void profiler::reset()
+{
+   std::lock_guard<std::mutex> lk(_lock);
+   for(auto& t: _threads)
+   {
+      t->clear();
+   }
+   _start_time = std::chrono::steady_clock::now();
+   _start_ticks = tsc_clock::now();
+}
+
+inline double profiler::seconds_per_tick() const
+{
+   if constexpr(tsc_clock::is_tsc)
+   {
+      // Calibrate over everything since the profiler started, falls back to
+      // a short calibration for windows too short to be accurate
+      double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - _start_time).count();
+      uint64_t ticks = tsc_clock::now() - _start_ticks;
+      if(_start_ticks == 0 || seconds < 1e-2 || ticks == 0) return tsc_clock::seconds_per_tick();
+      return seconds / double(ticks);
+   }
+   else
+   {
+      return tsc_clock::seconds_per_tick();
+   }
+}
+
+inline std::vector<profiler::region_stats> profiler::stats() const
+{
+   using detail::merged_profile_node;
+   using detail::thread_profile;
+   std::lock_guard<std::mutex> lk(_lock);
+   double spt = this->seconds_per_tick();
+
+   // Merge the call trees of all threads by name
+   std::vector<merged_profile_node> merged(1);
+   std::vector<std::pair<std::string, std::vector<uint64_t>>> per_thread;
+   auto thread_totals = [&](const std::string& name) -> std::vector<uint64_t>&
+   {
+      for(auto& p: per_thread)
+      {
+         if(p.first == name) return p.second;
+      }
+      per_thread.emplace_back(name, std::vector<uint64_t>(_threads.size(), 0));
+      return per_thread.back().second;
+   };
+
+   for(auto& t: _threads)
+   {
+      const auto& nodes = t->nodes;
+      // Depth first walk that carries the merged node of every thread node
+      std::vector<std::pair<uint32_t,size_t>> stack;
+      for(uint32_t c = nodes[0].first_child; c != thread_profile::npos; c = nodes[c].next_sibling)
+      {
+         stack.emplace_back(c, 0);
+      }
+      while(!stack.empty())
+      {
+         auto [node, parent] = stack.back();
+         stack.pop_back();
+         const auto& n = nodes[node];
+
+         size_t m = 0;
+         for(size_t c: merged[parent].children)
+         {
+            if(merged[c].name == n.name) { m = c; break; }
+         }
+         if(m == 0)
+         {
+            m = merged.size();
+            merged.push_back(merged_profile_node{n.name, {}, 0, 0, 0});
+            merged[parent].children.push_back(m);
+         }
+         merged[m].calls += n.calls;
+         merged[m].inclusive += n.inclusive;
+         merged[m].child_ticks += n.children;
+
+         // Per thread time of a name only counts the outermost of nested regions
+         bool nested = false;
+         for(uint32_t a = n.parent; a != 0 && !nested; a = nodes[a].parent)
+         {
+            nested = std::strcmp(nodes[a].name, n.name) == 0;
+         }
+         if(!nested) thread_totals(n.name)[t->thread_index] += n.inclusive;
+
+         for(uint32_t c = n.first_child; c != thread_profile::npos; c = nodes[c].next_sibling)
+         {
+            stack.emplace_back(c, m);
+         }
+      }
+   }
+
+   std::vector<region_stats> stats;
+   std::vector<std::pair<size_t,std::string>> stack;
+   std::vector<size_t> depths;
+   auto push_children = [&](size_t m, const std::string& path, size_t depth)
+   {
+      // Reverse so that children come out in order of first entry
+      const auto& children = merged[m].children;
+      for(auto it = children.rbegin(); it != children.rend(); ++it)
+      {
+         stack.emplace_back(*it, path.empty() ? merged[*it].name : path + "/" + merged[*it].name);
+         depths.push_back(depth);
+      }
+   };
+   push_children(0, "", 0);
+   while(!stack.empty())
+   {
+      auto [m, path] = stack.back();
+      size_t depth = depths.back();
+      stack.pop_back();
+      depths.pop_back();
+      const auto& n = merged[m];
+
+      const auto& totals = thread_totals(n.name);
+      size_t threads = 0;
+      uint64_t max = 0, sum = 0;
+      for(uint64_t t: totals)
+      {
+         threads += t > 0;
+         max = std::max(max, t);
+         sum += t;
+      }
+      double imbalance = sum ? double(max) * threads / double(sum) : 1.0;
+
+      stats.push_back(region_stats{path, depth, n.calls, n.inclusive * spt,
+         (n.inclusive - std::min(n.inclusive, n.child_ticks)) * spt, threads, imbalance});
+      push_children(m, path, depth + 1);
+   }
+   return stats;
+}
+
+inline void profiler::report(std::ostream& os) const
+{
+   auto stats = this->stats();
+   char line[256];
+   std::snprintf(line, sizeof(line), "%-40s %10s %12s %12s %8s %9s\n",
+      "region", "calls", "incl [ms]", "excl [ms]", "threads", "imbalance");
+   os << line;
+   for(auto& s: stats)
+   {
+      std::string name = std::string(2 * s.depth, ' ') + s.path.substr(s.path.rfind('/') == std::string::npos ? 0 : s.path.rfind('/') + 1);
+      std::snprintf(line, sizeof(line), "%-40s %10llu %12.3f %12.3f %8zu %9.2f\n",
+         name.c_str(), static_cast<unsigned long long>(s.calls), 1e3 * s.inclusive, 1e3 * s.exclusive, s.threads, s.imbalance);
+      os << line;
+   }
+}
+
+inline void profiler::write_chrome_trace(std::ostream& os) const
+{
+   double us_per_tick = 1e6 * this->seconds_per_tick();
+   std::lock_guard<std::mutex> lk(_lock);
+
+   auto write_string = [&os](const char* s)
+   {
+      os << '"';
+      for(; *s; ++s)
+      {
+         if(*s == '"' || *s == '\\') os << '\\';
+         if(static_cast<unsigned char>(*s) >= 0x20) os << *s;
+      }
+      os << '"';
+   };
+
+   char number[64];
+   bool first = true;
+   os << "{\"traceEvents\":[";
+   for(auto& t: _threads)
+   {
+      for(auto& e: t->events)
+      {
+         os << (first ? "\n" : ",\n");
+         first = false;
+         os << "{\"name\":";
+         write_string(e.name);
+         std::snprintf(number, sizeof(number), "%.3f", (e.begin - std::min(e.begin, _start_ticks)) * us_per_tick);
+         os << ",\"ph\":\"X\",\"pid\":0,\"tid\":" << t->thread_index << ",\"ts\":" << number;
+         std::snprintf(number, sizeof(number), "%.3f", (e.end - e.begin) * us_per_tick);
+         os << ",\"dur\":" << number << "}";
+      }
+   }
+   os << "\n],\"displayTimeUnit\":\"ms\"}\n";
+}
+
+inline profile_scope::profile_scope(const char* name) noexcept
+{
+   if(!profiler::enabled()) return;
+   // Running out of memory for the profile leaves the region unprofiled
+   // instead of failing the instrumented code
+   try
+   {
+      detail::thread_profile& profile = profiler::local();
+      _node = profile.enter(name);
+      _profile = &profile;
+   }
+   catch(const std::bad_alloc&)
+   {
+      return;
+   }
+   _begin = tsc_clock::now();
+}
+
+inline profile_scope::~profile_scope()
+{
+   if(!_profile) return;
+   uint64_t end = tsc_clock::now();
+   _profile->leave(_node, _begin, end);
+}
+
+} // namespace xlib
@@ -0,0 +1,171 @@
+#pragma once
+
+#include <xlib/core/execution.h>
+
+#include <algorithm>
+#include <array>
+#include <numeric>
+#include <type_traits>
+#include <vector>
+
+namespace xlib
+{
+namespace detail
+{
+
+/** Number of keys below which the parallel radix sort runs serially
+ */
+inline constexpr size_t radix_parallel_threshold = 1 << 16;
+
+/** Map an integral key to an unsigned key with the same ordering
+ */
+template < class Key >
+std::make_unsigned_t<Key> radix_key(Key k) noexcept
+{
+   using U = std::make_unsigned_t<Key>;
+   U u = static_cast<U>(k);
+   if constexpr(std::is_signed<Key>::value)
+   {
+      u ^= U(1) << (8 * sizeof(U) - 1);
+   }
+   return u;
+}
+
+/** Stable LSD radix sort of integral keys
+ *
+ * Sorts 8 bits per pass and skips every pass in which all keys share the
+ * same digit, so small key ranges (e.g. cell indices) only pay for the
+ * digits they use. Parallel policies give each thread a contiguous range of
+ * the keys, with per-thread histograms keeping the scatter stable.
+ * @param policy execution policy
+ * @param keys keys to sort
+ * @param n number of keys
+ * @return order of the keys, order[k] is the index of the k-th smallest key
+ */
+template < class ExecutionPolicy, class Key >
+std::vector<size_t> radix_sort_order(ExecutionPolicy&& policy, const Key* keys, size_t n)
+{
+   static_assert(std::is_integral<Key>::value && !std::is_same<Key,bool>::value, "radix sort requires integral keys");
+   using U = std::make_unsigned_t<Key>;
+   using policy_t = std::remove_cv_t<std::remove_reference_t<ExecutionPolicy>>;
+   constexpr size_t buckets = 256;
+   constexpr size_t passes = sizeof(U);
+
+   size_t num_threads = 1;
+   if constexpr(!std::is_same_v<policy_t, execution::sequenced_policy>)
+   {
+      if(n >= radix_parallel_threshold)
+      {
+         num_threads = policy.num_threads ? policy.num_threads : thread_pool::default_concurrency();
+      }
+   }
+   auto chunk_begin = [n, num_threads](size_t t) { return n * t / num_threads; };
+   auto run = [num_threads](auto&& f)
+   {
+      thread_pool::instance().run(num_threads, f);
+   };
+
+   std::vector<U> key_src(n), key_dst(n);
+   std::vector<size_t> idx_src(n), idx_dst(n);
+
+   // Histogram of every digit, used to skip passes that would not move anything
+   std::vector<std::array<size_t, passes * buckets>> histograms(num_threads);
+   run([&](size_t t, size_t)
+   {
+      auto& hist = histograms[t];
+      hist.fill(0);
+      for(size_t i = chunk_begin(t); i < chunk_begin(t + 1); ++i)
+      {
+         U u = radix_key(keys[i]);
+         key_src[i] = u;
+         idx_src[i] = i;
+         for(size_t p = 0; p < passes; ++p)
+         {
+            hist[p * buckets + ((u >> (8 * p)) & 0xff)]++;
+         }
+      }
+   });
+
+   std::vector<size_t> offsets(num_threads * buckets);
+   for(size_t p = 0; p < passes; ++p)
+   {
+      const size_t shift = 8 * p;
+      std::array<size_t, buckets> total{};
+      for(auto& hist: histograms)
+      {
+         for(size_t d = 0; d < buckets; ++d) total[d] += hist[p * buckets + d];
+      }
+      if(std::any_of(total.begin(), total.end(), [n](size_t c){ return c == n; })) continue;
+
+      // Elements moved in the previous pass, so the per thread counts are stale
+      if(num_threads > 1)
+      {
+         run([&](size_t t, size_t)
+         {
+            size_t* count = &offsets[t * buckets];
+            std::fill(count, count + buckets, 0);
+            for(size_t i = chunk_begin(t); i < chunk_begin(t + 1); ++i)
+            {
+               count[(key_src[i] >> shift) & 0xff]++;
+            }
+         });
+      }
+      else
+      {
+         std::copy(total.begin(), total.end(), offsets.begin());
+      }
+
+      // Exclusive scan over (digit, thread) so that equal digits keep their order
+      size_t running = 0;
+      for(size_t d = 0; d < buckets; ++d)
+      {
+         for(size_t t = 0; t < num_threads; ++t)
+         {
+            size_t c = offsets[t * buckets + d];
+            offsets[t * buckets + d] = running;
+            running += c;
+         }
+      }
+
+      run([&](size_t t, size_t)
+      {
+         size_t* offset = &offsets[t * buckets];
+         for(size_t i = chunk_begin(t); i < chunk_begin(t + 1); ++i)
+         {
+            size_t j = offset[(key_src[i] >> shift) & 0xff]++;
+            key_dst[j] = key_src[i];
+            idx_dst[j] = idx_src[i];
+         }
+      });
+      std::swap(key_src, key_dst);
+      std::swap(idx_src, idx_dst);
+   }
+
+   return idx_src;
+}
+
+/** Order of arbitrary keys using comparison sorting
+ * @param keys keys to sort
+ * @param n number of keys
+ * @param stable keep the order of equal keys
+ * @return order of the keys, order[k] is the index of the k-th smallest key
+ */
+template < class Key >
+std::vector<size_t> comparison_sort_order(const Key* keys, size_t n, bool stable)
+{
+   std::vector<size_t> order(n);
+   std::iota(order.begin(), order.end(), 0);
+   auto less = [keys](size_t a, size_t b) { return keys[a] < keys[b]; };
+   if(stable)
+   {
+      std::stable_sort(order.begin(), order.end(), less);
+   }
+   else
+   {
+      std::sort(order.begin(), order.end(), less);
+   }
+   return order;
+}
+
+} // namespace detail
+} // namespace xlib
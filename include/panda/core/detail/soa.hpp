@@ -1,3 +1,5 @@
+#include <cassert>
+#include <utility>
 
 namespace xlib
 {
@@ -5,6 +7,123 @@ namespace detail
 {
 } // namespace detail
 
+/** Registered array of type T
+ */
+template < class T >
+class soa_bucket::meta_entry final: public soa_bucket::entry
+{
+public:
+   template < class... Args >
+   meta_entry(soa_bucket* parent, size_t index, Args&&... args):
+      entry(parent, index, detail::type_id<T>()),
+      data(std::forward<Args>(args)...)
+   {}
+
+   ~meta_entry() override
+   {
+      detail::soa_dtor<T>()(data);
+   }
+
+   size_t size() const override
+   {
+      return detail::soa_size_of<T>()(data);
+   }
+
+   void resize(size_t n) override
+   {
+      detail::soa_resize<T>()(data, n);
+   }
+
+   void reorder(const detail::soa_permutation<size_t>& perm) override
+   {
+      detail::soa_reorder<T>()(data, perm);
+   }
+
+   T data;
+};
+
+template < class T >
+T& soa_bucket::handle::data() const noexcept
+{
+   assert(this->is<T>() && "handle does not refer to data of type T");
+   return static_cast<soa_bucket::meta_entry<T>*>(_e)->data;
+}
+
+template < class T, class... Args >
+soa_bucket::meta_handle<T> soa_bucket::emplace_data(Args&&... args)
+{
+   std::lock_guard<std::mutex> lk(_map_lock);
+   auto e = std::make_unique<meta_entry<T>>(this, _data.size(), std::forward<Args>(args)...);
+   e->resize(_size);
+   meta_handle<T> h(e.get());
+   _data.push_back(std::move(e));
+   _levels_valid = false;
+   return h;
+}
+
+template < class ExecutionPolicy >
+size_t soa_bucket::num_threads(const ExecutionPolicy& policy) noexcept
+{
+   if constexpr(std::is_same_v<ExecutionPolicy, execution::sequenced_policy>)
+   {
+      return 1;
+   }
+   else
+   {
+      return policy.num_threads ? policy.num_threads : thread_pool::default_concurrency();
+   }
+}
+
+template < class ExecutionPolicy, class >
+void soa_bucket::resize(ExecutionPolicy&& policy, size_t n)
+{
+   this->resize_impl(num_threads(policy), n);
+}
 
+template < class ExecutionPolicy, class >
+void soa_bucket::reorder(ExecutionPolicy&& policy, const std::vector<size_t>& new_index_map)
+{
+   this->reorder_impl(num_threads(policy), new_index_map);
+}
+
+template < class T >
+soa_bucket::meta_handle<T> soa_bucket::register_data()
+{
+   return this->emplace_data<T>();
+}
+
+template < class T, class >
+soa_bucket::meta_handle<T> soa_bucket::register_data(const T& copied)
+{
+   return this->emplace_data<T>(copied);
+}
+
+template < class T, class >
+soa_bucket::meta_handle<T> soa_bucket::register_data(T&& moved)
+{
+   return this->emplace_data<T>(std::move(moved));
+}
+
+template < class T >
+T& soa_bucket::get_data(const soa_bucket::meta_handle<T>& h) noexcept
+{
+   assert(h.entry() && h.entry()->parent() == this);
+   return h.data();
+}
+
+template < class T >
+T& soa_bucket::get_data(const soa_bucket::handle& h) noexcept
+{
+   assert(h.entry() && h.entry()->parent() == this);
+   return h.template data<T>();
+}
+
+template < class T >
+soa_bucket::entry* soa_bucket::get_entry(const soa_bucket::handle& h) noexcept
+{
+   assert(h.entry() && h.entry()->parent() == this);
+   assert(h.template is<T>());
+   return h.entry();
+}
 
-} // namespace xlib
\ No newline at end of file
+} // namespace xlib
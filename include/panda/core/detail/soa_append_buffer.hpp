@@ -0,0 +1,187 @@
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace xlib
+{
+namespace detail
+{
+
+/** Number of columns of a static_soa
+ */
+template < class Soa >
+struct soa_num_columns;
+
+template < class Allocator, class... Types >
+struct soa_num_columns<basic_static_soa<Allocator,Types...>>: std::integral_constant<size_t, sizeof...(Types)> {};
+
+/** Columns whose elements can be appended with memcpy
+ */
+template < class Column >
+struct soa_memcpy_column: std::false_type {};
+
+template < class T >
+struct soa_memcpy_column<T*>: std::is_trivially_copyable<T> {};
+
+template < class T >
+struct soa_memcpy_column<std::vector<T>>: std::bool_constant<std::is_trivially_copyable<T>::value && !std::is_same<T,bool>::value> {};
+
+template < class T >
+T* soa_column_data(T* column) noexcept { return column; }
+
+template < class T >
+const T* soa_column_data(const std::vector<T>& column) noexcept { return column.data(); }
+
+template < class T >
+T* soa_column_data(std::vector<T>& column) noexcept { return column.data(); }
+
+/** Copy elements [0, n) of column src to [offset, offset + n) of column dst
+ */
+template < class Column >
+void soa_append_column(Column& dst, const Column& src, size_t offset, size_t n)
+{
+   if(n == 0) return;
+   if constexpr(soa_memcpy_column<Column>::value)
+   {
+      auto* d = soa_column_data(dst) + offset;
+      const auto* s = soa_column_data(src);
+      std::memcpy(static_cast<void*>(d), s, n * sizeof(*s));
+   }
+   else
+   {
+      for(size_t j = 0; j < n; ++j) dst[offset + j] = src[j];
+   }
+}
+
+template < class Soa, size_t... I >
+void soa_append_rows(Soa& dst, const Soa& src, size_t offset, std::index_sequence<I...>)
+{
+   (soa_append_column(dst.template get_data<I>(), src.template get_data<I>(), offset, src.size()), ...);
+}
+
+template < class Soa, size_t... I >
+constexpr bool soa_memcpy_columns(std::index_sequence<I...>)
+{
+   return (soa_memcpy_column<typename Soa::template value_type<I>>::value && ...);
+}
+
+template < class Soa, size_t... I, class... Values >
+void soa_assign_row(Soa& soa, size_t i, std::index_sequence<I...>, Values&&... values)
+{
+   ((soa.template get_data<I>()[i] = std::forward<Values>(values)), ...);
+}
+
+} // namespace detail
+
+template < class Soa >
+size_t soa_append_buffer<Soa>::stage::append(size_t n)
+{
+   size_t first = _rows.size();
+   _rows.resize(first + n);
+   return first;
+}
+
+template < class Soa >
+template < class... Values >
+size_t soa_append_buffer<Soa>::stage::push_back(Values&&... values)
+{
+   static_assert(sizeof...(Values) == detail::soa_num_columns<Soa>::value, "push_back requires one value per column");
+   size_t i = this->append(1);
+   detail::soa_assign_row(_rows, i, std::index_sequence_for<Values...>(), std::forward<Values>(values)...);
+   return i;
+}
+
+template < class Soa >
+soa_append_buffer<Soa>::soa_append_buffer(Soa& target, size_t max_stages):
+   _target(&target),
+   _stages(max_stages ? max_stages : thread_pool::default_concurrency())
+{}
+
+template < class Soa >
+typename soa_append_buffer<Soa>::stage& soa_append_buffer<Soa>::acquire()
+{
+   size_t t = _acquired.fetch_add(1, std::memory_order_relaxed);
+   if(t >= _stages.size()) throw std::length_error("soa_append_buffer: every stage is in use");
+   return _stages[t];
+}
+
+template < class Soa >
+typename soa_append_buffer<Soa>::stage& soa_append_buffer<Soa>::get_stage(size_t t) noexcept
+{
+   assert(t < _stages.size());
+   return _stages[t];
+}
+
+template < class Soa >
+size_t soa_append_buffer<Soa>::size() const noexcept
+{
+   size_t n = 0;
+   for(const stage& s: _stages) n += s.size();
+   return n;
+}
+
+template < class Soa >
+template < class F >
+void soa_append_buffer<Soa>::for_each_stage(F&& f)
+{
+   for(stage& s: _stages) f(s.rows());
+}
+
+template < class Soa >
+size_t soa_append_buffer<Soa>::commit()
+{
+   return this->commit_impl(execution::seq);
+}
+
+template < class Soa >
+template < class ExecutionPolicy, class >
+size_t soa_append_buffer<Soa>::commit(ExecutionPolicy&& policy)
+{
+   return this->commit_impl(policy);
+}
+
+template < class Soa >
+template < class ExecutionPolicy >
+size_t soa_append_buffer<Soa>::commit_impl(ExecutionPolicy&& policy)
+{
+   XLIB_PROFILE_SCOPE("soa_append_buffer::commit");
+   using policy_t = std::remove_cv_t<std::remove_reference_t<ExecutionPolicy>>;
+   using indices = std::make_index_sequence<detail::soa_num_columns<Soa>::value>;
+
+   size_t first = _target->size();
+   std::vector<size_t> offsets(_stages.size() + 1, first);
+   for(size_t t = 0; t < _stages.size(); ++t) offsets[t + 1] = offsets[t] + _stages[t].size();
+
+   size_t n = offsets.back();
+   if(n > first)
+   {
+      // Every appended element is overwritten, so columns that are copied
+      // with memcpy do not need to construct them first. The resize also
+      // marks the appended elements dirty. Observers read the new elements,
+      // so they are only notified once the rows are in place.
+      _target->resize_impl(n, detail::soa_memcpy_columns<Soa>(indices()), policy);
+
+      // One task per stage, every stage copies all of its columns
+      policy_t per_stage = policy;
+      if constexpr(!std::is_same_v<policy_t, execution::sequenced_policy>)
+      {
+         per_stage.chunk_size = 1;
+      }
+      detail::parallel_for(per_stage, 0, _stages.size(), [&](size_t begin, size_t end)
+      {
+         for(size_t t = begin; t < end; ++t)
+         {
+            detail::soa_append_rows(*_target, _stages[t].rows(), offsets[t], indices());
+         }
+      });
+      _target->notify([&](typename Soa::observer& o) { o.resized(*_target, first); });
+   }
+
+   for(stage& s: _stages) s.rows().resize(0);
+   _acquired.store(0, std::memory_order_relaxed);
+   return first;
+}
+
+} // namespace xlib
@@ -0,0 +1,313 @@
+#include <xlib/core/thread_pool.h>
+
+#include <algorithm>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+
+namespace xlib
+{
+namespace detail
+{
+
+/** Number of elements copied through a staging buffer at a time for
+ * columns that are not stored contiguously
+ */
+inline constexpr size_t checkpoint_stage_elements = 4096;
+
+template < class Col >
+struct checkpoint_value
+{
+   using type = typename Col::value_type;
+};
+
+template < class T >
+struct checkpoint_value<T*>
+{
+   using type = T;
+};
+
+template < class Col >
+using checkpoint_value_t = typename checkpoint_value<std::remove_cv_t<Col>>::type;
+
+/** Columns whose elements can be written straight from their storage
+ */
+template < class Col, class = void >
+struct checkpoint_contiguous: std::false_type
+{};
+
+template < class T >
+struct checkpoint_contiguous<T*>: std::true_type
+{};
+
+template < class Col >
+struct checkpoint_contiguous<Col, std::enable_if_t<
+   std::is_same<decltype(std::declval<const Col&>().data()), const typename Col::value_type*>::value>>:
+   std::true_type
+{};
+
+template < class Col >
+const checkpoint_value_t<Col>* checkpoint_data(const Col& col) noexcept
+{
+   if constexpr(std::is_pointer<Col>::value)
+   {
+      return col;
+   }
+   else
+   {
+      return col.data();
+   }
+}
+
+template < class Col >
+checkpoint_value_t<Col>* checkpoint_data(Col& col) noexcept
+{
+   if constexpr(std::is_pointer<Col>::value)
+   {
+      return col;
+   }
+   else
+   {
+      return col.data();
+   }
+}
+
+/** Call f(col, begin, n, values) on consecutive ranges of a column, values
+ * points at a copy of elements [begin, begin + n) or at the elements themselves
+ */
+template < class Col, class F >
+void checkpoint_for_each_range(const Col& col, F&& f)
+{
+   using T = checkpoint_value_t<Col>;
+   size_t n = soa_size_of<Col>()(col);
+   if constexpr(checkpoint_contiguous<Col>::value)
+   {
+      f(size_t(0), n, checkpoint_data(col));
+   }
+   else
+   {
+      std::unique_ptr<T[]> stage(new T[std::min(n, checkpoint_stage_elements)]);
+      for(size_t b = 0; b < n; b += checkpoint_stage_elements)
+      {
+         size_t m = std::min(checkpoint_stage_elements, n - b);
+         for(size_t j = 0; j < m; ++j) stage[j] = col[b + j];
+         f(b, m, static_cast<const T*>(stage.get()));
+      }
+   }
+}
+
+template < class Col >
+uint64_t checkpoint_hash_column(const Col& col)
+{
+   checkpoint_hasher hasher;
+   checkpoint_for_each_range(col, [&](size_t, size_t n, const auto* values)
+   {
+      hasher.update(values, n * sizeof(*values));
+   });
+   return hasher.digest();
+}
+
+template < class Col >
+uint64_t checkpoint_write_column(checkpoint_file& file, const Col& col, uint64_t offset)
+{
+   checkpoint_hasher hasher;
+   checkpoint_for_each_range(col, [&](size_t begin, size_t n, const auto* values)
+   {
+      hasher.update(values, n * sizeof(*values));
+      file.write(values, n * sizeof(*values), offset + begin * sizeof(*values));
+   });
+   return hasher.digest();
+}
+
+template < class Col >
+uint64_t checkpoint_read_column(checkpoint_file& file, Col& col, uint64_t offset)
+{
+   using T = checkpoint_value_t<Col>;
+   checkpoint_hasher hasher;
+   size_t n = soa_size_of<Col>()(col);
+   if constexpr(checkpoint_contiguous<Col>::value)
+   {
+      T* values = checkpoint_data(col);
+      file.read(values, n * sizeof(T), offset);
+      hasher.update(values, n * sizeof(T));
+   }
+   else
+   {
+      std::unique_ptr<T[]> stage(new T[std::min(n, checkpoint_stage_elements)]);
+      for(size_t b = 0; b < n; b += checkpoint_stage_elements)
+      {
+         size_t m = std::min(checkpoint_stage_elements, n - b);
+         file.read(stage.get(), m * sizeof(T), offset + b * sizeof(T));
+         hasher.update(stage.get(), m * sizeof(T));
+         for(size_t j = 0; j < m; ++j) col[b + j] = stage[j];
+      }
+   }
+   return hasher.digest();
+}
+
+/** Header entry of a column of n elements, payload offset and hash unset
+ */
+template < class Col >
+checkpoint_column checkpoint_describe_column(uint64_t n) noexcept
+{
+   using T = checkpoint_value_t<Col>;
+   static_assert(std::is_trivially_copyable<T>::value,
+      "checkpoints store the raw bytes of the elements, which must be trivially copyable");
+   return checkpoint_column{sizeof(T), checkpoint_type_tag<T>::value, 0, n * sizeof(T), 0};
+}
+
+template < class Soa, size_t... Indices >
+std::vector<checkpoint_column> checkpoint_describe(const Soa& soa, std::index_sequence<Indices...>)
+{
+   return {checkpoint_describe_column<typename Soa::template value_type<Indices>>(soa.size())...};
+}
+
+template < class Soa, class F, size_t... Indices >
+void checkpoint_visit(Soa& soa, size_t k, F& f, std::index_sequence<Indices...>)
+{
+   using eval = int[];
+   (void)eval{0, (k == Indices ? (f(soa.template get_data<Indices>(), Indices), 0) : 0)...};
+}
+
+/** Call f(column, k) for every column index k in which, one column per thread
+ */
+template < size_t NumColumns, class Soa, class F >
+void checkpoint_for_each_column(Soa& soa, const std::vector<size_t>& which, F&& f)
+{
+   using indices = std::make_index_sequence<NumColumns>;
+   if(which.empty()) return;
+   thread_pool::instance().run(which.size(), [&](size_t thread_index, size_t num_threads)
+   {
+      for(size_t j = thread_index; j < which.size(); j += num_threads)
+      {
+         checkpoint_visit(soa, which[j], f, indices());
+      }
+   });
+}
+
+} // namespace detail
+
+template < class Allocator, class... Types >
+size_t save(const basic_static_soa<Allocator, Types...>& soa, const std::string& path, checkpoint_mode mode)
+{
+   using checkpoint_file = detail::checkpoint_file;
+   std::vector<detail::checkpoint_column> columns = detail::checkpoint_describe(soa, std::index_sequence_for<Types...>());
+   std::vector<size_t> all(columns.size());
+   std::iota(all.begin(), all.end(), 0);
+   uint64_t size = soa.size();
+
+   if(mode == checkpoint_mode::incremental)
+   {
+      std::unique_ptr<checkpoint_file> file;
+      uint64_t previous_size = 0;
+      std::vector<detail::checkpoint_column> previous;
+      try
+      {
+         file = std::make_unique<checkpoint_file>(path, checkpoint_file::open_update);
+      }
+      catch(const std::system_error&)
+      {
+         // No previous checkpoint
+      }
+
+      bool compatible = file && file->read_header(previous_size, previous) &&
+         previous_size == size && previous.size() == columns.size();
+      for(size_t k = 0; compatible && k < columns.size(); ++k)
+      {
+         compatible = previous[k].element_size == columns[k].element_size &&
+            previous[k].type_tag == columns[k].type_tag &&
+            previous[k].bytes == columns[k].bytes;
+      }
+
+      if(compatible)
+      {
+         detail::checkpoint_for_each_column<sizeof...(Types)>(soa, all, [&](const auto& col, size_t k)
+         {
+            columns[k].hash = detail::checkpoint_hash_column(col);
+         });
+
+         std::vector<size_t> changed;
+         for(size_t k = 0; k < columns.size(); ++k)
+         {
+            columns[k].offset = previous[k].offset;
+            if(columns[k].hash != previous[k].hash) changed.push_back(k);
+         }
+         if(changed.empty()) return 0;
+
+         // The previous payloads stay valid until the header points away
+         // from them
+         file->relocate(columns, changed, previous);
+         detail::checkpoint_for_each_column<sizeof...(Types)>(soa, changed, [&](const auto& col, size_t k)
+         {
+            detail::checkpoint_write_column(*file, col, columns[k].offset);
+         });
+         file->sync();
+         file->write_header(size, columns);
+         file->sync();
+         file->trim(columns);
+         return changed.size();
+      }
+   }
+
+   checkpoint_file file(path + ".tmp", checkpoint_file::open_truncate);
+   file.layout(columns);
+   detail::checkpoint_for_each_column<sizeof...(Types)>(soa, all, [&](const auto& col, size_t k)
+   {
+      columns[k].hash = detail::checkpoint_write_column(file, col, columns[k].offset);
+   });
+   file.write_header(size, columns);
+   file.sync();
+   file.replace(path);
+   return columns.size();
+}
+
+template < class Allocator, class... Types >
+void load(basic_static_soa<Allocator, Types...>& soa, const std::string& path)
+{
+   using checkpoint_file = detail::checkpoint_file;
+   checkpoint_file file(path, checkpoint_file::open_read);
+
+   uint64_t size = 0;
+   std::vector<detail::checkpoint_column> columns;
+   if(!file.read_header(size, columns))
+   {
+      throw std::runtime_error("checkpoint: " + path + " is not a checkpoint");
+   }
+
+   std::vector<detail::checkpoint_column> expected = detail::checkpoint_describe(soa, std::index_sequence_for<Types...>());
+   if(columns.size() != expected.size())
+   {
+      throw std::runtime_error("checkpoint: " + path + " has a different number of columns");
+   }
+   for(size_t k = 0; k < columns.size(); ++k)
+   {
+      if(columns[k].element_size != expected[k].element_size || columns[k].type_tag != expected[k].type_tag)
+      {
+         throw std::runtime_error("checkpoint: column " + std::to_string(k) + " of " + path + " has a different element type");
+      }
+      if(columns[k].bytes != size * columns[k].element_size)
+      {
+         throw std::runtime_error("checkpoint: " + path + " is corrupted");
+      }
+   }
+
+   soa.resize(size);
+   std::vector<size_t> all(columns.size());
+   std::iota(all.begin(), all.end(), 0);
+   std::vector<char> corrupted(columns.size(), 0);
+   detail::checkpoint_for_each_column<sizeof...(Types)>(soa, all, [&](auto& col, size_t k)
+   {
+      corrupted[k] = detail::checkpoint_read_column(file, col, columns[k].offset) != columns[k].hash;
+   });
+   for(size_t k = 0; k < columns.size(); ++k)
+   {
+      if(corrupted[k])
+      {
+         throw std::runtime_error("checkpoint: column " + std::to_string(k) + " of " + path + " is corrupted");
+      }
+   }
+}
+
+} // namespace xlib
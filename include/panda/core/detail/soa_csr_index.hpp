@@ -0,0 +1,289 @@
+#include <xlib/core/assert.h>
+
+#include <algorithm>
+#include <utility>
+
+namespace xlib
+{
+namespace detail
+{
+
+/** Number of elements below which soa_csr_index rebuilds serially
+ */
+inline constexpr size_t csr_parallel_threshold = 1 << 16;
+
+/** Slots given to a key with count elements by a rebuild
+ */
+inline constexpr size_t csr_capacity(size_t count) noexcept
+{
+   return count + count / 4 + 1;
+}
+
+} // namespace detail
+
+template < class Soa, size_t I >
+soa_csr_index<Soa,I>::soa_csr_index(Soa& soa, size_t num_keys, const execution::parallel_policy& policy):
+   _soa(&soa),
+   _policy(policy),
+   _num_keys(num_keys)
+{
+   _soa->attach(this);
+   this->rebuild();
+}
+
+template < class Soa, size_t I >
+soa_csr_index<Soa,I>::~soa_csr_index()
+{
+   if(_soa) _soa->detach(this);
+}
+
+template < class Soa, size_t I >
+typename soa_csr_index<Soa,I>::range soa_csr_index<Soa,I>::operator[](size_t k) const noexcept
+{
+   _XLIB_ASSERT(RANGE, 0, _num_keys, k);
+   const size_t* begin = _indices.data() + _ranges[k].begin;
+   return range(begin, begin + _ranges[k].count);
+}
+
+template < class Soa, size_t I >
+size_t soa_csr_index<Soa,I>::key(size_t i) const noexcept
+{
+   key_type k = _soa->template get_data<I>()[i];
+   // Negative keys wrap around to large sizes
+   assert(static_cast<size_t>(k) < _num_keys && "key out of range of the soa_csr_index");
+   return static_cast<size_t>(k);
+}
+
+template < class Soa, size_t I >
+size_t soa_csr_index<Soa,I>::update()
+{
+   assert(_soa && "soa_csr_index is not attached to a container");
+   std::vector<size_t> changed;
+   for(size_t i = 0; i < _keys.size(); ++i)
+   {
+      if(this->key(i) != _keys[i]) changed.push_back(i);
+   }
+   this->apply_changes(changed);
+   return changed.size();
+}
+
+template < class Soa, size_t I >
+size_t soa_csr_index<Soa,I>::update(const std::vector<size_t>& candidates)
+{
+   assert(_soa && "soa_csr_index is not attached to a container");
+   std::vector<size_t> changed;
+   for(size_t i: candidates)
+   {
+      assert(i < _keys.size());
+      if(this->key(i) != _keys[i]) changed.push_back(i);
+   }
+   // Elements listed twice are only moved once
+   std::sort(changed.begin(), changed.end());
+   changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+   this->apply_changes(changed);
+   return changed.size();
+}
+
+template < class Soa, size_t I >
+void soa_csr_index<Soa,I>::apply_changes(const std::vector<size_t>& changed)
+{
+   // Moves scatter over the whole array, a rebuild streams through it
+   if(4 * changed.size() > _keys.size())
+   {
+      this->rebuild();
+      return;
+   }
+   for(size_t i: changed)
+   {
+      this->remove(i);
+      // The rebuild reads the new keys of all elements, including the ones
+      // not moved yet
+      if(!this->insert(i, this->key(i)))
+      {
+         this->rebuild();
+         return;
+      }
+   }
+}
+
+template < class Soa, size_t I >
+void soa_csr_index<Soa,I>::rebuild()
+{
+   assert(_soa && "soa_csr_index is not attached to a container");
+   XLIB_PROFILE_SCOPE("soa_csr_index::rebuild");
+   const size_t n = _soa->size();
+   const size_t num_keys = _num_keys;
+   _keys.resize(n);
+   _positions.resize(n);
+   _ranges.assign(num_keys, slot_range{0, 0, 0});
+
+   // Every thread keeps a histogram of all keys, so at least num_keys
+   // elements per thread keep the histograms within O(n)
+   size_t num_threads = 1;
+   if(n >= detail::csr_parallel_threshold)
+   {
+      num_threads = _policy.num_threads ? _policy.num_threads : thread_pool::default_concurrency();
+      num_threads = std::max<size_t>(1, std::min(num_threads, n / std::max<size_t>(1, num_keys)));
+   }
+   auto chunk_begin = [n, num_threads](size_t t) { return n * t / num_threads; };
+
+   // Count the keys of a contiguous range of elements per thread
+   std::vector<size_t> counts(num_threads * num_keys, 0);
+   auto count = [&](size_t t, size_t)
+   {
+      size_t* c = &counts[t * num_keys];
+      for(size_t i = chunk_begin(t); i < chunk_begin(t + 1); ++i)
+      {
+         size_t k = this->key(i);
+         _keys[i] = k;
+         c[k]++;
+      }
+   };
+
+   // Exclusive scan over (key, thread) so that every range lists its
+   // elements in increasing order, followed by the slack of the key
+   size_t running = 0;
+   auto scan = [&]
+   {
+      for(size_t k = 0; k < num_keys; ++k)
+      {
+         slot_range& r = _ranges[k];
+         r.begin = running;
+         for(size_t t = 0; t < num_threads; ++t)
+         {
+            size_t c = counts[t * num_keys + k];
+            counts[t * num_keys + k] = running;
+            running += c;
+         }
+         r.count = running - r.begin;
+         r.capacity = detail::csr_capacity(r.count);
+         running = r.begin + r.capacity;
+      }
+      _indices.resize(running);
+   };
+
+   auto scatter = [&](size_t t, size_t)
+   {
+      size_t* next = &counts[t * num_keys];
+      for(size_t i = chunk_begin(t); i < chunk_begin(t + 1); ++i)
+      {
+         size_t p = next[_keys[i]]++;
+         _indices[p] = i;
+         _positions[i] = p;
+      }
+   };
+
+   if(num_threads > 1)
+   {
+      thread_pool::instance().run(num_threads, count);
+      scan();
+      thread_pool::instance().run(num_threads, scatter);
+   }
+   else
+   {
+      count(0, 1);
+      scan();
+      scatter(0, 1);
+   }
+}
+
+template < class Soa, size_t I >
+void soa_csr_index<Soa,I>::set_num_keys(size_t num_keys)
+{
+   _num_keys = num_keys;
+   this->rebuild();
+}
+
+template < class Soa, size_t I >
+void soa_csr_index<Soa,I>::resized(Soa& soa, size_t old_size)
+{
+   assert(&soa == _soa);
+   const size_t n = soa.size();
+   assert(old_size == _keys.size());
+
+   size_t changes = n > old_size ? n - old_size : old_size - n;
+   if(4 * changes > std::max(n, old_size))
+   {
+      this->rebuild();
+      return;
+   }
+   if(n > old_size)
+   {
+      _keys.resize(n);
+      _positions.resize(n);
+      for(size_t i = old_size; i < n; ++i)
+      {
+         if(!this->insert(i, this->key(i)))
+         {
+            this->rebuild();
+            return;
+         }
+      }
+   }
+   else
+   {
+      for(size_t i = n; i < old_size; ++i) this->remove(i);
+      _keys.resize(n);
+      _positions.resize(n);
+   }
+}
+
+template < class Soa, size_t I >
+void soa_csr_index<Soa,I>::reordered(Soa& soa, size_t)
+{
+   assert(&soa == _soa);
+   (void)soa;
+   this->rebuild();
+}
+
+template < class Soa, size_t I >
+void soa_csr_index<Soa,I>::relocated(Soa* soa)
+{
+   _soa = soa;
+}
+
+template < class Soa, size_t I >
+bool soa_csr_index<Soa,I>::insert(size_t i, size_t k)
+{
+   slot_range& r = _ranges[k];
+   if(r.count == r.capacity)
+   {
+      // Abandoned ranges are only reclaimed by a rebuild, which lays out at
+      // most about 1.25 (size + num_keys) slots
+      size_t capacity = std::max<size_t>(2 * r.capacity, 4);
+      size_t begin = _indices.size();
+      if(begin + capacity > 2 * (_keys.size() + _num_keys)) return false;
+      _indices.resize(begin + capacity);
+      for(size_t j = 0; j < r.count; ++j)
+      {
+         size_t e = _indices[r.begin + j];
+         _indices[begin + j] = e;
+         _positions[e] = begin + j;
+      }
+      r.begin = begin;
+      r.capacity = capacity;
+   }
+   size_t p = r.begin + r.count++;
+   _indices[p] = i;
+   _positions[i] = p;
+   _keys[i] = k;
+   return true;
+}
+
+template < class Soa, size_t I >
+void soa_csr_index<Soa,I>::remove(size_t i) noexcept
+{
+   slot_range& r = _ranges[_keys[i]];
+   size_t last = r.begin + --r.count;
+   this->swap_slots(_positions[i], last);
+}
+
+template < class Soa, size_t I >
+void soa_csr_index<Soa,I>::swap_slots(size_t p, size_t q) noexcept
+{
+   std::swap(_indices[p], _indices[q]);
+   _positions[_indices[p]] = p;
+   _positions[_indices[q]] = q;
+}
+
+} // namespace xlib
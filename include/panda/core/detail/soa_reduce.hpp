@@ -0,0 +1,120 @@
+#pragma once
+
+#include <xlib/core/execution.h>
+#include <xlib/core/fp_promotion.h>
+
+#include <algorithm>
+#include <array>
+#include <type_traits>
+#include <vector>
+
+namespace xlib
+{
+namespace detail
+{
+
+/** Accumulator of reductions over elements of type T, promote_fp_t<T> for
+ * the arithmetic types it is defined for and T otherwise
+ */
+template < class T, class = void >
+struct soa_accumulator
+{
+   using type = T;
+};
+
+template < class T >
+struct soa_accumulator<T, std::void_t<typename promote_fp<T>::type>>
+{
+   using type = promote_fp_t<T>;
+};
+
+template < class T >
+using soa_accumulator_t = typename soa_accumulator<T>::type;
+
+/** Number of independent accumulators per chunk, lets the compiler keep the
+ * partial sums of one chunk in vector registers
+ */
+inline constexpr size_t soa_reduce_lanes = 8;
+
+/** Reduce load(i) for i in [begin, end), end > begin, with soa_reduce_lanes
+ * interleaved accumulators combined pairwise at the end
+ */
+template < class Acc, class Load, class BinaryOp >
+Acc soa_reduce_chunk(size_t begin, size_t end, Load& load, BinaryOp& op)
+{
+   constexpr size_t lanes = soa_reduce_lanes;
+   if(end - begin < lanes)
+   {
+      Acc acc = load(begin);
+      for(size_t i = begin + 1; i < end; ++i) acc = op(acc, load(i));
+      return acc;
+   }
+
+   std::array<Acc, lanes> lane;
+   for(size_t j = 0; j < lanes; ++j) lane[j] = load(begin + j);
+   size_t i = begin + lanes;
+   for(; i + lanes <= end; i += lanes)
+   {
+      for(size_t j = 0; j < lanes; ++j) lane[j] = op(lane[j], load(i + j));
+   }
+   for(size_t j = 0; i < end; ++i, ++j) lane[j] = op(lane[j], load(i));
+
+   for(size_t width = lanes / 2; width > 0; width /= 2)
+   {
+      for(size_t j = 0; j < width; ++j) lane[j] = op(lane[j], lane[j + width]);
+   }
+   return lane[0];
+}
+
+/** Reduce load(i) for i in [0, n) with op, starting from init
+ *
+ * The range is cut into chunks of a fixed size, every chunk is reduced on
+ * its own and the partial results are combined pairwise in chunk order.
+ * The result therefore only depends on the chunk size: sequenced policies
+ * and deterministic parallel policies without a chunk size use
+ * execution::default_deterministic_chunk and give bitwise identical results
+ * for any number of threads, dynamic policies pick the chunk size from the
+ * number of threads.
+ * @param policy execution policy
+ * @param n number of elements
+ * @param init initial value, combined once with the reduction of the elements
+ * @param load callable as load(i), returns element i converted to Acc
+ * @param op associative and commutative operation, as for std::reduce
+ * @return reduction of init and every element
+ */
+template < class ExecutionPolicy, class Acc, class Load, class BinaryOp >
+Acc soa_reduce(ExecutionPolicy&& policy, size_t n, Acc init, Load&& load, BinaryOp&& op)
+{
+   using policy_t = std::remove_cv_t<std::remove_reference_t<ExecutionPolicy>>;
+   if(n == 0) return init;
+
+   size_t chunk_size = execution::default_deterministic_chunk;
+   policy_t chunked = policy;
+   if constexpr(!std::is_same_v<policy_t, execution::sequenced_policy>)
+   {
+      chunk_size = make_chunk_layout(policy, n).chunk_size;
+      chunked.chunk_size = chunk_size;
+   }
+   size_t num_chunks = (n + chunk_size - 1) / chunk_size;
+
+   std::vector<Acc> partials(num_chunks, init);
+   parallel_for(chunked, 0, n, [&](size_t begin, size_t end)
+   {
+      for(size_t b = begin; b < end; b += chunk_size)
+      {
+         partials[b / chunk_size] = soa_reduce_chunk<Acc>(b, std::min(end, b + chunk_size), load, op);
+      }
+   });
+
+   for(size_t width = 1; width < num_chunks; width *= 2)
+   {
+      for(size_t k = 0; k + width < num_chunks; k += 2 * width)
+      {
+         partials[k] = op(partials[k], partials[k + width]);
+      }
+   }
+   return op(init, partials[0]);
+}
+
+} // namespace detail
+} // namespace xlib
@@ -1,20 +1,31 @@
 #include <xlib/core/mpl/conditional.h>
+#include <xlib/core/detail/radix_sort.hpp>
 
 #include <type_traits>
 #include <algorithm>
+#include <functional>
+#include <memory>
+#include <numeric>
+#include <new>
+#include <limits>
+#include <cassert>
 
 namespace xlib
 {
 namespace detail
 {
 // SOA Element Value Type
-template < class T, class = std::void_t<> >
-struct soa_element_value_type;
+// Columns without a value_type hold what their operator[] refers to
+template < class T, class >
+struct soa_element_value_type
+{
+   using value_type = std::decay_t<decltype(std::declval<T&>()[size_t(0)])>;
+};
 
 template < class T >
 struct soa_element_value_type<T, std::void_t<typename T::value_type>>
 {
-   using vaule_type = typename T::value_type;
+   using value_type = typename T::value_type;
 };
 
 template < class T >
@@ -39,6 +50,216 @@ struct soa_element_reference<T*,void>
    using value_type = T;
 };
 
+/** Call f(begin, end) across threads for the parts of [begin, end) that fall
+ * into each chunk of [0, end)
+ *
+ * Chunks are laid out from index 0, as for a kernel over a whole column, so
+ * that an element is touched by the thread that runs its chunk in kernels
+ * with the same policy no matter where the range starts.
+ */
+template < class ExecutionPolicy, class F >
+void soa_for_each_partition(ExecutionPolicy&& policy, size_t begin, size_t end, F&& f)
+{
+   if(begin >= end) return;
+   parallel_for(policy, 0, end, [&](size_t b, size_t e)
+   {
+      b = std::max(b, begin);
+      if(b < e) f(b, e);
+   });
+}
+
+/** True if touching this many bytes is worth first touching in parallel
+ */
+inline bool soa_first_touch(size_t bytes) noexcept
+{
+   return bytes >= XLIB_SOA_FIRST_TOUCH_BYTES && !thread_pool::in_parallel();
+}
+
+/** How resize constructs the new elements of a column holding V
+ */
+template < class V >
+struct soa_initializer
+{
+   /** Every new element is a copy of *value, value initialized if null */
+   const V* value = nullptr;
+   /** Default initialize, leaving elements of trivial types indeterminate */
+   bool uninitialized = false;
+
+   void construct(V* begin, V* end) const
+   {
+      if(uninitialized)
+      {
+         std::uninitialized_default_construct(begin, end);
+      }
+      else if(value)
+      {
+         std::uninitialized_fill(begin, end, *value);
+      }
+      else
+      {
+         std::uninitialized_value_construct(begin, end);
+      }
+   }
+};
+
+// SOA raw pointer column storage
+//
+// Raw pointer columns carry their size and capacity in front of the data:
+//
+//    | padding ... capacity size | data[0] ... data[capacity-1] |
+//    ^ aligned allocation        ^ aligned to soa_alignment_v<T>
+//
+// The header is padded to the column alignment so that the data itself is
+// aligned, and soa_size_of<T*> only needs to read data[-1].
+//
+// Trivially copyable columns of at least XLIB_SOA_REMAP_BYTES are mapped
+// directly from the kernel, so that growing and shrinking them remaps their
+// pages instead of copying the elements.
+template < class T >
+struct soa_pointer_storage
+{
+   static constexpr size_t alignment = soa_alignment_v<T>;
+   static constexpr size_t header_bytes = alignment;
+   static constexpr bool remappable = std::is_trivially_copyable_v<T> && alignment <= soa_map_alignment;
+
+   static_assert((alignment & (alignment - 1)) == 0, "soa_alignment must be a power of two");
+   static_assert(header_bytes >= 2 * sizeof(size_t), "soa_alignment must leave room for the size and capacity");
+
+   static size_t& size(T* data) noexcept
+   {
+      return reinterpret_cast<size_t*>(data)[-1];
+   }
+
+   static size_t& capacity(T* data) noexcept
+   {
+      return reinterpret_cast<size_t*>(data)[-2];
+   }
+
+   static size_t bytes(size_t capacity) noexcept
+   {
+      return header_bytes + sizeof(T) * capacity;
+   }
+
+   /** True if storage for capacity elements is mapped rather than taken from the heap
+    */
+   static bool mapped(size_t capacity) noexcept
+   {
+      return remappable && bytes(capacity) >= XLIB_SOA_REMAP_BYTES;
+   }
+
+   /** Allocate uninitialized storage for capacity elements, size is set to 0
+    */
+   static T* allocate(size_t capacity)
+   {
+      char* head = mapped(capacity)
+         ? static_cast<char*>(soa_map_allocate(bytes(capacity)))
+         : static_cast<char*>(::operator new(bytes(capacity), std::align_val_t(alignment)));
+      T* data = reinterpret_cast<T*>(head + header_bytes);
+      soa_pointer_storage::capacity(data) = capacity;
+      soa_pointer_storage::size(data) = 0;
+      return data;
+   }
+
+   /** Release storage, elements must already be destroyed
+    */
+   static void deallocate(T* data) noexcept
+   {
+      char* head = reinterpret_cast<char*>(data) - header_bytes;
+      size_t cap = capacity(data);
+      if(mapped(cap))
+      {
+         soa_map_deallocate(head, bytes(cap));
+      }
+      else
+      {
+         ::operator delete(head, std::align_val_t(alignment));
+      }
+   }
+
+   /** Construct or destroy elements at the back, n must not exceed the capacity
+    * @param policy execution policy that new elements are constructed with
+    * @param init how new elements are constructed
+    */
+   template < class ExecutionPolicy >
+   static void resize_in_place(ExecutionPolicy&& policy, T* data, size_t n, const soa_initializer<T>& init = {})
+   {
+      if(!data) return;
+      size_t old_size = size(data);
+      if(n < old_size)
+      {
+         std::destroy(data + n, data + old_size);
+      }
+      else
+      {
+         soa_for_each_partition(policy, old_size, n, [data, &init](size_t begin, size_t end)
+         {
+            init.construct(data + begin, data + end);
+         });
+      }
+      size(data) = n;
+   }
+
+   /** Move the first n elements into new storage of the given capacity
+    */
+   static void reallocate(T*& data, size_t capacity, size_t n)
+   {
+      if(soa_first_touch(n * sizeof(T)))
+      {
+         reallocate(soa_first_touch_policy, data, capacity, n);
+      }
+      else
+      {
+         reallocate(execution::seq, data, capacity, n);
+      }
+   }
+
+   /** Move the first n elements into new storage of the given capacity
+    * @param policy execution policy that the elements are moved with
+    */
+   template < class ExecutionPolicy >
+   static void reallocate(ExecutionPolicy&& policy, T*& data, size_t capacity, size_t n)
+   {
+      if(data && mapped(capacity) && mapped(soa_pointer_storage::capacity(data)))
+      {
+         // Elements are trivially destructible, the pages past n are simply dropped
+         char* head = reinterpret_cast<char*>(data) - header_bytes;
+         head = static_cast<char*>(soa_map_reallocate(head, bytes(soa_pointer_storage::capacity(data)), bytes(capacity)));
+         data = reinterpret_cast<T*>(head + header_bytes);
+         soa_pointer_storage::capacity(data) = capacity;
+         soa_pointer_storage::size(data) = n;
+         return;
+      }
+
+      T* new_data = nullptr;
+      if(capacity > 0)
+      {
+         new_data = allocate(capacity);
+         if(data)
+         {
+            T* old_data = data;
+            soa_for_each_partition(policy, 0, n, [old_data, new_data](size_t begin, size_t end)
+            {
+               std::uninitialized_move(old_data + begin, old_data + end, new_data + begin);
+            });
+         }
+         soa_pointer_storage::size(new_data) = n;
+      }
+      if(data)
+      {
+         std::destroy(data, data + size(data));
+         deallocate(data);
+      }
+      data = new_data;
+   }
+};
+
+/** Capacity to grow to when n elements do not fit in capacity
+ */
+inline size_t soa_grow_capacity(size_t capacity, size_t n) noexcept
+{
+   return std::max(n, 2 * capacity);
+}
+
 // SOA size_of handler
 template < class T, class  = void >
 struct soa_size_of;
@@ -66,6 +287,29 @@ struct soa_size_of<T,
    }
 };
 
+// SOA capacity handler
+template < class T, class = void >
+struct soa_capacity;
+
+template < class T >
+struct soa_capacity<T*,void>
+{
+   size_t operator()(const T* data) noexcept
+   {
+      if(!data) return 0;
+      return soa_pointer_storage<T>::capacity(const_cast<T*>(data));
+   }
+};
+
+template < class T >
+struct soa_capacity<T, std::void_t<decltype(std::declval<T>().capacity())> >
+{
+   size_t operator()(const T& data) noexcept
+   {
+      return data.capacity();
+   }
+};
+
 // SOA resize handler
 template < class T, class = void >
 struct soa_resize;
@@ -73,264 +317,1362 @@ struct soa_resize;
 template < class T >
 struct soa_resize<T*,void>
 {
-   void operator()(T*& data, size_t n)
+   void operator()(T*& data, size_t n, const soa_initializer<T>& init = {})
    {
-      bool needs_realloc = false;
-      auto old_size = soa_size_of<T*>()(data);
-      if(data)
+      if(soa_first_touch(n * sizeof(T)))
       {
-         // Check the pointer capacity, if it is greater than the size
-         size_t* x = (size_t*)((void*)data);
-         if(x[-2] >= n)
-         {
-            // Shrinking, effective old size is now new size
-            old_size = n;
-            // Reduce memory footprint
-            if(n < (x[-2] / 4))
-            {
-               needs_realloc = true;
-            }
-            x[-1] = n;
-         }
-         // Growing requires realloc
-         else
-         {
-            needs_realloc = true;
-         }
+         (*this)(data, soa_first_touch_policy, n, init);
       }
       else
       {
-         needs_realloc = true;
+         (*this)(data, execution::seq, n, init);
       }
+   }
+
+   /** Move and construct elements with an execution policy
+    */
+   template < class ExecutionPolicy,
+      class = std::enable_if_t<execution::is_execution_policy_v<ExecutionPolicy>> >
+   void operator()(T*& data, ExecutionPolicy&& policy, size_t n, const soa_initializer<T>& init = {})
+   {
+      using storage = soa_pointer_storage<T>;
+      size_t old_size = soa_size_of<T*>()(data);
+      size_t capacity = soa_capacity<T*>()(data);
 
-      if(needs_realloc)
+      if(n < old_size)
       {
-         T* old_data = data;
-         // Allocate the memory for the new size data
-         auto head = new char[sizeof(T) * n + sizeof(size_t)*2];
-         // Set the size in front of the allocation
-         reinterpret_cast<size_t*>(head)[0] = n;
-         reinterpret_cast<size_t*>(head)[1] = n;
-         // Initialize the data pointer and use the offset head
-         data = new((T*)(head + sizeof(size_t) * 2)) T[n]();
-         // Copy the old data into the new data
-         std::copy(old_data, old_data + old_size, data);
-         // Clean up the old memory if previously allocated
-         if(old_data)
+         std::destroy(data + n, data + old_size);
+         storage::size(data) = n;
+         // Reduce memory footprint
+         if(n < capacity / 4)
          {
-            size_t* old_head = (size_t*)((void*)old_data);
-            old_head = &(old_head[-2]);
-            delete[] (T*)old_head;
+            storage::reallocate(data, n, n);
          }
+         return;
+      }
+
+      // Growing past the capacity moves the old elements once, only the new
+      // tail is constructed
+      if(n > capacity)
+      {
+         storage::reallocate(policy, data, soa_grow_capacity(capacity, n), old_size);
+      }
+      if(n > old_size)
+      {
+         storage::resize_in_place(policy, data, n, init);
       }
-      // TODO
-      // std::fill(data + old_size, data + n, default_value);
    }
 };
 
+template < class T, class V, class = void >
+struct soa_has_fill_resize: std::false_type {};
+
+template < class T, class V >
+struct soa_has_fill_resize<T, V, std::void_t<decltype(std::declval<T&>().resize(std::declval<size_t>(), std::declval<const V&>()))> >:
+   std::true_type
+{};
+
 template < class T >
 struct soa_resize<T, std::void_t<decltype(std::declval<T>().resize(std::declval<size_t>()))> >
 {
-   size_t operator()(T& data, size_t n)
+   using value_type = typename soa_element_value_type<T>::value_type;
+
+   void operator()(T& data, size_t n, const soa_initializer<value_type>& init = {})
    {
-      data.resize(n);
-      // TODO
-      // std::fill(data + old_size, data + n, default_value);
+      // Containers always construct their elements, uninitialized does not apply
+      if(!init.value)
+      {
+         data.resize(n);
+      }
+      else if constexpr(soa_has_fill_resize<T, value_type>::value)
+      {
+         data.resize(n, *init.value);
+      }
+      else
+      {
+         size_t old_size = data.size();
+         data.resize(n);
+         for(size_t i = old_size; i < n; ++i) data[i] = *init.value;
+      }
    }
-};
 
-template < class T >
-struct soa_dtor
-{
-   void operator()(T& data)
+   /** Containers construct their elements themselves, the policy is ignored
+    */
+   template < class ExecutionPolicy,
+      class = std::enable_if_t<execution::is_execution_policy_v<ExecutionPolicy>> >
+   void operator()(T& data, ExecutionPolicy&&, size_t n, const soa_initializer<value_type>& init = {})
    {
+      (*this)(data, n, init);
    }
 };
 
+// SOA resize handler of raw pointer columns held by a shared storage
+// allocator, which never reallocates
 template < class T >
-struct soa_dtor<T*>
+struct soa_resize_in_place;
+
+template < class T >
+struct soa_resize_in_place<T*>
 {
-   void operator()(T*& data)
+   template < class ExecutionPolicy >
+   void operator()(T*& data, ExecutionPolicy&& policy, size_t n, const soa_initializer<T>& init = {})
    {
-      if(!data) return;
-      size_t* x = reinterpret_cast<size_t*>(data);
-      x = x - 2;
-      delete[] reinterpret_cast<char*>(x);
-      data = nullptr;
+      soa_pointer_storage<T>::resize_in_place(policy, data, n, init);
    }
 };
 
+// SOA reserve handler
+template < class T, class = void >
+struct soa_reserve;
+
 template < class T >
-struct soa_reorder
+struct soa_reserve<T*,void>
 {
-   template < class Int, class = std::enable_if_t<std::is_integral<Int>::value> >
-   void operator()(T& data, const std::vector<Int>& new_index_map)
+   void operator()(T*& data, size_t n)
+   {
+      if(n > soa_capacity<T*>()(data))
+      {
+         soa_pointer_storage<T>::reallocate(data, n, soa_size_of<T*>()(data));
+      }
+   }
+
+   template < class ExecutionPolicy >
+   void operator()(T*& data, ExecutionPolicy&& policy, size_t n)
    {
-      Int N = soa_size_of<T>()(data);
-      T copy_buffer = T();
-      soa_resize<T>()(copy_buffer, N);
-      for(Int i = 0; i < N; i++)
+      if(n > soa_capacity<T*>()(data))
       {
-         copy_buffer[i] = data[i];
+         soa_pointer_storage<T>::reallocate(policy, data, n, soa_size_of<T*>()(data));
       }
-      std::swap(data, copy_buffer);
-      soa_dtor<T>()(copy_buffer);
    }
 };
 
-template < template<class> class CallBack, class Tuple, class Args, size_t... Indices >
-void for_each_impl(Tuple&& data, Args&& args, std::index_sequence<Indices...>)
+template < class T >
+struct soa_reserve<T, std::void_t<decltype(std::declval<T>().reserve(std::declval<size_t>()))> >
 {
-   using eval = int[];
-   (void)eval{1,
-      (std::apply(CallBack<std::tuple_element_t<Indices,std::remove_reference_t<Tuple>>>(), std::tuple_cat(std::forward_as_tuple(std::get<Indices>(std::forward<Tuple>(data))), args)), void(), int{})...};
-}
+   void operator()(T& data, size_t n)
+   {
+      data.reserve(n);
+   }
 
-template < template<class> class CallBack, class Tuple, class... Args >
-void for_each(Tuple&& data, Args&&... args)
-{
-   for_each_impl<CallBack>(std::forward<Tuple>(data), std::forward_as_tuple(args...), std::make_index_sequence<std::tuple_size<std::remove_reference_t<Tuple>>::value>());
-}
+   template < class ExecutionPolicy >
+   void operator()(T& data, ExecutionPolicy&&, size_t n)
+   {
+      data.reserve(n);
+   }
+};
 
-template < class CallBack, class SOATuple, class ArgsTuple, size_t... Indices >
-decltype(auto)
-apply_to_element_impl(SOATuple&& soa_args, size_t i, CallBack&& f, ArgsTuple&& args, std::index_sequence<Indices...>)
-{
-   return std::apply(std::forward<CallBack>(f), std::tuple_cat(std::forward_as_tuple((std::get<Indices>(std::forward<SOATuple>(soa_args))[i])...), std::forward<ArgsTuple>(args))); ;
-}
+// SOA shrink_to_fit handler
+template < class T, class = void >
+struct soa_shrink_to_fit;
 
-template < class SOATuple, size_t... Indices >
-decltype(auto)
-get_element_impl(const SOATuple& soa_args, size_t i, std::index_sequence<Indices...>)
+template < class T >
+struct soa_shrink_to_fit<T*,void>
 {
-   return std::make_tuple(std::get<Indices>(soa_args)[i]...);
-}
-
-template < class T, class... Types >
-struct type_in_list;
-
-template < class T, class T1, class... Types >
-struct type_in_list<T, T1, Types...>: 
-   xlib::mpl::if_t<std::is_convertible<T*,T1*>,
-      std::true_type, type_in_list<T, Types...>
-   >
-{};
+   void operator()(T*& data)
+   {
+      size_t n = soa_size_of<T*>()(data);
+      if(soa_capacity<T*>()(data) > n)
+      {
+         soa_pointer_storage<T>::reallocate(data, n, n);
+      }
+   }
+};
 
-/** Empty list case
- */
 template < class T >
-struct type_in_list<T>: std::false_type
-{};
-
-template < class T, class... Types >
-inline constexpr bool type_in_list_v = type_in_list<T,Types...>::value;
-
-template < class Tuple, size_t... Indices >
-decltype(auto) forward_tuple_indices(Tuple&& data, std::index_sequence<Indices...>)
+struct soa_shrink_to_fit<T, std::void_t<decltype(std::declval<T>().shrink_to_fit())> >
 {
-   return std::forward_as_tuple(std::get<Indices>(data)...);
-}
+   void operator()(T& data)
+   {
+      data.shrink_to_fit();
+   }
+};
 
-} // namespace detail
+// SOA contiguous data handler
+template < class T, class = void >
+struct soa_data;
 
-template < class... Types >
-template < size_t I >
-static_soa<Types...>::meta_handle_t<I> static_soa<Types...>::get_handle()
+template < class T >
+struct soa_data<T*,void>
 {
-   return meta_handle_t<I>(this);
-}
+   T* operator()(T* data) noexcept
+   {
+      return data;
+   }
+};
 
-template < class... Types >
-template < size_t I >
-static_soa<Types...>::reference<I> static_soa<Types...>::get_data() noexcept
+template < class T >
+struct soa_data<T, std::void_t<decltype(std::declval<T&>().data())> >
 {
-   return std::get<I>(_data);
-}
+   auto operator()(T& data) noexcept
+   {
+      return data.data();
+   }
+};
 
-template < class... Types >
-template < class T, size_t I >
-static_soa<Types...>::reference<I> static_soa<Types...>::get_data(const meta_handle<T,I>& mh) noexcept
+template < class T >
+struct soa_dtor
 {
-   assert(mh.parent() == this);
-   static_assert(std::is_same_v<meta_handle<T,I>::value_type, static_soa<Types...>::value_type<I>>, "Mismatch between meta handle and static_soa types");
-
-   return mh.data();
-}
+   void operator()(T& data)
+   {
+   }
+};
 
-template < class... Types >
 template < class T >
-T& static_soa<Types...>::get_data(const handle& h)
+struct soa_dtor<T*>
 {
-   static_assert(detail::type_in_list_v<T, Types...>, "Attempting to extract ");
-   return h.template data<T>();
-}
+   void operator()(T*& data)
+   {
+      if(!data) return;
+      soa_pointer_storage<T>::reallocate(data, 0, 0);
+   }
+};
 
-template < class... Types >
-template < size_t I >
-static_soa<Types...>::const_reference<I> static_soa<Types...>::get_data() const noexcept
+/** Permutation of the elements of a static_soa
+ *
+ * Element i moves to new_index_map[i]. The non-trivial cycles of the
+ * permutation are found once and shared by all of the columns, so reordering
+ * a column in place needs no scratch storage.
+ */
+template < class Int >
+struct soa_permutation
 {
-   return std::get<I>(_data);
+   explicit soa_permutation(const std::vector<Int>& new_index_map):
+      map(new_index_map.data()),
+      n(new_index_map.size())
+   {
+      std::vector<bool> visited(n, false);
+      for(size_t i = 0; i < n; ++i)
+      {
+         if(visited[i]) continue;
+         size_t length = 0;
+         for(size_t j = i; !visited[j]; j = static_cast<size_t>(map[j]), ++length)
+         {
+            assert(static_cast<size_t>(map[j]) < n && "new_index_map is not a permutation");
+            visited[j] = true;
+         }
+         if(length > 1) cycle_leaders.push_back(i);
+      }
+   }
+
+   size_t operator[](size_t i) const noexcept
+   {
+      return static_cast<size_t>(map[i]);
+   }
+
+   const Int* map;
+   size_t n;
+   std::vector<size_t> cycle_leaders;
+};
+
+/** Permute the elements of an indexable container in place by following the
+ * cycles of the permutation
+ */
+template < class T, class Int >
+void soa_permute_in_place(T& data, const soa_permutation<Int>& perm)
+{
+   for(size_t s: perm.cycle_leaders)
+   {
+      auto carry = std::move(data[s]);
+      for(size_t j = perm[s]; j != s; j = perm[j])
+      {
+         std::swap(carry, data[j]);
+      }
+      data[s] = std::move(carry);
+   }
+}
+
+// SOA reorder handler
+template < class T >
+struct soa_reorder
+{
+   template < class Int >
+   void operator()(T& data, const soa_permutation<Int>& perm)
+   {
+      soa_permute_in_place(data, perm);
+   }
+
+   /** Scatter into a new container in parallel and replace the old one
+    */
+   template < class ExecutionPolicy, class Int >
+   void operator()(T& data, ExecutionPolicy&& policy, const soa_permutation<Int>& perm)
+   {
+      T scattered = T();
+      soa_resize<T>()(scattered, perm.n);
+      parallel_for(policy, 0, perm.n, [&](size_t begin, size_t end)
+      {
+         for(size_t i = begin; i < end; ++i)
+         {
+            scattered[perm[i]] = std::move(data[i]);
+         }
+      });
+      std::swap(data, scattered);
+      soa_dtor<T>()(scattered);
+   }
+};
+
+template < class T >
+struct soa_reorder<T*>
+{
+   template < class Int >
+   void operator()(T*& data, const soa_permutation<Int>& perm)
+   {
+      soa_permute_in_place(data, perm);
+   }
+
+   /** Scatter into uninitialized storage in parallel and replace the old storage
+    */
+   template < class ExecutionPolicy, class Int >
+   void operator()(T*& data, ExecutionPolicy&& policy, const soa_permutation<Int>& perm)
+   {
+      using storage = soa_pointer_storage<T>;
+      if(perm.n == 0) return;
+
+      T* scattered = storage::allocate(soa_capacity<T*>()(data));
+      parallel_for(policy, 0, perm.n, [&](size_t begin, size_t end)
+      {
+         for(size_t i = begin; i < end; ++i)
+         {
+            ::new(static_cast<void*>(scattered + perm[i])) T(std::move(data[i]));
+         }
+      });
+      storage::size(scattered) = perm.n;
+      std::swap(data, scattered);
+      soa_dtor<T*>()(scattered);
+   }
+};
+
+// SOA element move handler
+template < class T >
+struct soa_move_element
+{
+   void operator()(T& data, size_t dst, size_t src)
+   {
+      data[dst] = std::move(data[src]);
+   }
+};
+
+/** Move elements to the front of a column in place
+ */
+template < class T >
+struct soa_compact
+{
+   /** Element survivors[j] moves to j, survivors must be increasing
+    */
+   void operator()(T& data, const std::vector<size_t>& survivors)
+   {
+      size_t j = 0;
+      while(j < survivors.size() && survivors[j] == j) ++j;
+      for(; j < survivors.size(); ++j)
+      {
+         soa_move_element<T>()(data, j, survivors[j]);
+      }
+   }
+
+   /** Element move.second moves to move.first
+    */
+   void operator()(T& data, const std::vector<std::pair<size_t,size_t>>& moves)
+   {
+      for(auto& m: moves)
+      {
+         soa_move_element<T>()(data, m.first, m.second);
+      }
+   }
+};
+
+// SOA gather handler, replaces a column with the elements at the given indices
+template < class T >
+struct soa_gather
+{
+   template < class ExecutionPolicy >
+   void operator()(T& data, ExecutionPolicy&& policy, const std::vector<size_t>& src)
+   {
+      T gathered = T();
+      soa_resize<T>()(gathered, src.size());
+      parallel_for(policy, 0, src.size(), [&](size_t begin, size_t end)
+      {
+         for(size_t j = begin; j < end; ++j)
+         {
+            gathered[j] = std::move(data[src[j]]);
+         }
+      });
+      std::swap(data, gathered);
+      soa_dtor<T>()(gathered);
+   }
+};
+
+template < class T >
+struct soa_gather<T*>
+{
+   template < class ExecutionPolicy >
+   void operator()(T*& data, ExecutionPolicy&& policy, const std::vector<size_t>& src)
+   {
+      using storage = soa_pointer_storage<T>;
+      if(src.empty())
+      {
+         soa_dtor<T*>()(data);
+         return;
+      }
+
+      T* gathered = storage::allocate(src.size());
+      parallel_for(policy, 0, src.size(), [&](size_t begin, size_t end)
+      {
+         for(size_t j = begin; j < end; ++j)
+         {
+            ::new(static_cast<void*>(gathered + j)) T(std::move(data[src[j]]));
+         }
+      });
+      storage::size(gathered) = src.size();
+      std::swap(data, gathered);
+      soa_dtor<T*>()(gathered);
+   }
+};
+
+template < template<class> class CallBack, class Tuple, class Args, size_t... Indices >
+void for_each_impl(Tuple&& data, Args&& args, std::index_sequence<Indices...>)
+{
+   using eval = int[];
+   (void)eval{1,
+      (std::apply(CallBack<std::remove_reference_t<std::tuple_element_t<Indices,std::remove_reference_t<Tuple>>>>(), std::tuple_cat(std::forward_as_tuple(std::get<Indices>(std::forward<Tuple>(data))), args)), void(), int{})...};
+}
+
+template < template<class> class CallBack, class Tuple, class... Args >
+void for_each(Tuple&& data, Args&&... args)
+{
+   for_each_impl<CallBack>(std::forward<Tuple>(data), std::forward_as_tuple(args...), std::make_index_sequence<std::tuple_size<std::remove_reference_t<Tuple>>::value>());
+}
+
+template < class CallBack, class SOATuple, class ArgsTuple, size_t... Indices >
+decltype(auto)
+apply_to_element_impl(SOATuple&& soa_args, size_t i, CallBack&& f, ArgsTuple&& args, std::index_sequence<Indices...>)
+{
+   return std::apply(std::forward<CallBack>(f), std::tuple_cat(std::forward_as_tuple((std::get<Indices>(std::forward<SOATuple>(soa_args))[i])...), std::forward<ArgsTuple>(args))); ;
+}
+
+template < class CallBack, class SOATuple, class ArgsTuple, size_t... Indices >
+void apply_to_block_impl(SOATuple& soa_args, size_t begin, size_t n, CallBack& f, ArgsTuple& args, std::index_sequence<Indices...>)
+{
+   std::apply(f, std::tuple_cat(
+      std::make_tuple(begin, n, (soa_data<std::tuple_element_t<Indices,SOATuple>>()(std::get<Indices>(soa_args)) + begin)...),
+      args));
 }
 
-template < class... Types >
+template < size_t BlockSize, class CallBack, class SOATuple, class ArgsTuple >
+void apply_blocked_range(SOATuple& soa_args, size_t begin, size_t end, CallBack& f, ArgsTuple& args)
+{
+   for(size_t b = begin; b < end; b += BlockSize)
+   {
+      apply_to_block_impl(soa_args, b, std::min(BlockSize, end - b), f, args, std::make_index_sequence<std::tuple_size<SOATuple>::value>());
+   }
+}
+
+template < class SOATuple, size_t... Indices >
+decltype(auto)
+get_element_impl(const SOATuple& soa_args, size_t i, std::index_sequence<Indices...>)
+{
+   return std::make_tuple(std::get<Indices>(soa_args)[i]...);
+}
+
+template < class T, class... Types >
+struct type_in_list;
+
+template < class T, class T1, class... Types >
+struct type_in_list<T, T1, Types...>: 
+   xlib::mpl::if_t<std::is_convertible<T*,T1*>,
+      std::true_type, type_in_list<T, Types...>
+   >
+{};
+
+/** Empty list case
+ */
+template < class T >
+struct type_in_list<T>: std::false_type
+{};
+
+template < class T, class... Types >
+inline constexpr bool type_in_list_v = type_in_list<T,Types...>::value;
+
+template < class Tuple, size_t... Indices >
+decltype(auto) forward_tuple_indices(Tuple&& data, std::index_sequence<Indices...>)
+{
+   return std::forward_as_tuple(std::get<Indices>(data)...);
+}
+
+} // namespace detail
+
+inline soa_arena_allocator::soa_arena_allocator(soa_arena_allocator&& other) noexcept:
+   _slab(std::exchange(other._slab, nullptr)),
+   _bytes(std::exchange(other._bytes, 0)),
+   _capacity(std::exchange(other._capacity, 0))
+{}
+
+inline soa_arena_allocator& soa_arena_allocator::operator=(soa_arena_allocator&& other) noexcept
+{
+   std::swap(_slab, other._slab);
+   std::swap(_bytes, other._bytes);
+   std::swap(_capacity, other._capacity);
+   return *this;
+}
+
+inline soa_arena_allocator::~soa_arena_allocator()
+{
+   if(_slab) detail::soa_arena_deallocate(_slab, _bytes);
+}
+
+template < class Tuple, size_t... Indices, class Move >
+void soa_arena_allocator::reallocate(Tuple& columns, std::index_sequence<Indices...>, size_t capacity, size_t n, Move&& move)
+{
+   static_assert(sizeof...(Indices) > 0, "soa_arena_allocator needs at least one raw pointer column");
+   assert(n <= capacity);
+
+   // Lay out the columns, each with its header in front of its aligned data,
+   // starting at a different cache line of a page
+   size_t offsets[sizeof...(Indices)];
+   size_t k = 0, cursor = 0;
+   auto place = [&](auto* tag)
+   {
+      using storage = detail::soa_pointer_storage<std::remove_pointer_t<decltype(tag)>>;
+      static_assert(storage::alignment <= page_size, "soa_arena_allocator supports column alignments up to the page size");
+      size_t stagger = (k * std::max<size_t>(storage::alignment, 64)) % page_size;
+      size_t data = (cursor + storage::header_bytes + storage::alignment - 1) / storage::alignment * storage::alignment;
+      data += (stagger + page_size - data % page_size) % page_size;
+      offsets[k++] = data;
+      cursor = data + capacity * sizeof(*tag);
+   };
+   (place(static_cast<std::tuple_element_t<Indices,Tuple>>(nullptr)), ...);
+
+   size_t bytes = capacity > 0 ? (cursor + page_size - 1) / page_size * page_size : 0;
+   char* slab = bytes > 0 ? static_cast<char*>(detail::soa_arena_allocate(bytes)) : nullptr;
+
+   k = 0;
+   auto move_column = [&](auto*& data)
+   {
+      using storage = detail::soa_pointer_storage<std::remove_pointer_t<std::remove_reference_t<decltype(data)>>>;
+      decltype(data + 0) moved = nullptr;
+      if(slab)
+      {
+         moved = reinterpret_cast<decltype(moved)>(slab + offsets[k]);
+         storage::capacity(moved) = capacity;
+         move(data, moved);
+         storage::size(moved) = n;
+      }
+      if(data) std::destroy(data, data + storage::size(data));
+      data = moved;
+      k++;
+   };
+   (move_column(std::get<Indices>(columns)), ...);
+
+   if(_slab) detail::soa_arena_deallocate(_slab, _bytes);
+   _slab = slab;
+   _bytes = bytes;
+   _capacity = capacity;
+}
+
+template < class Tuple, size_t... Indices >
+void soa_arena_allocator::release(Tuple& columns, std::index_sequence<Indices...>) noexcept
+{
+   auto destroy = [](auto*& data)
+   {
+      if(!data) return;
+      using storage = detail::soa_pointer_storage<std::remove_pointer_t<std::remove_reference_t<decltype(data)>>>;
+      std::destroy(data, data + storage::size(data));
+      data = nullptr;
+   };
+   (destroy(std::get<Indices>(columns)), ...);
+
+   if(_slab) detail::soa_arena_deallocate(_slab, _bytes);
+   _slab = nullptr;
+   _bytes = 0;
+   _capacity = 0;
+}
+
+template < class Allocator, class... Types >
+basic_static_soa<Allocator, Types...>::basic_static_soa(basic_static_soa&& other) noexcept
+{
+   std::swap(_data, other._data);
+   std::swap(_allocator, other._allocator);
+   std::swap(_defaults, other._defaults);
+   std::swap(_observers, other._observers);
+   _dirty.swap(other._dirty);
+   std::swap(_dirty_epoch, other._dirty_epoch);
+   this->notify([this](observer& o) { o.relocated(this); });
+}
+
+template < class Allocator, class... Types >
+basic_static_soa<Allocator, Types...>& basic_static_soa<Allocator, Types...>::operator=(basic_static_soa&& other) noexcept
+{
+   std::swap(_data, other._data);
+   std::swap(_allocator, other._allocator);
+   std::swap(_defaults, other._defaults);
+   std::swap(_observers, other._observers);
+   _dirty.swap(other._dirty);
+   std::swap(_dirty_epoch, other._dirty_epoch);
+   this->notify([this](observer& o) { o.relocated(this); });
+   other.notify([&other](observer& o) { o.relocated(&other); });
+   return *this;
+}
+
+template < class Allocator, class... Types >
+basic_static_soa<Allocator, Types...>::~basic_static_soa()
+{
+   this->notify([](observer& o) { o.relocated(nullptr); });
+   if constexpr(Allocator::shared_storage)
+   {
+      this->apply_to_indices<detail::soa_dtor>(container_indices());
+      _allocator.release(_data, pointer_indices());
+   }
+   else
+   {
+      this->apply<detail::soa_dtor>();
+   }
+}
+
+template < class Allocator, class... Types >
+template < size_t I >
+typename basic_static_soa<Allocator, Types...>::template meta_handle_t<I> basic_static_soa<Allocator, Types...>::get_handle()
+{
+   return meta_handle_t<I>(this);
+}
+
+template < class Allocator, class... Types >
+template < size_t I >
+typename basic_static_soa<Allocator, Types...>::template reference<I> basic_static_soa<Allocator, Types...>::get_data() noexcept
+{
+   return std::get<I>(_data);
+}
+
+template < class Allocator, class... Types >
+template < class T, size_t I >
+typename basic_static_soa<Allocator, Types...>::template reference<I> basic_static_soa<Allocator, Types...>::get_data(const meta_handle<T,I>& mh) noexcept
+{
+   assert(mh.parent() == this);
+   static_assert(std::is_same_v<typename meta_handle<T,I>::value_type, value_type<I>>, "Mismatch between meta handle and static_soa types");
+
+   return mh.data();
+}
+
+template < class Allocator, class... Types >
+template < class T >
+T& basic_static_soa<Allocator, Types...>::get_data(const handle& h)
+{
+   static_assert(detail::type_in_list_v<T, Types...>, "Attempting to extract ");
+   return h.template data<T>();
+}
+
+template < class Allocator, class... Types >
+template < size_t I >
+typename basic_static_soa<Allocator, Types...>::template const_reference<I> basic_static_soa<Allocator, Types...>::get_data() const noexcept
+{
+   return std::get<I>(_data);
+}
+
+template < class Allocator, class... Types >
 template < template<class> class CallBack, class Indices, class... Args >
-void static_soa<Types...>::apply_to_indices(Indices&& indices, Args&&... args)
+void basic_static_soa<Allocator, Types...>::apply_to_indices(Indices&& indices, Args&&... args)
 {
    detail::for_each<CallBack>(detail::forward_tuple_indices(_data, std::forward<Indices>(indices)), std::forward<Args>(args)...);
 }
 
-template < class... Types >
+template < class Allocator, class... Types >
 template < template<class> class CallBack, class... Args >
-void static_soa<Types...>::apply(Args&&... args)
+void basic_static_soa<Allocator, Types...>::apply(Args&&... args)
 {
    this->apply_to_indices<CallBack>(std::index_sequence_for<Types...>(), std::forward<Args>(args)...);
 }
 
-template < class... Types >
+template < class Allocator, class... Types >
 template < class CallBack, class... Args >
 decltype(auto)
-static_soa<Types...>::apply_to_element(size_t i, CallBack&& f, Args&&... args)
+basic_static_soa<Allocator, Types...>::apply_to_element(size_t i, CallBack&& f, Args&&... args)
 {
-   return detail::apply_to_element_impl(_data, i, std::forward<CallBack>(f), std::forward_as_tuple<Args...>(args...), std::make_index_sequence<sizeof...(Types)>());
+   if(_dirty.enabled()) _dirty.mark_all(i, i + 1);
+   return this->invoke_element(i, std::forward<CallBack>(f), std::forward<Args>(args)...);
 }
 
-template < class... Types >
+template < class Allocator, class... Types >
 template < class CallBack, class... Args >
-void static_soa<Types...>::apply_per_element(CallBack&& f, Args&&... args)
+decltype(auto) basic_static_soa<Allocator, Types...>::invoke_element(size_t i, CallBack&& f, Args&&... args)
 {
+   return detail::apply_to_element_impl(_data, i, std::forward<CallBack>(f), std::forward_as_tuple(std::forward<Args>(args)...), std::make_index_sequence<sizeof...(Types)>());
+}
+
+template < class Allocator, class... Types >
+template < class CallBack, class... Args >
+void basic_static_soa<Allocator, Types...>::apply_per_element(CallBack&& f, Args&&... args)
+{
+   XLIB_PROFILE_SCOPE("static_soa::apply_per_element");
    size_t n = this->size();
+   if(_dirty.enabled()) _dirty.mark_all(0, n);
    for(size_t i = 0; i < n; ++i)
    {
-      apply_to_element(i, std::forward<CallBack>(f), i, std::forward<Args>(args)...);
+      invoke_element(i, f, i, args...);
    }
 }
 
-template < class... Types >
-decltype(auto) static_soa<Types...>::get_element(size_t i)
+template < class Allocator, class... Types >
+template < class ExecutionPolicy, class CallBack, class... Args, class >
+void basic_static_soa<Allocator, Types...>::apply_per_element(ExecutionPolicy&& policy, CallBack&& f, Args&&... args)
+{
+   XLIB_PROFILE_SCOPE("static_soa::apply_per_element");
+   using policy_t = std::remove_cv_t<std::remove_reference_t<ExecutionPolicy>>;
+   if(_dirty.enabled()) _dirty.mark_all(0, this->size());
+   detail::parallel_for(policy, 0, this->size(), [&](size_t begin, size_t end)
+   {
+      XLIB_PROFILE_SCOPE("static_soa::apply_per_element::chunk");
+      if constexpr(std::is_same_v<policy_t, execution::parallel_unsequenced_policy>)
+      {
+         XLIB_PRAGMA_IVDEP
+         for(size_t i = begin; i < end; ++i)
+         {
+            invoke_element(i, f, i, args...);
+         }
+      }
+      else
+      {
+         for(size_t i = begin; i < end; ++i)
+         {
+            invoke_element(i, f, i, args...);
+         }
+      }
+   });
+}
+
+template < class Allocator, class... Types >
+template < size_t BlockSize, class CallBack, class... Args >
+void basic_static_soa<Allocator, Types...>::apply_blocked(CallBack&& f, Args&&... args)
+{
+   static_assert(BlockSize > 0, "apply_blocked requires a non-zero block size");
+   auto extra = std::forward_as_tuple(args...);
+   if(_dirty.enabled()) _dirty.mark_all(0, this->size());
+   detail::apply_blocked_range<BlockSize>(_data, 0, this->size(), f, extra);
+}
+
+template < class Allocator, class... Types >
+template < size_t BlockSize, class ExecutionPolicy, class CallBack, class... Args, class >
+void basic_static_soa<Allocator, Types...>::apply_blocked(ExecutionPolicy&& policy, CallBack&& f, Args&&... args)
+{
+   static_assert(BlockSize > 0, "apply_blocked requires a non-zero block size");
+   auto extra = std::forward_as_tuple(args...);
+   size_t n = this->size();
+   if(_dirty.enabled()) _dirty.mark_all(0, n);
+   detail::parallel_for(detail::round_chunks(policy, n, BlockSize), 0, n, [&](size_t begin, size_t end)
+   {
+      detail::apply_blocked_range<BlockSize>(_data, begin, end, f, extra);
+   });
+}
+
+template < class Allocator, class... Types >
+template < size_t I, class BinaryOp, class T, class >
+T basic_static_soa<Allocator, Types...>::reduce(BinaryOp op, T init) const
+{
+   return this->reduce<I>(execution::seq, op, init);
+}
+
+template < class Allocator, class... Types >
+template < size_t I, class ExecutionPolicy, class BinaryOp, class T, class >
+T basic_static_soa<Allocator, Types...>::reduce(ExecutionPolicy&& policy, BinaryOp op, T init) const
+{
+   XLIB_PROFILE_SCOPE("static_soa::reduce");
+   const auto& column = std::get<I>(_data);
+   auto load = [&column](size_t i) { return static_cast<T>(column[i]); };
+   return detail::soa_reduce(policy, this->size(), init, load, op);
+}
+
+template < class Allocator, class... Types >
+template < size_t I >
+detail::soa_accumulator_t<typename basic_static_soa<Allocator, Types...>::template element_type<I>>
+basic_static_soa<Allocator, Types...>::sum() const
 {
+   return this->sum<I>(execution::seq);
+}
+
+template < class Allocator, class... Types >
+template < size_t I, class ExecutionPolicy, class >
+detail::soa_accumulator_t<typename basic_static_soa<Allocator, Types...>::template element_type<I>>
+basic_static_soa<Allocator, Types...>::sum(ExecutionPolicy&& policy) const
+{
+   using acc_t = detail::soa_accumulator_t<element_type<I>>;
+   return this->reduce<I>(policy, std::plus<acc_t>(), acc_t());
+}
+
+template < class Allocator, class... Types >
+template < class Transform, class BinaryOp, class >
+auto basic_static_soa<Allocator, Types...>::transform_reduce(Transform f, BinaryOp op)
+{
+   return this->transform_reduce(execution::seq, f, op);
+}
+
+template < class Allocator, class... Types >
+template < class Transform, class BinaryOp, class T, class >
+T basic_static_soa<Allocator, Types...>::transform_reduce(Transform f, BinaryOp op, T init)
+{
+   return this->transform_reduce(execution::seq, f, op, init);
+}
+
+template < class Allocator, class... Types >
+template < class ExecutionPolicy, class Transform, class BinaryOp, class >
+auto basic_static_soa<Allocator, Types...>::transform_reduce(ExecutionPolicy&& policy, Transform f, BinaryOp op)
+{
+   using value_t = std::decay_t<decltype(detail::apply_to_element_impl(_data, 0, f, std::make_tuple(size_t(0)), std::index_sequence_for<Types...>()))>;
+   using acc_t = detail::soa_accumulator_t<value_t>;
+   return this->transform_reduce(policy, f, op, acc_t());
+}
+
+template < class Allocator, class... Types >
+template < class ExecutionPolicy, class Transform, class BinaryOp, class T, class >
+T basic_static_soa<Allocator, Types...>::transform_reduce(ExecutionPolicy&& policy, Transform f, BinaryOp op, T init)
+{
+   XLIB_PROFILE_SCOPE("static_soa::transform_reduce");
+   auto load = [&](size_t i) { return static_cast<T>(this->invoke_element(i, f, i)); };
+   return detail::soa_reduce(policy, this->size(), init, load, op);
+}
+
+template < class Allocator, class... Types >
+decltype(auto) basic_static_soa<Allocator, Types...>::get_element(size_t i)
+{
+   if(_dirty.enabled()) _dirty.mark_all(i, i + 1);
    return detail::get_element_impl(_data, i, std::make_index_sequence<sizeof...(Types)>());
 }
 
-template < class... Types >
-void static_soa<Types...>::resize(size_t n)
+template < class Allocator, class... Types >
+void basic_static_soa<Allocator, Types...>::resize(size_t n)
+{
+   size_t old_size = this->size();
+   this->resize_impl(n, false);
+   this->notify([&](observer& o) { o.resized(*this, old_size); });
+}
+
+template < class Allocator, class... Types >
+template < class ExecutionPolicy, class >
+void basic_static_soa<Allocator, Types...>::resize(ExecutionPolicy&& policy, size_t n)
+{
+   size_t old_size = this->size();
+   this->resize_impl(n, false, policy);
+   this->notify([&](observer& o) { o.resized(*this, old_size); });
+}
+
+template < class Allocator, class... Types >
+void basic_static_soa<Allocator, Types...>::resize(size_t n, uninitialized_t)
+{
+   size_t old_size = this->size();
+   this->resize_impl(n, true);
+   this->notify([&](observer& o) { o.resized(*this, old_size); });
+}
+
+template < class Allocator, class... Types >
+template < class ExecutionPolicy, class >
+void basic_static_soa<Allocator, Types...>::resize(ExecutionPolicy&& policy, size_t n, uninitialized_t)
+{
+   size_t old_size = this->size();
+   this->resize_impl(n, true, policy);
+   this->notify([&](observer& o) { o.resized(*this, old_size); });
+}
+
+template < class Allocator, class... Types >
+template < size_t I >
+void basic_static_soa<Allocator, Types...>::set_default(const element_type<I>& value)
+{
+   std::get<I>(_defaults) = value;
+}
+
+template < class Allocator, class... Types >
+template < size_t I >
+void basic_static_soa<Allocator, Types...>::reset_default() noexcept
+{
+   std::get<I>(_defaults).reset();
+}
+
+template < class Allocator, class... Types >
+template < size_t I >
+typename basic_static_soa<Allocator, Types...>::template element_type<I> basic_static_soa<Allocator, Types...>::get_default() const
+{
+   detail::soa_initializer<element_type<I>> init = this->initializer<I>(false);
+   return init.value ? *init.value : element_type<I>();
+}
+
+template < class Allocator, class... Types >
+template < size_t I >
+detail::soa_initializer<typename basic_static_soa<Allocator, Types...>::template element_type<I>>
+basic_static_soa<Allocator, Types...>::initializer(bool uninitialized) const noexcept
 {
-   this->apply<detail::soa_resize>(n);
+   using element_t = element_type<I>;
+   detail::soa_initializer<element_t> init;
+   init.uninitialized = uninitialized;
+   if(std::get<I>(_defaults))
+   {
+      init.value = &*std::get<I>(_defaults);
+   }
+   else if constexpr(detail::soa_has_default_value<element_t>::value)
+   {
+      init.value = &soa_default_value<element_t>::value;
+   }
+   return init;
 }
 
-template < class... Types >
-size_t static_soa<Types...>::size() const noexcept
+template < class Allocator, class... Types >
+template < class... ExecutionPolicy >
+void basic_static_soa<Allocator, Types...>::resize_impl(size_t n, bool uninitialized, ExecutionPolicy&&... policy)
 {
-   return detail::soa_size_of<static_soa<Types...>::value_type<0>>()(std::get<0>(_data));
+   XLIB_PROFILE_SCOPE("static_soa::resize");
+   if(_dirty.enabled())
+   {
+      size_t old_size = this->size();
+      _dirty.resize(n);
+      if(n > old_size) _dirty.mark_all(old_size, n);
+   }
+   if constexpr(Allocator::shared_storage)
+   {
+      this->resize_columns<detail::soa_resize>(container_indices(), n, uninitialized, policy...);
+      if constexpr(sizeof...(ExecutionPolicy) > 0)
+      {
+         this->resize_shared(policy..., n, uninitialized);
+      }
+      else if(detail::soa_first_touch(n * shared_element_bytes()))
+      {
+         this->resize_shared(soa_first_touch_policy, n, uninitialized);
+      }
+      else
+      {
+         this->resize_shared(execution::seq, n, uninitialized);
+      }
+   }
+   else
+   {
+      this->resize_columns<detail::soa_resize>(std::index_sequence_for<Types...>(), n, uninitialized, policy...);
+   }
+}
+
+template < class Allocator, class... Types >
+template < template<class> class Resize, size_t... I, class... ExecutionPolicy >
+void basic_static_soa<Allocator, Types...>::resize_columns(std::index_sequence<I...>, size_t n, bool uninitialized, ExecutionPolicy&&... policy)
+{
+   (void)n;
+   (void)uninitialized;
+   (Resize<value_type<I>>()(std::get<I>(_data), policy..., n, this->initializer<I>(uninitialized)), ...);
+}
+
+template < class Allocator, class... Types >
+size_t basic_static_soa<Allocator, Types...>::shared_size() const noexcept
+{
+   if constexpr(pointer_indices::size() > 0)
+   {
+      constexpr size_t first = detail::soa_first_index(pointer_indices());
+      return detail::soa_size_of<value_type<first>>()(std::get<first>(_data));
+   }
+   else
+   {
+      return 0;
+   }
+}
+
+template < class Allocator, class... Types >
+constexpr size_t basic_static_soa<Allocator, Types...>::shared_element_bytes() noexcept
+{
+   return detail::soa_element_bytes<Tuple>(pointer_indices());
+}
+
+template < class Allocator, class... Types >
+template < class ExecutionPolicy >
+void basic_static_soa<Allocator, Types...>::resize_shared(ExecutionPolicy&& policy, size_t n, bool uninitialized)
+{
+   if constexpr(pointer_indices::size() > 0)
+   {
+      size_t old_size = this->shared_size();
+      size_t capacity = _allocator.capacity();
+      if(n > capacity)
+      {
+         this->reallocate_shared(policy, detail::soa_grow_capacity(capacity, n));
+      }
+      this->resize_columns<detail::soa_resize_in_place>(pointer_indices(), n, uninitialized, policy);
+      // Reduce memory footprint
+      if(n < old_size && n < capacity / 4)
+      {
+         this->reallocate_shared(policy, n);
+      }
+   }
+}
+
+template < class Allocator, class... Types >
+template < class ExecutionPolicy >
+void basic_static_soa<Allocator, Types...>::reallocate_shared(ExecutionPolicy&& policy, size_t capacity)
+{
+   if constexpr(pointer_indices::size() > 0)
+   {
+      size_t n = this->shared_size();
+      _allocator.reallocate(_data, pointer_indices(), capacity, n, [&policy, n](auto* src, auto* dst)
+      {
+         detail::soa_for_each_partition(policy, 0, n, [src, dst](size_t begin, size_t end)
+         {
+            std::uninitialized_move(src + begin, src + end, dst + begin);
+         });
+      });
+   }
+}
+
+template < class Allocator, class... Types >
+size_t basic_static_soa<Allocator, Types...>::size() const noexcept
+{
+   return detail::soa_size_of<value_type<0>>()(std::get<0>(_data));
+}
+
+template < class Allocator, class... Types >
+void basic_static_soa<Allocator, Types...>::reserve(size_t n)
+{
+   if constexpr(Allocator::shared_storage)
+   {
+      this->apply_to_indices<detail::soa_reserve>(container_indices(), n);
+      if(n > _allocator.capacity())
+      {
+         if(detail::soa_first_touch(this->shared_size() * shared_element_bytes()))
+         {
+            this->reallocate_shared(soa_first_touch_policy, n);
+         }
+         else
+         {
+            this->reallocate_shared(execution::seq, n);
+         }
+      }
+   }
+   else
+   {
+      this->apply<detail::soa_reserve>(n);
+   }
+}
+
+template < class Allocator, class... Types >
+template < class ExecutionPolicy, class >
+void basic_static_soa<Allocator, Types...>::reserve(ExecutionPolicy&& policy, size_t n)
+{
+   if constexpr(Allocator::shared_storage)
+   {
+      this->apply_to_indices<detail::soa_reserve>(container_indices(), policy, n);
+      if(n > _allocator.capacity()) this->reallocate_shared(policy, n);
+   }
+   else
+   {
+      this->apply<detail::soa_reserve>(policy, n);
+   }
+}
+
+template < class Allocator, class... Types >
+size_t basic_static_soa<Allocator, Types...>::capacity() const noexcept
+{
+   return detail::soa_capacity<value_type<0>>()(std::get<0>(_data));
+}
+
+template < class Allocator, class... Types >
+void basic_static_soa<Allocator, Types...>::shrink_to_fit()
+{
+   if constexpr(Allocator::shared_storage)
+   {
+      this->apply_to_indices<detail::soa_shrink_to_fit>(container_indices());
+      size_t n = this->shared_size();
+      if(_allocator.capacity() > n)
+      {
+         if(detail::soa_first_touch(n * shared_element_bytes()))
+         {
+            this->reallocate_shared(soa_first_touch_policy, n);
+         }
+         else
+         {
+            this->reallocate_shared(execution::seq, n);
+         }
+      }
+   }
+   else
+   {
+      this->apply<detail::soa_shrink_to_fit>();
+   }
 }
 
-template < class... Types >
+template < class Allocator, class... Types >
 template < class T, class >
-void static_soa<Types...>::reorder(const std::vector<T>& new_index_map)
+void basic_static_soa<Allocator, Types...>::reorder(const std::vector<T>& new_index_map)
 {
-   assert(std::numeric_limits<T>::max() > this->size());
+   XLIB_PROFILE_SCOPE("static_soa::reorder");
+   assert(std::numeric_limits<T>::max() >= this->size());
+   assert(new_index_map.size() == this->size());
 
-   this->apply<detail::soa_reorder>(new_index_map);
+   detail::soa_permutation<T> perm(new_index_map);
+   if(perm.cycle_leaders.empty()) return;
+   this->apply<detail::soa_reorder>(perm);
+   this->elements_reordered(perm.n);
 }
 
-} // namespace xlib
+template < class Allocator, class... Types >
+template < class ExecutionPolicy, class T, class, class >
+void basic_static_soa<Allocator, Types...>::reorder(ExecutionPolicy&& policy, const std::vector<T>& new_index_map)
+{
+   XLIB_PROFILE_SCOPE("static_soa::reorder");
+   assert(std::numeric_limits<T>::max() >= this->size());
+   assert(new_index_map.size() == this->size());
+
+   detail::soa_permutation<T> perm(new_index_map);
+   if(perm.cycle_leaders.empty()) return;
+   if constexpr(std::is_same_v<std::remove_cv_t<std::remove_reference_t<ExecutionPolicy>>, execution::sequenced_policy>)
+   {
+      this->apply<detail::soa_reorder>(perm);
+   }
+   else if constexpr(Allocator::shared_storage && pointer_indices::size() > 0)
+   {
+      // Scatter all of the raw pointer columns into a new slab at once
+      this->apply_to_indices<detail::soa_reorder>(container_indices(), policy, perm);
+      _allocator.reallocate(_data, pointer_indices(), _allocator.capacity(), perm.n, [&](auto* src, auto* dst)
+      {
+         using value_t = std::remove_pointer_t<decltype(dst)>;
+         detail::parallel_for(policy, 0, perm.n, [&](size_t begin, size_t end)
+         {
+            for(size_t i = begin; i < end; ++i)
+            {
+               ::new(static_cast<void*>(dst + perm[i])) value_t(std::move(src[i]));
+            }
+         });
+      });
+   }
+   else
+   {
+      this->apply<detail::soa_reorder>(policy, perm);
+   }
+   this->elements_reordered(perm.n);
+}
+
+template < class Allocator, class... Types >
+template < size_t I, class ExecutionPolicy >
+void basic_static_soa<Allocator, Types...>::sort_by_impl(ExecutionPolicy&& policy, bool stable)
+{
+   using key_type = std::remove_cv_t<std::remove_reference_t<decltype(std::get<I>(_data)[0])>>;
+
+   size_t n = this->size();
+   const key_type* keys = detail::soa_data<value_type<I>>()(std::get<I>(_data));
+
+   std::vector<size_t> order;
+   if constexpr(std::is_integral<key_type>::value && !std::is_same<key_type,bool>::value)
+   {
+      order = detail::radix_sort_order(policy, keys, n);
+   }
+   else
+   {
+      order = detail::comparison_sort_order(keys, n, stable);
+   }
+
+   std::vector<size_t> new_index_map(n);
+   detail::parallel_for(policy, 0, n, [&](size_t begin, size_t end)
+   {
+      for(size_t k = begin; k < end; ++k)
+      {
+         new_index_map[order[k]] = k;
+      }
+   });
+   this->reorder(policy, new_index_map);
+}
+
+template < class Allocator, class... Types >
+template < size_t I >
+void basic_static_soa<Allocator, Types...>::sort_by()
+{
+   this->sort_by_impl<I>(execution::seq, false);
+}
+
+template < class Allocator, class... Types >
+template < size_t I, class ExecutionPolicy, class >
+void basic_static_soa<Allocator, Types...>::sort_by(ExecutionPolicy&& policy)
+{
+   this->sort_by_impl<I>(policy, false);
+}
+
+template < class Allocator, class... Types >
+template < size_t I >
+void basic_static_soa<Allocator, Types...>::stable_sort_by()
+{
+   this->sort_by_impl<I>(execution::seq, true);
+}
+
+template < class Allocator, class... Types >
+template < size_t I, class ExecutionPolicy, class >
+void basic_static_soa<Allocator, Types...>::stable_sort_by(ExecutionPolicy&& policy)
+{
+   this->sort_by_impl<I>(policy, true);
+}
+
+template < class Allocator, class... Types >
+template < class Predicate >
+size_t basic_static_soa<Allocator, Types...>::erase_if(Predicate&& pred)
+{
+   size_t n = this->size();
+   std::vector<size_t> survivors;
+   survivors.reserve(n);
+   for(size_t i = 0; i < n; ++i)
+   {
+      if(!static_cast<bool>(invoke_element(i, pred, i))) survivors.push_back(i);
+   }
+
+   size_t m = survivors.size();
+   if(m == n) return 0;
+   this->apply<detail::soa_compact>(survivors);
+   this->resize_impl(m, false);
+   this->elements_reordered(n);
+   return n - m;
+}
+
+template < class Allocator, class... Types >
+template < class ExecutionPolicy, class Predicate, class >
+size_t basic_static_soa<Allocator, Types...>::erase_if(ExecutionPolicy&& policy, Predicate&& pred)
+{
+   if constexpr(std::is_same_v<std::remove_cv_t<std::remove_reference_t<ExecutionPolicy>>, execution::sequenced_policy>)
+   {
+      return this->erase_if(pred);
+   }
+   else
+   {
+      size_t n = this->size();
+      auto chunked = detail::round_chunks(policy, n, 1);
+      size_t num_chunks = n > 0 ? (n + chunked.chunk_size - 1) / chunked.chunk_size : 0;
 
+      // Evaluate the predicate and count the remaining elements of each chunk
+      std::vector<unsigned char> keep(n);
+      std::vector<size_t> offsets(num_chunks + 1, 0);
+      detail::parallel_for(chunked, 0, n, [&](size_t begin, size_t end)
+      {
+         size_t count = 0;
+         for(size_t i = begin; i < end; ++i)
+         {
+            keep[i] = !static_cast<bool>(invoke_element(i, pred, i));
+            count += keep[i];
+         }
+         offsets[begin / chunked.chunk_size + 1] = count;
+      });
+      std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+      size_t m = offsets.back();
+      if(m == n) return 0;
+
+      std::vector<size_t> survivors(m);
+      detail::parallel_for(chunked, 0, n, [&](size_t begin, size_t end)
+      {
+         size_t j = offsets[begin / chunked.chunk_size];
+         for(size_t i = begin; i < end; ++i)
+         {
+            if(keep[i]) survivors[j++] = i;
+         }
+      });
+
+      if constexpr(Allocator::shared_storage && pointer_indices::size() > 0)
+      {
+         // Gather all of the raw pointer columns into a new slab at once
+         this->apply_to_indices<detail::soa_gather>(container_indices(), chunked, survivors);
+         _allocator.reallocate(_data, pointer_indices(), _allocator.capacity(), m, [&](auto* src, auto* dst)
+         {
+            using value_t = std::remove_pointer_t<decltype(dst)>;
+            detail::parallel_for(chunked, 0, m, [&](size_t begin, size_t end)
+            {
+               for(size_t j = begin; j < end; ++j)
+               {
+                  ::new(static_cast<void*>(dst + j)) value_t(std::move(src[survivors[j]]));
+               }
+            });
+         });
+      }
+      else
+      {
+         this->apply<detail::soa_gather>(chunked, survivors);
+      }
+      this->resize_impl(m, false);
+      this->elements_reordered(n);
+      return n - m;
+   }
+}
+
+template < class Allocator, class... Types >
+template < class Predicate >
+size_t basic_static_soa<Allocator, Types...>::erase_if_unordered(Predicate&& pred)
+{
+   size_t n = this->size();
+   std::vector<unsigned char> keep(n);
+   size_t m = 0;
+   for(size_t i = 0; i < n; ++i)
+   {
+      keep[i] = !static_cast<bool>(invoke_element(i, pred, i));
+      m += keep[i];
+   }
+   if(m == n) return 0;
+
+   // Every hole in front of m is filled by a remaining element behind m
+   std::vector<std::pair<size_t,size_t>> moves;
+   size_t back = n;
+   for(size_t j = 0; j < m; ++j)
+   {
+      if(keep[j]) continue;
+      do { --back; } while(!keep[back]);
+      moves.emplace_back(j, back);
+   }
+
+   this->apply<detail::soa_compact>(moves);
+   this->resize_impl(m, false);
+   this->elements_reordered(n);
+   return n - m;
+}
+
+template < class Allocator, class... Types >
+void basic_static_soa<Allocator, Types...>::attach(observer* o)
+{
+   assert(std::find(_observers.begin(), _observers.end(), o) == _observers.end());
+   _observers.push_back(o);
+}
+
+template < class Allocator, class... Types >
+void basic_static_soa<Allocator, Types...>::detach(observer* o) noexcept
+{
+   _observers.erase(std::remove(_observers.begin(), _observers.end(), o), _observers.end());
+}
+
+template < class Allocator, class... Types >
+void basic_static_soa<Allocator, Types...>::elements_reordered(size_t old_size)
+{
+   if(_dirty.enabled()) _dirty.mark_all(0, this->size());
+   this->notify([&](observer& o) { o.reordered(*this, old_size); });
+}
+
+template < class Allocator, class... Types >
+void basic_static_soa<Allocator, Types...>::track_dirty(bool enable)
+{
+   _dirty.enable(enable, this->size());
+}
+
+template < class Allocator, class... Types >
+template < size_t I >
+void basic_static_soa<Allocator, Types...>::mark_dirty(size_t begin, size_t end) noexcept
+{
+   assert(begin <= end && end <= this->size());
+   if(_dirty.enabled()) _dirty.mark(I, begin, end);
+}
+
+template < class Allocator, class... Types >
+void basic_static_soa<Allocator, Types...>::mark_dirty(size_t begin, size_t end) noexcept
+{
+   assert(begin <= end && end <= this->size());
+   if(_dirty.enabled()) _dirty.mark_all(begin, end);
+}
+
+template < class Allocator, class... Types >
+template < size_t I >
+std::vector<soa_interval> basic_static_soa<Allocator, Types...>::dirty_ranges() const
+{
+   size_t n = this->size();
+   if(!_dirty.enabled()) return n > 0 ? std::vector<soa_interval>{{0, n}} : std::vector<soa_interval>();
+   return _dirty.ranges(I, n);
+}
+
+template < class Allocator, class... Types >
+size_t basic_static_soa<Allocator, Types...>::clear_dirty() noexcept
+{
+   _dirty.clear();
+   return ++_dirty_epoch;
+}
+
+template < class Allocator, class... Types >
+template < class F >
+void basic_static_soa<Allocator, Types...>::notify(F&& f)
+{
+   for(observer* o: _observers) f(*o);
+}
+
+} // namespace xlib
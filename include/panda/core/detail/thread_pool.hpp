@@ -0,0 +1,169 @@
+#include <algorithm>
+#include <cstdlib>
+#include <type_traits>
+
+namespace xlib
+{
+namespace detail
+{
+
+inline bool& thread_pool_in_parallel() noexcept
+{
+   static thread_local bool in_parallel = false;
+   return in_parallel;
+}
+
+/** Mark the calling thread as running a parallel region for the lifetime of the guard
+ */
+struct parallel_region_guard
+{
+   parallel_region_guard(): _previous(thread_pool_in_parallel()) { thread_pool_in_parallel() = true; }
+   ~parallel_region_guard() { thread_pool_in_parallel() = _previous; }
+private:
+   bool _previous;
+};
+
+} // namespace detail
+
+inline thread_pool::~thread_pool()
+{
+   {
+      std::lock_guard<std::mutex> lk(_lock);
+      _stop = true;
+   }
+   _start.notify_all();
+   for(auto& w: _workers)
+   {
+      w.join();
+   }
+}
+
+inline thread_pool& thread_pool::instance()
+{
+   static thread_pool pool;
+   return pool;
+}
+
+inline size_t thread_pool::default_concurrency()
+{
+   static const size_t n = []() -> size_t
+   {
+      if(const char* env = std::getenv("XLIB_NUM_THREADS"))
+      {
+         long v = std::strtol(env, nullptr, 10);
+         if(v > 0) return static_cast<size_t>(v);
+      }
+      return std::max<size_t>(1, std::thread::hardware_concurrency());
+   }();
+   return n;
+}
+
+inline bool thread_pool::in_parallel() noexcept
+{
+   return detail::thread_pool_in_parallel();
+}
+
+template < class F >
+void thread_pool::run(size_t num_threads, F&& f)
+{
+   if(num_threads == 0) num_threads = default_concurrency();
+
+   if(num_threads == 1 || in_parallel())
+   {
+      detail::parallel_region_guard guard;
+      for(size_t t = 0; t < num_threads; ++t)
+      {
+         f(t, num_threads);
+      }
+      return;
+   }
+
+   using Fn = std::remove_reference_t<F>;
+   job j;
+   j.invoke = [](void* fp, size_t thread_index, size_t n)
+   {
+      (*static_cast<Fn*>(fp))(thread_index, n);
+   };
+   j.f = const_cast<void*>(static_cast<const void*>(&f));
+   j.num_threads = num_threads;
+   this->run_job(j);
+}
+
+inline void thread_pool::run_job(const job& j)
+{
+   std::lock_guard<std::mutex> run_lk(_run_lock);
+   this->grow(j.num_threads - 1);
+
+   {
+      std::lock_guard<std::mutex> lk(_lock);
+      _job = j;
+      _remaining = j.num_threads - 1;
+      _error = nullptr;
+      ++_generation;
+   }
+   _start.notify_all();
+
+   std::exception_ptr error;
+   try
+   {
+      detail::parallel_region_guard guard;
+      j.invoke(j.f, 0, j.num_threads);
+   }
+   catch(...)
+   {
+      error = std::current_exception();
+   }
+
+   std::unique_lock<std::mutex> lk(_lock);
+   _done.wait(lk, [this]{ return _remaining == 0; });
+   if(!error) error = _error;
+   _error = nullptr;
+   lk.unlock();
+
+   if(error) std::rethrow_exception(error);
+}
+
+inline void thread_pool::grow(size_t num_workers)
+{
+   while(_workers.size() < num_workers)
+   {
+      // Workers start from the current generation so they cannot skip the
+      // job that is about to be published
+      size_t thread_index = _workers.size() + 1;
+      size_t generation = _generation;
+      _workers.emplace_back([this, thread_index, generation]{ this->worker_loop(thread_index, generation); });
+   }
+}
+
+inline void thread_pool::worker_loop(size_t thread_index, size_t seen)
+{
+   while(true)
+   {
+      job j;
+      {
+         std::unique_lock<std::mutex> lk(_lock);
+         _start.wait(lk, [&]{ return _stop || _generation != seen; });
+         if(_stop) return;
+         seen = _generation;
+         j = _job;
+      }
+      if(thread_index >= j.num_threads) continue;
+
+      std::exception_ptr error;
+      try
+      {
+         detail::parallel_region_guard guard;
+         j.invoke(j.f, thread_index, j.num_threads);
+      }
+      catch(...)
+      {
+         error = std::current_exception();
+      }
+
+      std::lock_guard<std::mutex> lk(_lock);
+      if(error && !_error) _error = error;
+      if(--_remaining == 0) _done.notify_one();
+   }
+}
+
+} // namespace xlib
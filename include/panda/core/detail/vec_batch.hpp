@@ -0,0 +1,367 @@
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace xlib
+{
+namespace detail
+{
+
+// Scalar kernels, used for every shape without a SIMD specialization and for
+// the tails of the SIMD kernels
+template < class T, size_t N >
+struct vec_kernels_scalar
+{
+   using R = promote_fp_t<T>;
+
+   static void dot(const vec<T,N>* a, const vec<T,N>* b, R* out, size_t n)
+   {
+      for(size_t i = 0; i < n; ++i) out[i] = a[i].dot(b[i]);
+   }
+
+   static void norm(const vec<T,N>* a, R* out, size_t n)
+   {
+      for(size_t i = 0; i < n; ++i) out[i] = a[i].norm();
+   }
+
+   static void cross(const vec<T,N>* a, const vec<T,N>* b, vec<R,N>* out, size_t n)
+   {
+      for(size_t i = 0; i < n; ++i) out[i] = a[i].cross(b[i]);
+   }
+};
+
+template < class T, size_t N >
+struct vec_kernels: vec_kernels_scalar<T,N>
+{};
+
+#if defined(__SSE2__)
+
+// 4 x vec<float,3>: (x0 y0 z0 x1) (y1 z1 x2 y2) (z2 x3 y3 z3) <-> (x0..x3) (y0..y3) (z0..z3)
+inline void deinterleave3(const float* p, __m128& x, __m128& y, __m128& z)
+{
+   __m128 a = _mm_loadu_ps(p);
+   __m128 b = _mm_loadu_ps(p + 4);
+   __m128 c = _mm_loadu_ps(p + 8);
+   __m128 t = _mm_shuffle_ps(b, c, _MM_SHUFFLE(2,1,3,2)); // x2 y2 x3 y3
+   __m128 u = _mm_shuffle_ps(a, b, _MM_SHUFFLE(1,0,2,1)); // y0 z0 y1 z1
+   x = _mm_shuffle_ps(a, t, _MM_SHUFFLE(2,0,3,0));
+   y = _mm_shuffle_ps(u, t, _MM_SHUFFLE(3,1,2,0));
+   z = _mm_shuffle_ps(u, c, _MM_SHUFFLE(3,0,3,1));
+}
+
+inline void interleave3(float* p, __m128 x, __m128 y, __m128 z)
+{
+   __m128 xy_lo = _mm_unpacklo_ps(x, y); // x0 y0 x1 y1
+   __m128 xy_hi = _mm_unpackhi_ps(x, y); // x2 y2 x3 y3
+   __m128 t0 = _mm_shuffle_ps(z, xy_lo, _MM_SHUFFLE(2,2,0,0)); // z0 z0 x1 x1
+   __m128 t1 = _mm_shuffle_ps(xy_lo, z, _MM_SHUFFLE(1,1,3,3)); // y1 y1 z1 z1
+   __m128 t2 = _mm_shuffle_ps(z, xy_hi, _MM_SHUFFLE(2,2,2,2)); // z2 z2 x3 x3
+   __m128 t3 = _mm_shuffle_ps(xy_hi, z, _MM_SHUFFLE(3,3,3,3)); // y3 y3 z3 z3
+   _mm_storeu_ps(p,     _mm_shuffle_ps(xy_lo, t0, _MM_SHUFFLE(2,0,1,0)));
+   _mm_storeu_ps(p + 4, _mm_shuffle_ps(t1, xy_hi, _MM_SHUFFLE(1,0,2,0)));
+   _mm_storeu_ps(p + 8, _mm_shuffle_ps(t2, t3, _MM_SHUFFLE(2,0,2,0)));
+}
+
+template <>
+struct vec_kernels<float,3>
+{
+   using V = vec<float,3>;
+   static_assert(sizeof(V) == 3 * sizeof(float), "vec must be tightly packed");
+
+   static void dot(const V* a, const V* b, float* out, size_t n)
+   {
+      size_t i = 0;
+      for(; i + 4 <= n; i += 4)
+      {
+         __m128 ax, ay, az, bx, by, bz;
+         deinterleave3(a[i].data(), ax, ay, az);
+         deinterleave3(b[i].data(), bx, by, bz);
+         __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)), _mm_mul_ps(az, bz));
+         _mm_storeu_ps(out + i, d);
+      }
+      vec_kernels_scalar<float,3>::dot(a + i, b + i, out + i, n - i);
+   }
+
+   static void norm(const V* a, float* out, size_t n)
+   {
+      size_t i = 0;
+      for(; i + 4 <= n; i += 4)
+      {
+         __m128 ax, ay, az;
+         deinterleave3(a[i].data(), ax, ay, az);
+         __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, ax), _mm_mul_ps(ay, ay)), _mm_mul_ps(az, az));
+         _mm_storeu_ps(out + i, _mm_sqrt_ps(d));
+      }
+      vec_kernels_scalar<float,3>::norm(a + i, out + i, n - i);
+   }
+
+   static void cross(const V* a, const V* b, V* out, size_t n)
+   {
+      size_t i = 0;
+      for(; i + 4 <= n; i += 4)
+      {
+         __m128 ax, ay, az, bx, by, bz;
+         deinterleave3(a[i].data(), ax, ay, az);
+         deinterleave3(b[i].data(), bx, by, bz);
+         __m128 cx = _mm_sub_ps(_mm_mul_ps(ay, bz), _mm_mul_ps(az, by));
+         __m128 cy = _mm_sub_ps(_mm_mul_ps(az, bx), _mm_mul_ps(ax, bz));
+         __m128 cz = _mm_sub_ps(_mm_mul_ps(ax, by), _mm_mul_ps(ay, bx));
+         interleave3(out[i].data(), cx, cy, cz);
+      }
+      vec_kernels_scalar<float,3>::cross(a + i, b + i, out + i, n - i);
+   }
+};
+
+template <>
+struct vec_kernels<float,4>: vec_kernels_scalar<float,4>
+{
+   using V = vec<float,4>;
+   static_assert(sizeof(V) == 4 * sizeof(float), "vec must be tightly packed");
+
+   static void load_transposed(const V* a, __m128& x, __m128& y, __m128& z, __m128& w)
+   {
+      x = _mm_loadu_ps(a[0].data());
+      y = _mm_loadu_ps(a[1].data());
+      z = _mm_loadu_ps(a[2].data());
+      w = _mm_loadu_ps(a[3].data());
+      _MM_TRANSPOSE4_PS(x, y, z, w);
+   }
+
+   static void dot(const V* a, const V* b, float* out, size_t n)
+   {
+      size_t i = 0;
+      for(; i + 4 <= n; i += 4)
+      {
+         __m128 ax, ay, az, aw, bx, by, bz, bw;
+         load_transposed(a + i, ax, ay, az, aw);
+         load_transposed(b + i, bx, by, bz, bw);
+         __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)),
+                               _mm_add_ps(_mm_mul_ps(az, bz), _mm_mul_ps(aw, bw)));
+         _mm_storeu_ps(out + i, d);
+      }
+      vec_kernels_scalar<float,4>::dot(a + i, b + i, out + i, n - i);
+   }
+
+   static void norm(const V* a, float* out, size_t n)
+   {
+      size_t i = 0;
+      for(; i + 4 <= n; i += 4)
+      {
+         __m128 ax, ay, az, aw;
+         load_transposed(a + i, ax, ay, az, aw);
+         __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, ax), _mm_mul_ps(ay, ay)),
+                               _mm_add_ps(_mm_mul_ps(az, az), _mm_mul_ps(aw, aw)));
+         _mm_storeu_ps(out + i, _mm_sqrt_ps(d));
+      }
+      vec_kernels_scalar<float,4>::norm(a + i, out + i, n - i);
+   }
+};
+
+// 2 x vec<double,3>: (x0 y0) (z0 x1) (y1 z1) <-> (x0 x1) (y0 y1) (z0 z1)
+inline void deinterleave3(const double* p, __m128d& x, __m128d& y, __m128d& z)
+{
+   __m128d a = _mm_loadu_pd(p);
+   __m128d b = _mm_loadu_pd(p + 2);
+   __m128d c = _mm_loadu_pd(p + 4);
+   x = _mm_shuffle_pd(a, b, 2);
+   y = _mm_shuffle_pd(a, c, 1);
+   z = _mm_shuffle_pd(b, c, 2);
+}
+
+inline void interleave3(double* p, __m128d x, __m128d y, __m128d z)
+{
+   _mm_storeu_pd(p,     _mm_unpacklo_pd(x, y));
+   _mm_storeu_pd(p + 2, _mm_shuffle_pd(z, x, 2));
+   _mm_storeu_pd(p + 4, _mm_unpackhi_pd(y, z));
+}
+
+#if defined(__AVX__)
+// 4 x vec<double,3> as two deinterleaved pairs
+inline void deinterleave3(const double* p, __m256d& x, __m256d& y, __m256d& z)
+{
+   __m128d x0, y0, z0, x1, y1, z1;
+   deinterleave3(p, x0, y0, z0);
+   deinterleave3(p + 6, x1, y1, z1);
+   x = _mm256_insertf128_pd(_mm256_castpd128_pd256(x0), x1, 1);
+   y = _mm256_insertf128_pd(_mm256_castpd128_pd256(y0), y1, 1);
+   z = _mm256_insertf128_pd(_mm256_castpd128_pd256(z0), z1, 1);
+}
+
+inline void interleave3(double* p, __m256d x, __m256d y, __m256d z)
+{
+   interleave3(p, _mm256_castpd256_pd128(x), _mm256_castpd256_pd128(y), _mm256_castpd256_pd128(z));
+   interleave3(p + 6, _mm256_extractf128_pd(x, 1), _mm256_extractf128_pd(y, 1), _mm256_extractf128_pd(z, 1));
+}
+#endif
+
+template <>
+struct vec_kernels<double,3>
+{
+   using V = vec<double,3>;
+   static_assert(sizeof(V) == 3 * sizeof(double), "vec must be tightly packed");
+
+#if defined(__AVX__)
+   using reg = __m256d;
+   static constexpr size_t width = 4;
+   static reg add(reg a, reg b) { return _mm256_add_pd(a, b); }
+   static reg sub(reg a, reg b) { return _mm256_sub_pd(a, b); }
+   static reg mul(reg a, reg b) { return _mm256_mul_pd(a, b); }
+   static reg sqrt(reg a) { return _mm256_sqrt_pd(a); }
+   static void store(double* p, reg a) { _mm256_storeu_pd(p, a); }
+#else
+   using reg = __m128d;
+   static constexpr size_t width = 2;
+   static reg add(reg a, reg b) { return _mm_add_pd(a, b); }
+   static reg sub(reg a, reg b) { return _mm_sub_pd(a, b); }
+   static reg mul(reg a, reg b) { return _mm_mul_pd(a, b); }
+   static reg sqrt(reg a) { return _mm_sqrt_pd(a); }
+   static void store(double* p, reg a) { _mm_storeu_pd(p, a); }
+#endif
+
+   static void dot(const V* a, const V* b, double* out, size_t n)
+   {
+      size_t i = 0;
+      for(; i + width <= n; i += width)
+      {
+         reg ax, ay, az, bx, by, bz;
+         deinterleave3(a[i].data(), ax, ay, az);
+         deinterleave3(b[i].data(), bx, by, bz);
+         store(out + i, add(add(mul(ax, bx), mul(ay, by)), mul(az, bz)));
+      }
+      vec_kernels_scalar<double,3>::dot(a + i, b + i, out + i, n - i);
+   }
+
+   static void norm(const V* a, double* out, size_t n)
+   {
+      size_t i = 0;
+      for(; i + width <= n; i += width)
+      {
+         reg ax, ay, az;
+         deinterleave3(a[i].data(), ax, ay, az);
+         store(out + i, sqrt(add(add(mul(ax, ax), mul(ay, ay)), mul(az, az))));
+      }
+      vec_kernels_scalar<double,3>::norm(a + i, out + i, n - i);
+   }
+
+   static void cross(const V* a, const V* b, V* out, size_t n)
+   {
+      size_t i = 0;
+      for(; i + width <= n; i += width)
+      {
+         reg ax, ay, az, bx, by, bz;
+         deinterleave3(a[i].data(), ax, ay, az);
+         deinterleave3(b[i].data(), bx, by, bz);
+         reg cx = sub(mul(ay, bz), mul(az, by));
+         reg cy = sub(mul(az, bx), mul(ax, bz));
+         reg cz = sub(mul(ax, by), mul(ay, bx));
+         interleave3(out[i].data(), cx, cy, cz);
+      }
+      vec_kernels_scalar<double,3>::cross(a + i, b + i, out + i, n - i);
+   }
+};
+
+#endif // __SSE2__
+
+template < class Col >
+auto vec_column_data(Col& c) noexcept
+{
+   if constexpr(std::is_pointer<std::remove_cv_t<Col>>::value)
+   {
+      return c;
+   }
+   else
+   {
+      return c.data();
+   }
+}
+
+template < class Col >
+size_t vec_column_size(const Col& c) noexcept
+{
+   return soa_size_of<std::remove_cv_t<Col>>()(c);
+}
+
+} // namespace detail
+
+namespace batch
+{
+
+template < class T, size_t N >
+void dot(const vec<T,N>* a, const vec<T,N>* b, promote_fp_t<T>* out, size_t n)
+{
+   detail::vec_kernels<T,N>::dot(a, b, out, n);
+}
+
+template < class T >
+void cross(const vec<T,3>* a, const vec<T,3>* b, vec<promote_fp_t<T>,3>* out, size_t n)
+{
+   detail::vec_kernels<T,3>::cross(a, b, out, n);
+}
+
+template < class T, size_t N >
+void norm(const vec<T,N>* a, promote_fp_t<T>* out, size_t n)
+{
+   detail::vec_kernels<T,N>::norm(a, out, n);
+}
+
+template < class ColA, class ColB, class ColOut >
+void dot(const ColA& a, const ColB& b, ColOut& out)
+{
+   dot(execution::seq, a, b, out);
+}
+
+template < class ExecutionPolicy, class ColA, class ColB, class ColOut, class >
+void dot(ExecutionPolicy&& policy, const ColA& a, const ColB& b, ColOut& out)
+{
+   size_t n = detail::vec_column_size(a);
+   assert(detail::vec_column_size(b) == n && detail::vec_column_size(out) == n);
+   auto pa = detail::vec_column_data(a);
+   auto pb = detail::vec_column_data(b);
+   auto po = detail::vec_column_data(out);
+   detail::parallel_for(policy, 0, n, [&](size_t begin, size_t end)
+   {
+      dot(pa + begin, pb + begin, po + begin, end - begin);
+   });
+}
+
+template < class ColA, class ColB, class ColOut >
+void cross(const ColA& a, const ColB& b, ColOut& out)
+{
+   cross(execution::seq, a, b, out);
+}
+
+template < class ExecutionPolicy, class ColA, class ColB, class ColOut, class >
+void cross(ExecutionPolicy&& policy, const ColA& a, const ColB& b, ColOut& out)
+{
+   size_t n = detail::vec_column_size(a);
+   assert(detail::vec_column_size(b) == n && detail::vec_column_size(out) == n);
+   auto pa = detail::vec_column_data(a);
+   auto pb = detail::vec_column_data(b);
+   auto po = detail::vec_column_data(out);
+   detail::parallel_for(policy, 0, n, [&](size_t begin, size_t end)
+   {
+      cross(pa + begin, pb + begin, po + begin, end - begin);
+   });
+}
+
+template < class ColA, class ColOut >
+void norm(const ColA& a, ColOut& out)
+{
+   norm(execution::seq, a, out);
+}
+
+template < class ExecutionPolicy, class ColA, class ColOut, class >
+void norm(ExecutionPolicy&& policy, const ColA& a, ColOut& out)
+{
+   size_t n = detail::vec_column_size(a);
+   assert(detail::vec_column_size(out) == n);
+   auto pa = detail::vec_column_data(a);
+   auto po = detail::vec_column_data(out);
+   detail::parallel_for(policy, 0, n, [&](size_t begin, size_t end)
+   {
+      norm(pa + begin, po + begin, end - begin);
+   });
+}
+
+} // namespace batch
+} // namespace xlib
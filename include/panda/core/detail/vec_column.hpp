@@ -0,0 +1,356 @@
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <utility>
+
+namespace xlib
+{
+
+template < class T, size_t N, size_t W >
+vec_column<T,N,W>::vec_column(size_t n)
+{
+   this->resize(n);
+}
+
+template < class T, size_t N, size_t W >
+vec_column<T,N,W>::vec_column(const vec_column& other)
+{
+   this->reallocate(round_capacity(other._size));
+   _size = other._size;
+   for(size_t c = 0; c < N; ++c)
+   {
+      for(size_t i = 0; i < _size; ++i) this->component(i, c) = other.component(i, c);
+   }
+}
+
+template < class T, size_t N, size_t W >
+vec_column<T,N,W>::vec_column(vec_column&& other) noexcept
+{
+   this->swap(other);
+}
+
+template < class T, size_t N, size_t W >
+vec_column<T,N,W>& vec_column<T,N,W>::operator=(const vec_column& other)
+{
+   vec_column copy(other);
+   this->swap(copy);
+   return *this;
+}
+
+template < class T, size_t N, size_t W >
+vec_column<T,N,W>& vec_column<T,N,W>::operator=(vec_column&& other) noexcept
+{
+   this->swap(other);
+   return *this;
+}
+
+template < class T, size_t N, size_t W >
+vec_column<T,N,W>::~vec_column()
+{
+   _size = 0;
+   this->reallocate(0);
+}
+
+template < class T, size_t N, size_t W >
+typename vec_column<T,N,W>::reference vec_column<T,N,W>::operator[](size_t i) noexcept
+{
+   assert(i < _size);
+   return reference(_data + this->offset(i, 0), this->stride());
+}
+
+template < class T, size_t N, size_t W >
+typename vec_column<T,N,W>::const_reference vec_column<T,N,W>::operator[](size_t i) const noexcept
+{
+   assert(i < _size);
+   return const_reference(_data + this->offset(i, 0), this->stride());
+}
+
+template < class T, size_t N, size_t W >
+void vec_column<T,N,W>::resize(size_t n)
+{
+   if(n > _capacity)
+   {
+      this->reallocate(round_capacity(detail::soa_grow_capacity(_capacity, n)));
+   }
+   for(size_t i = _size; i < n; i += this->run_length(i))
+   {
+      size_t len = std::min(this->run_length(i), n - i);
+      for(size_t c = 0; c < N; ++c) std::fill_n(&this->component(i, c), len, T());
+   }
+   _size = n;
+}
+
+template < class T, size_t N, size_t W >
+void vec_column<T,N,W>::reserve(size_t n)
+{
+   if(n > _capacity) this->reallocate(round_capacity(n));
+}
+
+template < class T, size_t N, size_t W >
+void vec_column<T,N,W>::shrink_to_fit()
+{
+   size_t capacity = round_capacity(_size);
+   if(capacity < _capacity) this->reallocate(capacity);
+}
+
+template < class T, size_t N, size_t W >
+size_t vec_column<T,N,W>::run_length(size_t i) const noexcept
+{
+   if constexpr(W == 0)
+   {
+      return _capacity - i;
+   }
+   else
+   {
+      return W - i % W;
+   }
+}
+
+template < class T, size_t N, size_t W >
+void vec_column<T,N,W>::swap(vec_column& other) noexcept
+{
+   std::swap(_data, other._data);
+   std::swap(_size, other._size);
+   std::swap(_capacity, other._capacity);
+}
+
+template < class T, size_t N, size_t W >
+size_t vec_column<T,N,W>::offset(size_t i, size_t c) const noexcept
+{
+   if constexpr(W == 0)
+   {
+      return c * _capacity + i;
+   }
+   else
+   {
+      return (i / W) * (N * W) + c * W + i % W;
+   }
+}
+
+template < class T, size_t N, size_t W >
+size_t vec_column<T,N,W>::round_capacity(size_t n) noexcept
+{
+   // Planes start on an soa_alignment boundary, tiles are never split
+   constexpr size_t multiple = W ? W : std::max<size_t>(1, soa_alignment_v<T> / sizeof(T));
+   return (n + multiple - 1) / multiple * multiple;
+}
+
+template < class T, size_t N, size_t W >
+void vec_column<T,N,W>::reallocate(size_t capacity)
+{
+   constexpr std::align_val_t alignment{soa_alignment_v<T>};
+   assert(capacity >= _size);
+
+   T* data = nullptr;
+   if(capacity > 0)
+   {
+      data = static_cast<T*>(::operator new(N * capacity * sizeof(T), alignment));
+      if constexpr(W == 0)
+      {
+         for(size_t c = 0; c < N; ++c)
+         {
+            if(_size) std::memcpy(data + c * capacity, _data + c * _capacity, _size * sizeof(T));
+         }
+      }
+      else
+      {
+         // Tiles do not depend on the capacity, copy every used tile as is
+         size_t tiles = (_size + W - 1) / W;
+         if(tiles) std::memcpy(data, _data, tiles * N * W * sizeof(T));
+      }
+   }
+   if(_data) ::operator delete(_data, alignment);
+   _data = data;
+   _capacity = capacity;
+}
+
+namespace detail
+{
+
+/** One component of every element of a vec_column, indexable like a column
+ */
+template < class T, size_t N, size_t W >
+struct vec_column_plane
+{
+   T& operator[](size_t i) const noexcept { return col.component(i, c); }
+
+   vec_column<T,N,W>& col;
+   size_t c;
+};
+
+// SOA reorder handler, permutes one component at a time
+template < class T, size_t N, size_t W >
+struct soa_reorder<vec_column<T,N,W>>
+{
+   template < class Int >
+   void operator()(vec_column<T,N,W>& data, const soa_permutation<Int>& perm)
+   {
+      for(size_t c = 0; c < N; ++c)
+      {
+         vec_column_plane<T,N,W> plane{data, c};
+         soa_permute_in_place(plane, perm);
+      }
+   }
+
+   template < class ExecutionPolicy, class Int >
+   void operator()(vec_column<T,N,W>& data, ExecutionPolicy&& policy, const soa_permutation<Int>& perm)
+   {
+      vec_column<T,N,W> scattered;
+      scattered.resize(perm.n);
+      parallel_for(policy, 0, perm.n, [&](size_t begin, size_t end)
+      {
+         for(size_t c = 0; c < N; ++c)
+         {
+            for(size_t i = begin; i < end; ++i)
+            {
+               scattered.component(perm[i], c) = data.component(i, c);
+            }
+         }
+      });
+      data.swap(scattered);
+   }
+};
+
+/** Call f(begin, n) on every run of [begin, end) in which the components of
+ * a vec_column are unit stride
+ */
+template < class T, size_t N, size_t W, class F >
+void for_each_vec_column_run(const vec_column<T,N,W>& col, size_t begin, size_t end, F&& f)
+{
+   while(begin < end)
+   {
+      size_t n = std::min(col.run_length(begin), end - begin);
+      f(begin, n);
+      begin += n;
+   }
+}
+
+template < class T, size_t N, size_t W, class R >
+void vec_column_dot(const vec_column<T,N,W>& a, const vec_column<T,N,W>& b, R* XLIB_RESTRICT out, size_t begin, size_t end)
+{
+   for_each_vec_column_run(a, begin, end, [&](size_t i, size_t n)
+   {
+      const T* ac[N];
+      const T* bc[N];
+      for(size_t c = 0; c < N; ++c)
+      {
+         ac[c] = &a.component(i, c);
+         bc[c] = &b.component(i, c);
+      }
+      R* o = out + i;
+      XLIB_PRAGMA_IVDEP
+      for(size_t j = 0; j < n; ++j)
+      {
+         R sum = R();
+         for(size_t c = 0; c < N; ++c) sum += static_cast<R>(ac[c][j]) * static_cast<R>(bc[c][j]);
+         o[j] = sum;
+      }
+   });
+}
+
+template < class T, size_t N, size_t W, class R >
+void vec_column_norm(const vec_column<T,N,W>& a, R* XLIB_RESTRICT out, size_t begin, size_t end)
+{
+   for_each_vec_column_run(a, begin, end, [&](size_t i, size_t n)
+   {
+      const T* ac[N];
+      for(size_t c = 0; c < N; ++c) ac[c] = &a.component(i, c);
+      R* o = out + i;
+      XLIB_PRAGMA_IVDEP
+      for(size_t j = 0; j < n; ++j)
+      {
+         R sum = R();
+         for(size_t c = 0; c < N; ++c) sum += static_cast<R>(ac[c][j]) * static_cast<R>(ac[c][j]);
+         o[j] = std::sqrt(sum);
+      }
+   });
+}
+
+template < class T, size_t W >
+void vec_column_cross(const vec_column<T,3,W>& a, const vec_column<T,3,W>& b, vec_column<T,3,W>& out, size_t begin, size_t end)
+{
+   for_each_vec_column_run(a, begin, end, [&](size_t i, size_t n)
+   {
+      // out may be a or b, every element is loaded before it is stored and
+      // only depends on itself
+      const T* ax = &a.component(i, 0);
+      const T* ay = &a.component(i, 1);
+      const T* az = &a.component(i, 2);
+      const T* bx = &b.component(i, 0);
+      const T* by = &b.component(i, 1);
+      const T* bz = &b.component(i, 2);
+      T* ox = &out.component(i, 0);
+      T* oy = &out.component(i, 1);
+      T* oz = &out.component(i, 2);
+      XLIB_PRAGMA_IVDEP
+      for(size_t j = 0; j < n; ++j)
+      {
+         T x0 = ax[j], x1 = ay[j], x2 = az[j];
+         T y0 = bx[j], y1 = by[j], y2 = bz[j];
+         ox[j] = x1 * y2 - x2 * y1;
+         oy[j] = x2 * y0 - x0 * y2;
+         oz[j] = x0 * y1 - x1 * y0;
+      }
+   });
+}
+
+} // namespace detail
+
+namespace batch
+{
+
+template < class T, size_t N, size_t W, class ColOut >
+void dot(const vec_column<T,N,W>& a, const vec_column<T,N,W>& b, ColOut& out)
+{
+   dot(execution::seq, a, b, out);
+}
+
+template < class ExecutionPolicy, class T, size_t N, size_t W, class ColOut, class >
+void dot(ExecutionPolicy&& policy, const vec_column<T,N,W>& a, const vec_column<T,N,W>& b, ColOut& out)
+{
+   size_t n = a.size();
+   assert(b.size() == n && detail::vec_column_size(out) == n);
+   auto po = detail::vec_column_data(out);
+   detail::parallel_for(policy, 0, n, [&](size_t begin, size_t end)
+   {
+      detail::vec_column_dot(a, b, po, begin, end);
+   });
+}
+
+template < class T, size_t W >
+void cross(const vec_column<T,3,W>& a, const vec_column<T,3,W>& b, vec_column<T,3,W>& out)
+{
+   cross(execution::seq, a, b, out);
+}
+
+template < class ExecutionPolicy, class T, size_t W, class >
+void cross(ExecutionPolicy&& policy, const vec_column<T,3,W>& a, const vec_column<T,3,W>& b, vec_column<T,3,W>& out)
+{
+   size_t n = a.size();
+   assert(b.size() == n && out.size() == n);
+   detail::parallel_for(policy, 0, n, [&](size_t begin, size_t end)
+   {
+      detail::vec_column_cross(a, b, out, begin, end);
+   });
+}
+
+template < class T, size_t N, size_t W, class ColOut >
+void norm(const vec_column<T,N,W>& a, ColOut& out)
+{
+   norm(execution::seq, a, out);
+}
+
+template < class ExecutionPolicy, class T, size_t N, size_t W, class ColOut, class >
+void norm(ExecutionPolicy&& policy, const vec_column<T,N,W>& a, ColOut& out)
+{
+   size_t n = a.size();
+   assert(detail::vec_column_size(out) == n);
+   auto po = detail::vec_column_data(out);
+   detail::parallel_for(policy, 0, n, [&](size_t begin, size_t end)
+   {
+      detail::vec_column_norm(a, po, begin, end);
+   });
+}
+
+} // namespace batch
+} // namespace xlib
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <xlib/core/static_soa.h>
+
+#include <cstddef>
+#include <utility>
+
+namespace xlib
+{
+
+/** Column holding two buffers of the same column type, the current state
+ * and the next state of a time integration
+ *
+ * Kernels read current() and write next(), swap_buffers() then exchanges the
+ * buffers in O(1) without copying any element. As a static_soa column the
+ * buffers always have the same size: resize, reserve, reorder, sort_by and
+ * erase_if apply to both buffers, so element i of next() stays the element
+ * i of current(). Element access (operator[], data()) goes to current(),
+ * which is also what apply_to_element, apply_blocked, reductions and
+ * checkpoints see.
+ *
+ *    xlib::static_soa<xlib::double_buffer<double*>, double*> soa;
+ *    auto& x = soa.get_data<0>();
+ *    const double* v = soa.get_data<1>();
+ *    for(size_t i = 0; i < soa.size(); ++i) x.next()[i] = x.current()[i] + dt * v[i];
+ *    x.swap_buffers();
+ *
+ * swap_buffers() changes every element of current() without going through
+ * the container, so containers tracking dirty ranges have to mark them.
+ * @tparam Column type of both buffers, a raw pointer (T*) or a container
+ *         column such as std::vector
+ */
+template < class Column >
+class double_buffer
+{
+public:
+   using column_type = Column;
+   using value_type = typename detail::soa_element_value_type<Column>::value_type;
+   using reference = decltype(std::declval<Column&>()[size_t(0)]);
+   using const_reference = decltype(std::declval<const Column&>()[size_t(0)]);
+
+   double_buffer() = default;
+   double_buffer(const double_buffer&) = delete;
+   double_buffer& operator=(const double_buffer&) = delete;
+   double_buffer(double_buffer&& other) noexcept;
+   double_buffer& operator=(double_buffer&& other) noexcept;
+   ~double_buffer();
+
+   /** Buffer holding the current state
+    */
+   Column& current() noexcept { return _current; }
+   const Column& current() const noexcept { return _current; }
+
+   /** Buffer that the next state is written to, its elements are left over
+    * from the state before the current one
+    */
+   Column& next() noexcept { return _next; }
+   const Column& next() const noexcept { return _next; }
+
+   /** Make the next state current by exchanging the buffers, O(1)
+    */
+   void swap_buffers() noexcept;
+
+   /** Element i of the current state
+    */
+   reference operator[](size_t i) noexcept { return _current[i]; }
+   const_reference operator[](size_t i) const noexcept { return _current[i]; }
+
+   /** Contiguous data of the current state
+    */
+   auto data() noexcept;
+   auto data() const noexcept;
+
+   size_t size() const noexcept;
+   size_t capacity() const noexcept;
+   bool empty() const noexcept { return this->size() == 0; }
+
+   /** Resize both buffers, new elements are value initialized
+    * @param n new number of elements
+    */
+   void resize(size_t n);
+
+   /** Resize both buffers, new elements of both are copies of value
+    * @param n new number of elements
+    * @param value new element
+    */
+   void resize(size_t n, const value_type& value);
+
+   void reserve(size_t n);
+   void shrink_to_fit();
+
+   void swap(double_buffer& other) noexcept;
+
+private:
+   Column _current = Column();
+   Column _next = Column();
+};
+
+template < class Column >
+void swap(double_buffer<Column>& lhs, double_buffer<Column>& rhs) noexcept
+{
+   lhs.swap(rhs);
+}
+
+} // namespace xlib
+
+#include "detail/double_buffer.hpp"
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <xlib/core/thread_pool.h>
+
+#include <cstddef>
+#include <type_traits>
+
+/** Hint that the iterations of the following loop are independent
+ */
+#if defined(__clang__)
+#define XLIB_PRAGMA_IVDEP _Pragma("clang loop vectorize(enable)")
+#elif defined(__GNUC__)
+#define XLIB_PRAGMA_IVDEP _Pragma("GCC ivdep")
+#else
+#define XLIB_PRAGMA_IVDEP
+#endif
+
+namespace xlib
+{
+namespace execution
+{
+
+/** How the chunks of an index range are handed out to threads
+ */
+enum class schedule
+{
+   /** Threads grab the next chunk when they are done with their last one,
+    * chunk size is picked from the number of threads
+    */
+   dynamic,
+   /** Chunks have a fixed size that does not depend on the number of threads,
+    * chunk k always runs on thread k % num_threads
+    */
+   deterministic
+};
+
+/** Run serially on the calling thread
+ */
+struct sequenced_policy
+{};
+
+/** Common options for the parallel policies
+ */
+template < class Derived >
+struct basic_parallel_policy
+{
+   /** Number of threads, 0 uses thread_pool::default_concurrency() */
+   size_t num_threads = 0;
+   /** Number of indices per chunk, 0 picks a size automatically */
+   size_t chunk_size = 0;
+   schedule sched = schedule::dynamic;
+
+   constexpr Derived threads(size_t n) const noexcept
+   {
+      Derived p = static_cast<const Derived&>(*this);
+      p.num_threads = n;
+      return p;
+   }
+
+   constexpr Derived chunk(size_t n) const noexcept
+   {
+      Derived p = static_cast<const Derived&>(*this);
+      p.chunk_size = n;
+      return p;
+   }
+
+   constexpr Derived deterministic() const noexcept
+   {
+      Derived p = static_cast<const Derived&>(*this);
+      p.sched = schedule::deterministic;
+      return p;
+   }
+};
+
+/** Split the index range into chunks that run on the thread pool
+ */
+struct parallel_policy: basic_parallel_policy<parallel_policy>
+{};
+
+/** Split the index range into chunks that run on the thread pool, the
+ * iterations of a chunk may also be vectorized
+ */
+struct parallel_unsequenced_policy: basic_parallel_policy<parallel_unsequenced_policy>
+{};
+
+inline constexpr sequenced_policy seq{};
+inline constexpr parallel_policy par{};
+inline constexpr parallel_unsequenced_policy par_unseq{};
+
+template < class T >
+struct is_execution_policy: std::false_type
+{};
+
+template <>
+struct is_execution_policy<sequenced_policy>: std::true_type
+{};
+
+template <>
+struct is_execution_policy<parallel_policy>: std::true_type
+{};
+
+template <>
+struct is_execution_policy<parallel_unsequenced_policy>: std::true_type
+{};
+
+template < class T >
+inline constexpr bool is_execution_policy_v = is_execution_policy<std::remove_cv_t<std::remove_reference_t<T>>>::value;
+
+/** Chunk size used by the deterministic schedule when none is given
+ */
+inline constexpr size_t default_deterministic_chunk = 16384;
+
+/** Smallest chunk handed out by the dynamic schedule when none is given
+ */
+inline constexpr size_t default_min_chunk = 1024;
+
+} // namespace execution
+
+namespace detail
+{
+
+/** Call f(begin, end) over chunks of [begin, end) according to the policy
+ * @param policy execution policy
+ * @param begin first index
+ * @param end one past the last index
+ * @param f range functor
+ */
+template < class ExecutionPolicy, class F >
+void parallel_for(ExecutionPolicy&& policy, size_t begin, size_t end, F&& f);
+
+} // namespace detail
+} // namespace xlib
+
+#include "detail/execution.hpp"
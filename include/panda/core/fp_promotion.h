@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 
 namespace xlib
 {
@@ -14,11 +15,19 @@ struct promote_fp<TYPE>\
    using type = PTYPE;\
 }
 
+PROMOTE_FP_DEF(long double,long double);
 PROMOTE_FP_DEF(double,double);
 PROMOTE_FP_DEF(float,float);
 PROMOTE_FP_DEF(int8_t,float);
 PROMOTE_FP_DEF(int16_t,float);
 PROMOTE_FP_DEF(int32_t,float);
 PROMOTE_FP_DEF(int64_t,double);
+PROMOTE_FP_DEF(uint8_t,float);
+PROMOTE_FP_DEF(uint16_t,float);
+PROMOTE_FP_DEF(uint32_t,float);
+PROMOTE_FP_DEF(uint64_t,double);
+
+template < class T >
+using promote_fp_t = typename promote_fp<T>::type;
 
 }
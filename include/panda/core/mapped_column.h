@@ -0,0 +1,190 @@
+#pragma once
+
+#include "xlib/core/class_traits.h"
+#include "xlib/core/static_soa.h"
+
+#include <string>
+#include <type_traits>
+#include <cstddef>
+
+namespace xlib
+{
+
+/** How a mapped_column opens its file
+ */
+enum class map_mode
+{
+   /** Create the file, or truncate an existing one, and write changes back to it
+    */
+   create,
+   /** Map an existing file and write changes back to it
+    */
+   open,
+   /** Map an existing file privately, changes are never written back.
+    * Growing past the size of the file appends anonymous memory, pages that
+    * were not touched stay backed by the file.
+    */
+   copy_on_write
+};
+
+namespace detail
+{
+
+/** Memory mapping that holds a header followed by an array of elements
+ *
+ *    | header (magic, element size, data offset, size) | padding | data ... |
+ *
+ * The mapping is either anonymous or backed by a file, in which case the
+ * file has exactly the same layout, so opening a file maps its data in place
+ * without reading it. Memory past size() is always zero.
+ */
+class mapped_storage: non_copyable
+{
+public:
+   /** Anonymous storage, nothing is mapped before the first reallocate
+    */
+   mapped_storage(size_t element_size, size_t alignment) noexcept;
+
+   /** File backed storage
+    * @throw std::system_error if the file can not be opened or mapped
+    * @throw std::runtime_error if an existing file is not a column of element_size elements
+    */
+   mapped_storage(const std::string& path, map_mode mode, size_t element_size, size_t alignment);
+
+   mapped_storage(mapped_storage&& other) noexcept;
+   mapped_storage& operator=(mapped_storage&& other) noexcept;
+
+   /** Unmap, the file of a writable mapping is trimmed to size()
+    */
+   ~mapped_storage();
+
+   char* data() const noexcept { return _base ? _base + _offset : nullptr; }
+
+   size_t size() const noexcept;
+   void set_size(size_t n) noexcept;
+
+   size_t capacity() const noexcept;
+
+   /** Resize the mapping to hold capacity elements, capacity must fit size()
+    * @throw std::system_error if the file can not be resized or remapped
+    */
+   void reallocate(size_t capacity);
+
+   /** Flush a writable file mapping to disk
+    * @throw std::system_error if msync fails
+    */
+   void sync();
+
+   /** True if changes are written back to a file
+    */
+   bool file_backed() const noexcept { return _fd >= 0 && _mode != map_mode::copy_on_write; }
+
+   void swap(mapped_storage& other) noexcept;
+
+private:
+   struct header;
+   header* get_header() const noexcept { return reinterpret_cast<header*>(_base); }
+
+   void remap(size_t bytes);
+
+   /** Resize a copy_on_write mapping without reading the file pages
+    */
+   void remap_private(size_t bytes);
+
+   char* _base = nullptr;
+   size_t _bytes = 0;
+   /** Page rounded length of the private file mapping at the front of _base */
+   size_t _file_bytes = 0;
+   int _fd = -1;
+   map_mode _mode = map_mode::create;
+   size_t _element_size;
+   size_t _offset;
+};
+
+} // namespace detail
+
+/** Column whose elements live in a memory mapping, optionally backed by a file
+ *
+ * A mapped_column opened on a file maps the data in place, so opening a
+ * checkpoint costs nothing up front and pages are only read from disk when
+ * they are first touched. Resizing grows the file with ftruncate and the
+ * mapping with mremap, sync() flushes the data to disk. A default
+ * constructed column uses anonymous memory.
+ *
+ * Open the columns of a static_soa by move assigning them:
+ *
+ *    xlib::static_soa<xlib::mapped_column<double>, xlib::mapped_column<int>> soa;
+ *    soa.get_data<0>() = xlib::mapped_column<double>("mass.col", xlib::map_mode::copy_on_write);
+ *    soa.get_data<1>() = xlib::mapped_column<int>("id.col", xlib::map_mode::copy_on_write);
+ *
+ * @tparam T element type, must be trivial since elements are stored as bytes
+ */
+template < class T >
+class mapped_column
+{
+   static_assert(std::is_trivially_copyable<T>::value && std::is_trivially_default_constructible<T>::value,
+      "mapped_column elements must be trivial");
+public:
+   using value_type = T;
+   using reference = T&;
+   using const_reference = const T&;
+   using iterator = T*;
+   using const_iterator = const T*;
+
+   mapped_column() noexcept;
+
+   /** Map a column file
+    * @param path file to map
+    * @param mode how to open the file
+    */
+   explicit mapped_column(const std::string& path, map_mode mode = map_mode::open);
+
+   mapped_column(mapped_column&& other) noexcept = default;
+   mapped_column& operator=(mapped_column&& other) noexcept = default;
+
+   T& operator[](size_t i) noexcept { assert(i < this->size()); return this->data()[i]; }
+   const T& operator[](size_t i) const noexcept { assert(i < this->size()); return this->data()[i]; }
+
+   T* data() noexcept { return reinterpret_cast<T*>(_storage.data()); }
+   const T* data() const noexcept { return reinterpret_cast<const T*>(_storage.data()); }
+
+   iterator begin() noexcept { return this->data(); }
+   iterator end() noexcept { return this->data() + this->size(); }
+   const_iterator begin() const noexcept { return this->data(); }
+   const_iterator end() const noexcept { return this->data() + this->size(); }
+
+   size_t size() const noexcept { return _storage.size(); }
+   size_t capacity() const noexcept { return _storage.capacity(); }
+   bool empty() const noexcept { return this->size() == 0; }
+
+   /** Resize the column, new elements are value initialized
+    * @param n new number of elements
+    */
+   void resize(size_t n);
+
+   void reserve(size_t n);
+   void shrink_to_fit();
+
+   /** Flush the column to its file, does nothing for anonymous columns
+    */
+   void sync() { _storage.sync(); }
+
+   /** True if changes are written back to a file
+    */
+   bool file_backed() const noexcept { return _storage.file_backed(); }
+
+   void swap(mapped_column& other) noexcept { _storage.swap(other._storage); }
+
+private:
+   detail::mapped_storage _storage;
+};
+
+template < class T >
+void swap(mapped_column<T>& lhs, mapped_column<T>& rhs) noexcept
+{
+   lhs.swap(rhs);
+}
+
+} // namespace xlib
+
+#include "detail/mapped_column.hpp"
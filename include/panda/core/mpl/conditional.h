@@ -1,26 +1,32 @@
 #pragma once
 
+#include <type_traits>
+
 namespace xlib
 {
 namespace mpl
 {
 
 // mpl IF
-template < class Condition, class T, class F >
-struct if_;
+template < bool Condition, class T, class F >
+struct if_c;
 
 template < class T, class F >
-struct if_<std::true_type, T, F>
+struct if_c<true, T, F>
 {
    using type = T;
 };
 
 template < class T, class F >
-struct if_<std::false_type, T, F>
+struct if_c<false, T, F>
 {
    using type = F;
 };
 
+template < class Condition, class T, class F >
+struct if_: if_c<Condition::value, T, F>
+{};
+
 template < class Condition, class T, class F >
 using if_t = typename if_<Condition, T, F>::type;
 
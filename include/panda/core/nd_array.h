@@ -0,0 +1,241 @@
+#pragma once
+
+#include <xlib/core/assert.h>
+#include <xlib/core/static_soa.h>
+
+#include <array>
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+namespace xlib
+{
+
+/** Order of the components of an nd_array in memory
+ */
+enum class nd_layout
+{
+   /** The components of every element are contiguous,
+    *    | e0c0 e0c1 ... | e1c0 e1c1 ... |
+    */
+   row_major,
+   /** Every component is stored in its own plane across all elements,
+    *    | e0c0 e1c0 ... | e0c1 e1c1 ... |
+    * so that loops over elements are unit stride per component
+    */
+   column_major
+};
+
+/** Reference to one element of an nd_array, an array of Rank components
+ * with run time extents
+ *
+ * Flat component j lives at data()[j * stride()], multi-indices are row
+ * major over the extents. Assigning to an nd_ref writes through to the
+ * array, copying an nd_ref only copies the reference. Use load() to copy the
+ * components out.
+ */
+template < class T, size_t Rank >
+class nd_ref
+{
+public:
+   using value_type = std::vector<std::remove_const_t<T>>;
+   using extents_type = std::array<size_t,Rank>;
+
+   nd_ref(T* p, size_t stride, const extents_type& extents) noexcept: _p(p), _stride(stride), _extents(extents) {}
+   nd_ref(const nd_ref&) = default;
+
+   template < class U, class = std::enable_if_t<std::is_same<const U,T>::value && !std::is_same<U,T>::value> >
+   nd_ref(const nd_ref<U,Rank>& other) noexcept: _p(other._p), _stride(other._stride), _extents(other._extents) {}
+
+   /** Flat component j
+    */
+   T& operator[](size_t j) const { _XLIB_ASSERT(RANGE, 0, this->size(), j); return _p[j * _stride]; }
+
+   /** Component at a multi-index, one index per extent
+    */
+   template < class... Index >
+   T& operator()(Index... index) const;
+
+   /** Number of components
+    */
+   size_t size() const noexcept;
+
+   size_t extent(size_t d) const noexcept { return _extents[d]; }
+   const extents_type& extents() const noexcept { return _extents; }
+
+   /** Distance between two consecutive components, 1 for row_major arrays
+    */
+   size_t stride() const noexcept { return _stride; }
+
+   /** First component, contiguous with the others if stride() is 1
+    */
+   T* data() const noexcept { return _p; }
+
+   value_type load() const;
+
+   operator value_type() const { return this->load(); }
+
+   /** Copy the components of v, which must have size() components
+    */
+   const nd_ref& operator=(const value_type& v) const;
+
+   const nd_ref& operator=(const nd_ref& rhs) const;
+
+   template < class U >
+   const nd_ref& operator=(const nd_ref<U,Rank>& rhs) const;
+
+   /** Set every component to value
+    */
+   void fill(std::remove_const_t<T> value) const;
+
+private:
+   template < class U >
+   void assign(const nd_ref<U,Rank>& rhs) const;
+
+   T* _p;
+   size_t _stride;
+   extents_type _extents;
+   template < class, size_t > friend class nd_ref;
+};
+
+/** Column of arrays with a compile time rank and run time extents, such as
+ * the mass fractions of a run time number of species for every parcel
+ *
+ * Every element is an array of Rank - 1 dimensions with the same extents,
+ * all elements share one contiguous buffer in the given layout. The column
+ * behaves like a std::vector of flattened arrays whose operator[] returns
+ * nd_ref proxies, and plugs into static_soa through the soa_* column traits.
+ *
+ * The extents are set on construction or with set_extents while the array is
+ * empty. Callbacks passed to static_soa::apply_to_element and friends receive
+ * nd_ref<T,Rank-1> by value for nd_array columns, so they should take auto
+ * parameters.
+ *
+ * @tparam T component type, must be arithmetic
+ * @tparam Rank number of dimensions including the element index, at least 2
+ * @tparam Layout order of the components in memory
+ */
+template < class T, size_t Rank, nd_layout Layout = nd_layout::row_major >
+class nd_array
+{
+   static_assert(std::is_arithmetic<T>::value, "nd_array components must be arithmetic");
+   static_assert(Rank >= 2, "nd_array requires at least one dimension besides the element index");
+public:
+   using value_type = std::vector<T>;
+   using component_type = T;
+   using reference = nd_ref<T,Rank-1>;
+   using const_reference = nd_ref<const T,Rank-1>;
+   using extents_type = std::array<size_t,Rank-1>;
+
+   static constexpr size_t rank = Rank;
+   static constexpr nd_layout layout = Layout;
+
+   /** Position in an nd_array, the result of data(), used by
+    * static_soa::apply_blocked to hand out blocks of a column
+    */
+   template < class Array >
+   class basic_pointer
+   {
+   public:
+      basic_pointer(Array* array, size_t offset) noexcept: _array(array), _offset(offset) {}
+
+      basic_pointer operator+(size_t n) const noexcept { return basic_pointer(_array, _offset + n); }
+      auto operator[](size_t i) const { return (*_array)[_offset + i]; }
+
+   private:
+      Array* _array;
+      size_t _offset;
+   };
+
+   using pointer = basic_pointer<nd_array>;
+   using const_pointer = basic_pointer<const nd_array>;
+
+   nd_array() = default;
+   explicit nd_array(const extents_type& extents, size_t n = 0);
+   nd_array(const nd_array& other);
+   nd_array(nd_array&& other) noexcept;
+   nd_array& operator=(const nd_array& other);
+   nd_array& operator=(nd_array&& other) noexcept;
+   ~nd_array();
+
+   reference operator[](size_t i) noexcept;
+   const_reference operator[](size_t i) const noexcept;
+
+   /** Flat component j of element i
+    */
+   T& component(size_t i, size_t j) noexcept { return _data[this->offset(i, j)]; }
+   const T& component(size_t i, size_t j) const noexcept { return _data[this->offset(i, j)]; }
+
+   /** Flat component j of every element, unit stride, column_major only
+    */
+   T* plane(size_t j) noexcept;
+   const T* plane(size_t j) const noexcept;
+
+   pointer data() noexcept { return pointer(this, 0); }
+   const_pointer data() const noexcept { return const_pointer(this, 0); }
+
+   /** Buffer holding every component in the layout of the array
+    */
+   T* flat_data() noexcept { return _data; }
+   const T* flat_data() const noexcept { return _data; }
+
+   size_t size() const noexcept { return _size; }
+   size_t capacity() const noexcept { return _capacity; }
+   bool empty() const noexcept { return _size == 0; }
+
+   /** Number of components of every element, the product of the extents
+    */
+   size_t width() const noexcept { return _width; }
+   size_t extent(size_t d) const noexcept { return _extents[d]; }
+   const extents_type& extents() const noexcept { return _extents; }
+
+   /** Set the extents of every element, the array must be empty
+    */
+   void set_extents(const extents_type& extents);
+
+   /** Resize the array, new elements are value initialized
+    * @param n new number of elements
+    */
+   void resize(size_t n);
+
+   /** Resize the array, new elements are copies of value
+    * @param n new number of elements
+    * @param value components of new elements, must hold width() components
+    */
+   void resize(size_t n, const value_type& value);
+
+   void reserve(size_t n);
+   void shrink_to_fit();
+
+   void swap(nd_array& other) noexcept;
+
+private:
+   size_t offset(size_t i, size_t j) const noexcept;
+
+   /** Number of components between two components of the same element
+    */
+   size_t stride() const noexcept { return Layout == nd_layout::row_major ? 1 : _capacity; }
+
+   /** Move storage to a new capacity, capacity must fit the current size and
+    * be rounded with round_capacity
+    */
+   void reallocate(size_t capacity);
+
+   static size_t round_capacity(size_t n) noexcept;
+
+   T* _data = nullptr;
+   size_t _size = 0;
+   size_t _capacity = 0;
+   size_t _width = 0;
+   extents_type _extents = {};
+};
+
+template < class T, size_t Rank, nd_layout Layout >
+void swap(nd_array<T,Rank,Layout>& lhs, nd_array<T,Rank,Layout>& rhs) noexcept
+{
+   lhs.swap(rhs);
+}
+
+} // namespace xlib
+
+#include "detail/nd_array.hpp"
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <xlib/core/execution.h>
+
+#include <cstddef>
+#include <vector>
+
+namespace xlib
+{
+
+/** Number of NUMA nodes of the machine
+ * @return number of nodes, 1 if the topology can not be queried
+ */
+size_t numa_node_count() noexcept;
+
+/** NUMA node the calling thread currently runs on
+ * @return node of the calling thread, 0 if it can not be queried
+ */
+int numa_current_node() noexcept;
+
+/** NUMA node the page holding an address is placed on
+ * @param p address to query
+ * @return node of the page, -1 if the page was never touched or the
+ * placement can not be queried
+ */
+int numa_node_of(const void* p) noexcept;
+
+/** NUMA nodes of a batch of pages, queried with a single system call
+ * @param pages addresses to query
+ * @param count number of addresses
+ * @param nodes receives the node of every address, -1 where unknown
+ */
+void numa_nodes_of(const void* const* pages, size_t count, int* nodes) noexcept;
+
+/** Chunk of an index range together with where it runs and where its
+ * memory lives
+ */
+struct numa_partition
+{
+   /** Thread index of a chunk that any thread may run */
+   static constexpr size_t any_thread = size_t(-1);
+
+   size_t begin;
+   size_t end;
+   /** Thread that runs the chunk under a deterministic policy, any_thread otherwise */
+   size_t thread;
+   /** Node most sampled pages of the chunk are placed on, -1 if unknown */
+   int node;
+};
+
+/** Split n elements of an array into the chunks a policy runs them in and
+ * report the NUMA node each chunk's memory is placed on. With
+ * execution::par.deterministic() this shows whether the pages of every chunk
+ * were first touched by the thread that works on them.
+ * @param policy execution policy the array is processed with
+ * @param data array of at least n elements
+ * @param n number of elements
+ * @return chunks of [0, n) in order
+ */
+template < class ExecutionPolicy, class T >
+std::vector<numa_partition> numa_partitions(ExecutionPolicy&& policy, const T* data, size_t n);
+
+} // namespace xlib
+
+#include <xlib/core/detail/numa.hpp>
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <xlib/core/static_soa.h>
+
+#include <cstddef>
+
+/** Declare a struct named TYPE that stores named fields in a static_soa
+ *
+ *    XLIB_PARCEL_STORAGE(liquid_parcels,
+ *       XLIB_PARCEL_DATA(
+ *          (position, std::vector<xlib::vec<double,3>>),
+ *          (radius, double*),
+ *          (cell_index, std::vector<int64_t>)
+ *       ),
+ *       XLIB_MEMBER_DATA(
+ *          (density, 1000.0, double),
+ *          (num_species, 0, int)
+ *       )
+ *    );
+ *
+ * Every field (name, type) becomes a column of TYPE::storage_type, in order,
+ * and gets the accessors
+ *
+ *    name()         the column, the same reference as storage().get_data<I>()
+ *    name(i)        element i of the column
+ *
+ * which are inline calls down to std::get<I>, without any virtual call or
+ * lookup. TYPE::field is an enum of the column indices, so
+ * get<TYPE::field::radius>() and storage().get_data<size_t(TYPE::field::radius)>()
+ * replace magic numbers in generic code. field_names holds the names in order.
+ *
+ * Every member (name, initial value, type) of the optional XLIB_MEMBER_DATA
+ * list becomes a plain data member of TYPE, the initial value may be wrapped
+ * in parentheses if it contains commas. for_each_field and for_each_member
+ * call f(name, reference) for every field or member.
+ *
+ * Types may contain commas, field and member names must not collide with
+ * the rest of the interface: field, storage, size, resize, reserve, get,
+ * for_each_field and for_each_member. Up to 64 fields and members are supported.
+ */
+#define XLIB_PARCEL_STORAGE(...) XLIB_PP_CAT(XLIB_PARCEL_STORAGE_, XLIB_PP_COUNT(__VA_ARGS__))(__VA_ARGS__)
+
+/** List of (name, type) fields of XLIB_PARCEL_STORAGE
+ */
+#define XLIB_PARCEL_DATA(...) (__VA_ARGS__)
+
+/** List of (name, initial value, type) members of XLIB_PARCEL_STORAGE
+ */
+#define XLIB_MEMBER_DATA(...) (__VA_ARGS__)
+
+#include "detail/parcel_storage.hpp"
@@ -0,0 +1,195 @@
+#pragma once
+
+#include <xlib/core/class_traits.h>
+#include <xlib/core/timer.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace xlib
+{
+namespace detail
+{
+
+/** Node of the call tree of one thread
+ */
+struct profile_node
+{
+   const char* name;
+   uint32_t parent;
+   uint32_t first_child;
+   uint32_t next_sibling;
+   uint64_t calls;
+   uint64_t inclusive;
+   uint64_t children;
+};
+
+/** Completed region, recorded for trace export
+ */
+struct profile_event
+{
+   const char* name;
+   uint64_t begin;
+   uint64_t end;
+};
+
+/** Call tree accumulated by one thread, only touched by its thread while
+ * the profiler is running
+ */
+class thread_profile
+{
+public:
+   static constexpr uint32_t npos = ~uint32_t(0);
+
+   explicit thread_profile(size_t thread_index);
+
+   /** Enter the child region name of the current region
+    * @return call tree node of the region
+    */
+   uint32_t enter(const char* name);
+
+   /** Leave a region entered with enter
+    */
+   void leave(uint32_t node, uint64_t begin, uint64_t end);
+
+   void clear();
+
+   std::vector<profile_node> nodes;
+   std::vector<profile_event> events;
+   size_t dropped_events = 0;
+   uint32_t current = 0;
+   size_t thread_index;
+};
+
+} // namespace detail
+
+/** Low overhead hierarchical region profiler
+ *
+ * Regions are opened with a profile_scope (or XLIB_PROFILE_SCOPE) and nest
+ * into a call tree per thread. Each thread accumulates calls and inclusive
+ * time per call tree node without locking, time is read from tsc_clock.
+ * While the profiler is disabled a scope costs a single relaxed load.
+ *
+ * Reports merge the call trees of all threads. The profiler must not be
+ * reset or reported while other threads are inside of a region.
+ */
+class profiler: non_copyable, non_moveable
+{
+public:
+   /** Accumulated statistics of one call tree path
+    */
+   struct region_stats
+   {
+      /** Region names from the root, separated by '/' */
+      std::string path;
+      size_t depth;
+      uint64_t calls;
+      /** Seconds spent in the region summed over all threads */
+      double inclusive;
+      /** Seconds spent in the region but not in its child regions */
+      double exclusive;
+      /** Number of threads that entered a region of this name */
+      size_t threads;
+      /** Maximum over mean time per thread spent in regions of this name */
+      double imbalance;
+   };
+
+   static profiler& instance();
+
+   /** Check if scopes are recorded
+    */
+   static bool enabled() noexcept
+   {
+      return _enabled.load(std::memory_order_relaxed);
+   }
+
+   /** Start recording scopes
+    * @param trace also record every region for write_chrome_trace
+    * @param max_events_per_thread events recorded per thread before further events are dropped
+    */
+   void enable(bool trace = false, size_t max_events_per_thread = size_t(1) << 20);
+
+   /** Stop recording scopes, the accumulated data is kept
+    */
+   void disable() noexcept;
+
+   /** Discard all of the accumulated data
+    */
+   void reset();
+
+   /** Call tree merged over all threads, in depth first order
+    */
+   std::vector<region_stats> stats() const;
+
+   /** Print the call tree with inclusive and exclusive time, call counts
+    * and thread imbalance
+    */
+   void report(std::ostream& os) const;
+
+   /** Write the recorded regions as Chrome trace event JSON
+    * (chrome://tracing, Perfetto)
+    */
+   void write_chrome_trace(std::ostream& os) const;
+
+   /** Call tree of the calling thread
+    */
+   static detail::thread_profile& local();
+
+   /** True if regions are recorded for trace export
+    */
+   bool tracing() const noexcept { return _trace; }
+   size_t max_events() const noexcept { return _max_events; }
+
+private:
+   profiler() = default;
+
+   detail::thread_profile& add_thread();
+   double seconds_per_tick() const;
+
+   static inline std::atomic<bool> _enabled{false};
+
+   mutable std::mutex _lock;
+   std::vector<std::unique_ptr<detail::thread_profile>> _threads;
+   bool _trace = false;
+   size_t _max_events = 0;
+   uint64_t _start_ticks = 0;
+   std::chrono::steady_clock::time_point _start_time;
+};
+
+/** Time the enclosing scope as a profiler region
+ */
+class profile_scope: non_copyable, non_moveable
+{
+public:
+   /** @param name region name, must outlive the profiler data (e.g. a string literal)
+    */
+   explicit profile_scope(const char* name) noexcept;
+   ~profile_scope();
+
+private:
+   detail::thread_profile* _profile = nullptr;
+   uint32_t _node = 0;
+   uint64_t _begin = 0;
+};
+
+} // namespace xlib
+
+#define XLIB_PROFILE_CONCAT_IMPL(A, B) A##B
+#define XLIB_PROFILE_CONCAT(A, B) XLIB_PROFILE_CONCAT_IMPL(A, B)
+
+/** Profile the enclosing scope under the given region name, compiled out
+ * when XLIB_DISABLE_PROFILER is defined
+ */
+#if defined(XLIB_DISABLE_PROFILER)
+#define XLIB_PROFILE_SCOPE(NAME)
+#else
+#define XLIB_PROFILE_SCOPE(NAME) ::xlib::profile_scope XLIB_PROFILE_CONCAT(xlib_profile_scope_, __LINE__)(NAME)
+#endif
+
+#include "detail/profiler.hpp"
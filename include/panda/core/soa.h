@@ -1,42 +1,85 @@
 #pragma once
 
 #include "xlib/core/class_traits.h"
+#include "xlib/core/static_soa.h"
 
 #include <type_traits>
-#include <set>
+#include <memory>
+#include <vector>
 #include <mutex>
+#include <functional>
 
 namespace xlib
 {
 
+/** Structure of arrays whose arrays are registered at run time
+ *
+ * Every registered array is stored in its own entry, entries are never moved
+ * or freed before the bucket is destroyed. Handles point straight at their
+ * entry, so getting data through a handle takes no lock and touches only the
+ * entry. Registering data and resizing are serialized by the bucket.
+ */
 class soa_bucket: non_copyable
 {
+public:
+   /** Type erased registered array
+    */
    class entry
    {
-      size_t size() const;
-      void resize(size_t n);
+   public:
+      virtual ~entry() = default;
+
+      virtual size_t size() const = 0;
+      virtual void resize(size_t n) = 0;
+      virtual void reorder(const detail::soa_permutation<size_t>& perm) = 0;
+
+      soa_bucket* parent() const noexcept { return _parent; }
+      size_t index() const noexcept { return _index; }
+      const void* type() const noexcept { return _type; }
 
-      soa_bucket* parent() const;
+   protected:
+      entry(soa_bucket* parent, size_t index, const void* type):
+         _parent(parent), _index(index), _type(type) {}
+
+   private:
+      soa_bucket* _parent;
+      size_t _index;
+      const void* _type;
+      std::vector<entry*> _dependencies;
+      friend soa_bucket;
    };
+
    template < class T >
    class meta_entry;
 
-public:
+   soa_bucket() = default;
    ~soa_bucket();
+
    /** Basic handle
     */
    class handle
    {
    public:
-      soa_bucket::entry* entry();
+      handle() = default;
+
+      soa_bucket::entry* entry() const noexcept { return _e; }
 
       template < class T >
-      T& data();
+      T& data() const noexcept;
 
-   private:
+      /** Check the type of the data the handle refers to
+       * @return true if the registered data has type T
+       */
+      template < class T >
+      bool is() const noexcept
+      {
+         return _e && _e->type() == detail::type_id<T>();
+      }
+
+   protected:
       handle(soa_bucket::entry* e): _e(e) {}
 
-      soa_bucket::entry* _e;
+      soa_bucket::entry* _e = nullptr;
       friend soa_bucket;
    };
 
@@ -46,11 +89,17 @@ public:
    class meta_handle: public handle
    {
    public:
-      T& data()
+      meta_handle() = default;
+
+      T& data() const noexcept
       {
-         return static_cast<handle*>(this)->data<T>();
+         return this->handle::template data<T>();
       }
-   }
+
+   private:
+      meta_handle(soa_bucket::entry* e): handle(e) {}
+      friend soa_bucket;
+   };
 
    /** Register data to the soa bucket, use default constructor for T
     * @return Handle to registered data
@@ -59,6 +108,7 @@ public:
    soa_bucket::meta_handle<T> register_data();
 
    /** Register data to the soa bucket based on a copy of a T container
+    * The copy is resized to the size of the bucket.
     * @param copied data storage to copied into the soa bucket
     * @return Handle to registered data
     */
@@ -66,10 +116,11 @@ public:
    soa_bucket::meta_handle<T> register_data(const T& copied);
 
    /** Register data to the soa bucket based on a copy of a T container
+    * The moved data is resized to the size of the bucket.
     * @param moved data storaged moved into the soa bucket
     * @return Handle to registered data
     */
-   template < class T, class = std::enable_if_t<std::is_move_constructible<T>::value> >
+   template < class T, class = std::enable_if_t<std::is_move_constructible<T>::value && !std::is_lvalue_reference<T>::value> >
    soa_bucket::meta_handle<T> register_data(T&& move);
 
    /** Get data referenced by the handle
@@ -77,37 +128,102 @@ public:
     * @return data container
     */
    template < class T >
-   T& get_data(const soa_bucket::meta_handle<T>& h);
+   T& get_data(const soa_bucket::meta_handle<T>& h) noexcept;
 
    /** Get data referenced by the handle
-    * @tparam T Container type expected from the 
+    * @tparam T Container type expected from the
     * @param h handle
     * @return data container
     */
    template < class T >
-   T& get_data(const soa_bucket::handle& h);
+   T& get_data(const soa_bucket::handle& h) noexcept;
 
    /** Get data referenced by the handle
-    * @tparam T Container type expected from the 
+    * @tparam T Container type expected from the
     * @param h handle with meta template info
-    * @return entry data stored in the 
+    * @return entry data stored in the
     */
    template < class T >
-   soa_bucket::entry* get_entry(const soa_bucket::handle& h);
+   soa_bucket::entry* get_entry(const soa_bucket::handle& h) noexcept;
 
    /** Link two dataset together, data_handle depends on the data of depency_handle
+    * Structural operations (resize, reorder) process a dependency before the
+    * data that depends on it.
     * @param h handle to some data in soa bucket
     * @param dependency_handle handle that handle h is dependent on
+    * @throw std::invalid_argument if the link would create a dependency cycle
     */
    void add_data_dependency(const handle& h, const handle& dependency_handle);
 
+   /** Resize all of the registered data in dependency order, data that does
+    * not depend on each other is resized in parallel
+    * @param n new size
+    */
+   void resize(size_t n);
+
+   /** Resize all of the registered data in dependency order
+    * @param policy execution policy used for data that does not depend on each other
+    * @param n new size
+    */
+   template < class ExecutionPolicy,
+      class = std::enable_if_t<execution::is_execution_policy_v<ExecutionPolicy>> >
+   void resize(ExecutionPolicy&& policy, size_t n);
+
+   /** Reorder the elements of all of the registered data in dependency order,
+    * data that does not depend on each other is reordered in parallel
+    * @param new_index_map new indices of each element, element i moves to
+    *        new_index_map[i], must be a permutation of [0, size())
+    */
+   void reorder(const std::vector<size_t>& new_index_map);
+
+   /** Reorder the elements of all of the registered data in dependency order
+    * @param policy execution policy used for data that does not depend on each other
+    * @param new_index_map new indices of each element, element i moves to
+    *        new_index_map[i], must be a permutation of [0, size())
+    */
+   template < class ExecutionPolicy,
+      class = std::enable_if_t<execution::is_execution_policy_v<ExecutionPolicy>> >
+   void reorder(ExecutionPolicy&& policy, const std::vector<size_t>& new_index_map);
+
+   /** Size of all of the registered data
+    * @return number of elements in each registered array
+    */
+   size_t size() const;
+
+   /** Number of registered arrays
+    * @return number of registered arrays
+    */
+   size_t num_entries() const;
+
 private:
-   struct entry_info;
+   template < class T, class... Args >
+   soa_bucket::meta_handle<T> emplace_data(Args&&... args);
+
+   /** Number of threads an execution policy asks for
+    */
+   template < class ExecutionPolicy >
+   static size_t num_threads(const ExecutionPolicy& policy) noexcept;
+
+   /** Call f on every entry, level by level of the dependency graph, the
+    * entries of one level run on up to num_threads threads. Requires _map_lock.
+    */
+   void for_each_in_dependency_order(size_t num_threads, const std::function<void(entry&)>& f);
+
+   /** Group the entries into levels, every entry only depends on entries
+    * of earlier levels. Requires _map_lock.
+    */
+   void update_levels();
+
+   void resize_impl(size_t num_threads, size_t n);
+   void reorder_impl(size_t num_threads, const std::vector<size_t>& new_index_map);
 
-   std::mutex _map_lock;
-   std::set<entry_info*> _data;
+   mutable std::mutex _map_lock;
+   std::vector<std::unique_ptr<entry>> _data;
+   std::vector<std::vector<entry*>> _levels;
+   bool _levels_valid = false;
+   size_t _size = 0;
 };
 
 } // namespace xlib
 
-#include "detail/soa.hpp"
\ No newline at end of file
+#include "detail/soa.hpp"
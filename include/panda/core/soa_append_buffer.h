@@ -0,0 +1,117 @@
+#pragma once
+
+#include <xlib/core/execution.h>
+#include <xlib/core/static_soa.h>
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace xlib
+{
+
+/** Staging area for elements appended to a static_soa by many threads at
+ * once, e.g. parcels created by concurrent injectors
+ *
+ * Every thread appends rows to its own stage, a container of the same type
+ * as the target, without any synchronization. Stages are handed out by
+ * acquire(), a single atomic fetch-add, or by index with get_stage(t) for threads
+ * that already have one (e.g. thread_pool threads). commit() resizes the
+ * target once and copies every stage behind its old elements in parallel,
+ * with memcpy for std::vector and raw pointer columns of trivially copyable
+ * types.
+ *
+ * Appending, acquire() and get_stage(t) may run concurrently with each other,
+ * commit() and for_each_stage() must not run concurrently with anything.
+ * @tparam Soa static_soa type
+ */
+template < class Soa >
+class soa_append_buffer
+{
+public:
+   /** Rows staged by one thread, aligned so that threads appending to
+    * neighbouring stages do not share cache lines
+    */
+   class alignas(64) stage
+   {
+   public:
+      /** Add n value initialized rows
+       * @return index of the first added row
+       */
+      size_t append(size_t n = 1);
+
+      /** Add one row with a value per column
+       * @return index of the row
+       */
+      template < class... Values >
+      size_t push_back(Values&&... values);
+
+      /** Staged rows, the columns can be written through get_data
+       */
+      Soa& rows() noexcept { return _rows; }
+      const Soa& rows() const noexcept { return _rows; }
+
+      size_t size() const noexcept { return _rows.size(); }
+
+   private:
+      Soa _rows;
+   };
+
+   /** @param target container that commit() appends to
+    * @param max_stages number of stages, the most threads that can append
+    *        between two commits, 0 uses thread_pool::default_concurrency()
+    */
+   explicit soa_append_buffer(Soa& target, size_t max_stages = 0);
+   soa_append_buffer(const soa_append_buffer&) = delete;
+   soa_append_buffer& operator=(const soa_append_buffer&) = delete;
+
+   /** Hand out an unused stage to the calling thread, lock free
+    * @throw std::length_error if every stage is in use since the last commit
+    */
+   stage& acquire();
+
+   /** Stage t, for threads with a fixed index
+    */
+   stage& get_stage(size_t t) noexcept;
+
+   size_t max_stages() const noexcept { return _stages.size(); }
+
+   /** Number of rows in every stage, must not run concurrently with appends
+    */
+   size_t size() const noexcept;
+
+   /** Call f(Soa&) on the rows of every stage, e.g. to set up columns whose
+    * layout is chosen at run time
+    */
+   template < class F >
+   void for_each_stage(F&& f);
+
+   /** Append the rows of every stage to the target in stage order and empty
+    * the stages, every stage becomes available to acquire() again
+    * @return index of the first appended row in the target
+    */
+   size_t commit();
+
+   /** Append the rows of every stage to the target, copying the stages
+    * across threads
+    */
+   template < class ExecutionPolicy,
+      class = std::enable_if_t<execution::is_execution_policy_v<ExecutionPolicy>> >
+   size_t commit(ExecutionPolicy&& policy);
+
+   Soa& target() noexcept { return *_target; }
+
+private:
+   /** Copy the rows of every stage behind the old elements of the target
+    */
+   template < class ExecutionPolicy >
+   size_t commit_impl(ExecutionPolicy&& policy);
+
+   Soa* _target;
+   std::vector<stage> _stages;
+   std::atomic<size_t> _acquired{0};
+};
+
+} // namespace xlib
+
+#include "detail/soa_append_buffer.hpp"
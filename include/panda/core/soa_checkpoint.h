@@ -0,0 +1,172 @@
+#pragma once
+
+#include "xlib/core/class_traits.h"
+#include "xlib/core/static_soa.h"
+#include "xlib/core/vector.h"
+
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace xlib
+{
+
+/** How save writes a checkpoint
+ */
+enum class checkpoint_mode
+{
+   /** Write every column to a new file that replaces the old one once complete
+    */
+   full,
+   /** Write only the columns whose contents changed since the checkpoint in
+    * the file. They go to free regions of the file and the header switches
+    * to them last, so a crash during the save leaves the previous checkpoint
+    * intact. Falls back to a full write when the file does not hold a
+    * checkpoint with the same columns and size.
+    */
+   incremental
+};
+
+/** Tag stored in a checkpoint for every column to check that a checkpoint
+ * is loaded into columns of the same element type. Specialize for element
+ * types whose layout should be checked beyond their size, 0 only checks the
+ * element size.
+ */
+template < class T, class = void >
+struct checkpoint_type_tag: std::integral_constant<uint64_t, 0>
+{};
+
+template < class T >
+struct checkpoint_type_tag<T, std::enable_if_t<std::is_arithmetic<T>::value>>:
+   std::integral_constant<uint64_t,
+      (std::is_same<T,bool>::value ? 0x400 :
+       std::is_floating_point<T>::value ? 0x300 :
+       std::is_signed<T>::value ? 0x100 : 0x200) | sizeof(T)>
+{};
+
+template < class T, size_t N >
+struct checkpoint_type_tag<vec<T,N>>:
+   std::integral_constant<uint64_t, (uint64_t(N) << 32) | 0x8000 | checkpoint_type_tag<T>::value>
+{};
+
+/** Write all of the columns of a static_soa to a checkpoint file
+ *
+ * The file holds a header (column count, size, and per column the element
+ * size, type tag, payload offset and length and a hash of the payload)
+ * followed by the raw payload of every column. Each column is written on its
+ * own thread, contiguous columns of trivially copyable elements straight
+ * from their storage.
+ * @param soa data to write, element types must be trivially copyable, which
+ *    is checked at compile time
+ * @param path checkpoint file
+ * @param mode full or incremental checkpoint
+ * @return number of columns written
+ * @throw std::system_error if the file can not be written
+ */
+template < class Allocator, class... Types >
+size_t save(const basic_static_soa<Allocator, Types...>& soa, const std::string& path, checkpoint_mode mode = checkpoint_mode::full);
+
+/** Read a checkpoint written by save into a static_soa of the same column types
+ * The static_soa is resized to the size of the checkpoint.
+ * @param soa data to read into
+ * @param path checkpoint file
+ * @throw std::system_error if the file can not be read
+ * @throw std::runtime_error if the file does not match the columns of soa or is corrupted
+ */
+template < class Allocator, class... Types >
+void load(basic_static_soa<Allocator, Types...>& soa, const std::string& path);
+
+namespace detail
+{
+
+/** Column entry of a checkpoint header
+ */
+struct checkpoint_column
+{
+   uint64_t element_size;
+   uint64_t type_tag;
+   uint64_t offset;
+   uint64_t bytes;
+   uint64_t hash;
+};
+
+/** Streaming 64 bit hash of a byte sequence, the digest does not depend on
+ * how the sequence is split between calls to update
+ */
+class checkpoint_hasher
+{
+public:
+   checkpoint_hasher() noexcept;
+   void update(const void* data, size_t bytes) noexcept;
+   uint64_t digest() const noexcept;
+
+private:
+   void consume(const unsigned char* block) noexcept;
+
+   uint64_t _lanes[4];
+   unsigned char _tail[32];
+   size_t _tail_bytes = 0;
+   uint64_t _total = 0;
+};
+
+/** Checkpoint file opened for reading or writing
+ */
+class checkpoint_file: non_copyable
+{
+public:
+   enum open_mode
+   {
+      open_read,
+      open_update,
+      open_truncate
+   };
+
+   /** @throw std::system_error if the file can not be opened
+    */
+   checkpoint_file(const std::string& path, open_mode mode);
+   ~checkpoint_file();
+
+   /** Read the header of the file
+    * @return false if the file does not hold a checkpoint
+    */
+   bool read_header(uint64_t& size, std::vector<checkpoint_column>& columns);
+
+   void write_header(uint64_t size, const std::vector<checkpoint_column>& columns);
+
+   /** Assign page aligned payload offsets to the columns and size the file
+    */
+   void layout(std::vector<checkpoint_column>& columns);
+
+   /** Assign the columns in which page aligned payload offsets that overlap
+    * neither the payloads in live nor those of the other columns
+    */
+   void relocate(std::vector<checkpoint_column>& columns, const std::vector<size_t>& which,
+      const std::vector<checkpoint_column>& live);
+
+   /** Truncate the file behind the last payload of columns
+    */
+   void trim(const std::vector<checkpoint_column>& columns);
+
+   void write(const void* data, size_t bytes, uint64_t offset);
+   void read(void* data, size_t bytes, uint64_t offset);
+
+   /** Flush the file to disk
+    */
+   void sync();
+
+   /** Atomically replace the file at path with this file
+    */
+   void replace(const std::string& path);
+
+   const std::string& path() const noexcept { return _path; }
+
+private:
+   std::string _path;
+   int _fd = -1;
+};
+
+} // namespace detail
+} // namespace xlib
+
+#include "detail/soa_checkpoint.hpp"
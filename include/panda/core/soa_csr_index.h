@@ -0,0 +1,155 @@
+#pragma once
+
+#include <xlib/core/execution.h>
+#include <xlib/core/static_soa.h>
+
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+namespace xlib
+{
+
+/** Compressed sparse row index of the elements of a static_soa by the
+ * integral key stored in column I, e.g. the parcels in every cell
+ *
+ * Every key owns a range of slots in one array with some slack behind its
+ * elements, so the lookup of a key is O(1) and returns a contiguous range.
+ * Keys must lie in [0, num_keys()).
+ *
+ * The index attaches itself to the container as an observer: resizes add or
+ * remove the affected elements incrementally, reorders, sorts and erases
+ * rebuild it with a parallel counting sort. Writes to the key column are
+ * picked up by update(). Moving an element removes it from its old range and
+ * appends it to the slack of the new one, a full range moves to the end of
+ * the array with twice the capacity, so an update costs O(1) amortized
+ * whatever the distance between the keys. The index is rebuilt once the
+ * abandoned ranges take up too much of the array.
+ * Resizes read the keys of the added elements, so the key column must have a
+ * valid default and can not be resized with xlib::uninitialized.
+ * @tparam Soa static_soa type
+ * @tparam I index of the key column
+ */
+template < class Soa, size_t I >
+class soa_csr_index: public Soa::observer
+{
+public:
+   using key_type = typename Soa::template element_type<I>;
+   static_assert(std::is_integral<key_type>::value && !std::is_same<key_type,bool>::value,
+      "soa_csr_index requires an integral key column");
+
+   /** Indices of the elements with one key
+    */
+   class range
+   {
+   public:
+      range(const size_t* begin, const size_t* end) noexcept: _begin(begin), _end(end) {}
+
+      const size_t* begin() const noexcept { return _begin; }
+      const size_t* end() const noexcept { return _end; }
+      size_t size() const noexcept { return static_cast<size_t>(_end - _begin); }
+      bool empty() const noexcept { return _begin == _end; }
+      size_t operator[](size_t j) const noexcept { return _begin[j]; }
+
+   private:
+      const size_t* _begin;
+      const size_t* _end;
+   };
+
+   /** Index the elements of soa and keep the index up to date with its
+    * resizes and reorders
+    * @param soa container, the index detaches itself when either is destroyed
+    * @param num_keys number of keys
+    * @param policy policy of the rebuilds
+    */
+   soa_csr_index(Soa& soa, size_t num_keys, const execution::parallel_policy& policy = execution::par);
+   soa_csr_index(const soa_csr_index&) = delete;
+   soa_csr_index& operator=(const soa_csr_index&) = delete;
+   ~soa_csr_index() override;
+
+   /** Elements with key k, in no particular order
+    */
+   range operator[](size_t k) const noexcept;
+
+   /** Number of elements with key k
+    */
+   size_t count(size_t k) const noexcept { return _ranges[k].count; }
+
+   size_t num_keys() const noexcept { return _num_keys; }
+
+   /** Number of indexed elements
+    */
+   size_t size() const noexcept { return _keys.size(); }
+
+   /** Container the index is attached to, nullptr once it was destroyed
+    */
+   Soa* soa() const noexcept { return _soa; }
+
+   /** Pick up writes to the key column by comparing every key to the key it
+    * was indexed with
+    * @return number of elements whose key changed
+    */
+   size_t update();
+
+   /** Pick up writes to the key column of the given elements only
+    * @param changed indices of the elements whose key may have changed
+    * @return number of elements whose key changed
+    */
+   size_t update(const std::vector<size_t>& changed);
+
+   /** Index every element from scratch with a counting sort
+    */
+   void rebuild();
+
+   /** Change the number of keys and rebuild the index
+    */
+   void set_num_keys(size_t num_keys);
+
+   void resized(Soa& soa, size_t old_size) override;
+   void reordered(Soa& soa, size_t old_size) override;
+   void relocated(Soa* soa) override;
+
+private:
+   /** Slots of one key in _indices
+    */
+   struct slot_range
+   {
+      size_t begin;
+      size_t count;
+      size_t capacity;
+   };
+
+   size_t key(size_t i) const noexcept;
+
+   /** Append element i to the range of key k, moving the range to the end of
+    * _indices when it is full
+    * @return false if the range could not grow without rebuilding
+    */
+   bool insert(size_t i, size_t k);
+
+   /** Remove element i from the range of its key by swapping it with the
+    * last element of the range
+    */
+   void remove(size_t i) noexcept;
+
+   void swap_slots(size_t p, size_t q) noexcept;
+
+   /** Move the elements whose key changed, or rebuild if that is cheaper
+    */
+   void apply_changes(const std::vector<size_t>& changed);
+
+   Soa* _soa;
+   execution::parallel_policy _policy;
+   size_t _num_keys;
+   std::vector<slot_range> _ranges;
+   /** Element indices grouped by key, including the slack of every range */
+   std::vector<size_t> _indices;
+   /** Slot of every element in _indices */
+   std::vector<size_t> _positions;
+   /** Key every element is indexed with */
+   std::vector<size_t> _keys;
+};
+
+} // namespace xlib
+
+#include "detail/soa_csr_index.hpp"
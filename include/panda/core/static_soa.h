@@ -1,16 +1,340 @@
+#pragma once
+
+#include <xlib/core/execution.h>
+#include <xlib/core/fp_promotion.h>
+#include <xlib/core/profiler.h>
+#include <xlib/core/detail/soa_reduce.hpp>
+
+#include <atomic>
+#include <memory>
+#include <optional>
 #include <tuple>
 #include <utility>
-#include <functional>
 #include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <cassert>
+#include <type_traits>
+
+/** Qualify a pointer as not aliasing any other pointer in scope
+ */
+#if defined(__GNUC__) || defined(__clang__)
+#define XLIB_RESTRICT __restrict__
+#else
+#define XLIB_RESTRICT
+#endif
+
+/** Default byte alignment of the data in raw pointer (T*) columns
+ */
+#ifndef XLIB_SOA_ALIGNMENT
+#define XLIB_SOA_ALIGNMENT 64
+#endif
+
+/** Resizes of raw pointer (T*) columns that move or construct at least this
+ * many bytes first touch the memory in parallel with soa_first_touch_policy
+ */
+#ifndef XLIB_SOA_FIRST_TOUCH_BYTES
+#define XLIB_SOA_FIRST_TOUCH_BYTES (size_t(1) << 22)
+#endif
+
+/** Raw pointer (T*) columns of trivially copyable T with storage of at least
+ * this many bytes are mapped, and grow and shrink by remapping their pages
+ */
+#ifndef XLIB_SOA_REMAP_BYTES
+#define XLIB_SOA_REMAP_BYTES (size_t(1) << 21)
+#endif
+
+/** Number of elements per block that static_soa dirty tracking records
+ * writes in, dirty ranges are rounded out to whole blocks
+ */
+#ifndef XLIB_SOA_DIRTY_BLOCK
+#define XLIB_SOA_DIRTY_BLOCK 64
+#endif
 
 namespace xlib
 {
 namespace detail
 {
+template < class T >
+struct type_tag
+{
+   static constexpr char id = 0;
+};
+
+/** Unique identifier of a type, usable for runtime type checks without RTTI
+ */
+template < class T >
+constexpr const void* type_id() noexcept
+{
+   return &type_tag<T>::id;
+}
+
+template < class A, class B >
+struct soa_concat_indices;
+
+template < size_t... A, size_t... B >
+struct soa_concat_indices<std::index_sequence<A...>, std::index_sequence<B...>>
+{
+   using type = std::index_sequence<A..., B...>;
+};
+
+/** Indices of the raw pointer columns (Pointers) or of the other columns of a tuple
+ */
+template < bool Pointers, class Tuple, size_t I = 0, size_t N = std::tuple_size<Tuple>::value >
+struct soa_filter_indices
+{
+   using rest = typename soa_filter_indices<Pointers, Tuple, I + 1, N>::type;
+   using type = std::conditional_t<std::is_pointer<std::tuple_element_t<I,Tuple>>::value == Pointers,
+      typename soa_concat_indices<std::index_sequence<I>, rest>::type, rest>;
+};
+
+template < bool Pointers, class Tuple, size_t N >
+struct soa_filter_indices<Pointers, Tuple, N, N>
+{
+   using type = std::index_sequence<>;
+};
+
+template < class Tuple >
+using soa_pointer_indices_t = typename soa_filter_indices<true, Tuple>::type;
+
+template < class Tuple >
+using soa_container_indices_t = typename soa_filter_indices<false, Tuple>::type;
+
+template < size_t I, size_t... Rest >
+constexpr size_t soa_first_index(std::index_sequence<I, Rest...>) noexcept
+{
+   return I;
+}
+
+/** Bytes one element takes over the raw pointer columns at indices I
+ */
+template < class Tuple, size_t... I >
+constexpr size_t soa_element_bytes(std::index_sequence<I...>) noexcept
+{
+   return (size_t(0) + ... + sizeof(std::remove_pointer_t<std::tuple_element_t<I,Tuple>>));
+}
 } // namespace detail
 
-template < class... Types >
-class static_soa
+/** Alignment of the data in a raw pointer column holding elements of type T.
+ * Specialize to change the alignment for a specific element type.
+ */
+template < class T >
+struct soa_alignment:
+   std::integral_constant<size_t, (XLIB_SOA_ALIGNMENT > alignof(T) ? XLIB_SOA_ALIGNMENT : alignof(T))>
+{};
+
+template < class T >
+inline constexpr size_t soa_alignment_v = soa_alignment<T>::value;
+
+/** Tag of static_soa::resize that leaves new elements of trivial types uninitialized
+ */
+struct uninitialized_t
+{
+   explicit uninitialized_t() = default;
+};
+
+inline constexpr uninitialized_t uninitialized{};
+
+/** Compile time value that resize initializes new elements of type T with.
+ * Specialize with a static constexpr member named value to change the
+ * default of every column holding T. Without one new elements are value
+ * initialized, static_soa::set_default overrides it per column at run time.
+ */
+template < class T >
+struct soa_default_value
+{};
+
+/** Policy that large resizes of raw pointer columns move and construct
+ * elements with. Its static partition matches kernels run with
+ * execution::par.deterministic(), so every page is first touched, and placed
+ * on the NUMA node of, the thread that later works on it.
+ */
+inline constexpr execution::parallel_policy soa_first_touch_policy = execution::par.deterministic();
+
+/** Half open range of element indices [begin, end)
+ */
+struct soa_interval
+{
+   size_t begin;
+   size_t end;
+};
+
+/** Default number of elements per block passed to static_soa::apply_blocked
+ */
+inline constexpr size_t soa_default_block_size = 1024;
+
+/** Allocator policy of basic_static_soa that allocates the storage of every
+ * raw pointer (T*) column on its own
+ */
+struct soa_column_allocator
+{
+   static constexpr bool shared_storage = false;
+};
+
+/** Allocator policy of basic_static_soa that places all of the raw pointer
+ * (T*) columns in one page aligned slab
+ *
+ * Every column keeps its size and capacity header in front of its data, and
+ * each column starts at a different cache line offset inside of a page so
+ * that walking several columns at once does not alias in the cache. Growing
+ * past the capacity allocates a new slab and moves every column into it, so
+ * a container of K raw pointer columns does one allocation instead of K.
+ * Large slabs are aligned to and advised for transparent huge pages.
+ *
+ * Container columns (std::vector, vec_column, mapped_column, ...) keep
+ * managing their own storage.
+ */
+class soa_arena_allocator
+{
+public:
+   static constexpr bool shared_storage = true;
+
+   /** Page size that slabs are allocated in */
+   static constexpr size_t page_size = 4096;
+
+   soa_arena_allocator() = default;
+   soa_arena_allocator(const soa_arena_allocator&) = delete;
+   soa_arena_allocator& operator=(const soa_arena_allocator&) = delete;
+   soa_arena_allocator(soa_arena_allocator&& other) noexcept;
+   soa_arena_allocator& operator=(soa_arena_allocator&& other) noexcept;
+   ~soa_arena_allocator();
+
+   /** Number of elements every column in the slab can hold
+    */
+   size_t capacity() const noexcept { return _capacity; }
+
+   /** Size of the slab in bytes
+    */
+   size_t bytes() const noexcept { return _bytes; }
+
+   /** Start of the slab, nullptr if nothing is allocated
+    */
+   const void* data() const noexcept { return _slab; }
+
+   /** Move the raw pointer columns at Indices into a new slab
+    * @param columns tuple holding the columns
+    * @param capacity capacity of the new slab, 0 releases the slab
+    * @param n number of elements each column holds after the move
+    * @param move callable as move(T* src, T* dst) for each column, constructs
+    *        elements [0, n) of the uninitialized storage dst from src
+    */
+   template < class Tuple, size_t... Indices, class Move >
+   void reallocate(Tuple& columns, std::index_sequence<Indices...>, size_t capacity, size_t n, Move&& move);
+
+   /** Destroy the elements of the columns at Indices and release the slab
+    */
+   template < class Tuple, size_t... Indices >
+   void release(Tuple& columns, std::index_sequence<Indices...>) noexcept;
+
+private:
+   char* _slab = nullptr;
+   size_t _bytes = 0;
+   size_t _capacity = 0;
+};
+
+namespace detail
+{
+/** Allocate page aligned memory for an arena slab
+ * @throw std::bad_alloc if the memory can not be allocated
+ */
+void* soa_arena_allocate(size_t bytes);
+
+/** Release memory returned by soa_arena_allocate
+ */
+void soa_arena_deallocate(void* slab, size_t bytes) noexcept;
+
+/** Alignment of memory returned by soa_map_allocate
+ */
+constexpr size_t soa_map_alignment = 4096;
+
+/** Map zeroed memory for a large raw pointer column
+ * @throw std::bad_alloc if the memory can not be mapped
+ */
+void* soa_map_allocate(size_t bytes);
+
+/** Grow or shrink memory returned by soa_map_allocate, keeping its contents
+ * up to the smaller of the sizes. Pages are remapped rather than copied.
+ * @throw std::bad_alloc if the memory can not be mapped, p stays valid
+ * @return new address of the memory
+ */
+void* soa_map_reallocate(void* p, size_t old_bytes, size_t new_bytes);
+
+/** Release memory returned by soa_map_allocate or soa_map_reallocate
+ */
+void soa_map_deallocate(void* p, size_t bytes) noexcept;
+
+/** Blocks of XLIB_SOA_DIRTY_BLOCK elements of every column written since
+ * the last clear, one bit per block. Marking is thread safe, everything
+ * else must not run concurrently with other calls.
+ */
+class soa_dirty_tracker
+{
+public:
+   explicit soa_dirty_tracker(size_t columns, size_t block = XLIB_SOA_DIRTY_BLOCK) noexcept: _columns(columns), _block(block) {}
+   soa_dirty_tracker(const soa_dirty_tracker&) = delete;
+   soa_dirty_tracker& operator=(const soa_dirty_tracker&) = delete;
+
+   bool enabled() const noexcept { return _enabled; }
+
+   /** Start tracking n clean elements, or stop tracking
+    */
+   void enable(bool enable, size_t n);
+
+   /** Track n elements, added blocks are clean
+    */
+   void resize(size_t n);
+
+   /** Mark every block as clean
+    */
+   void clear() noexcept;
+
+   /** Mark the blocks holding [begin, end) of a column as written
+    */
+   void mark(size_t column, size_t begin, size_t end) noexcept;
+
+   /** Mark the blocks holding [begin, end) of every column as written
+    */
+   void mark_all(size_t begin, size_t end) noexcept;
+
+   /** Merged written ranges of a column, clipped to n elements
+    */
+   std::vector<soa_interval> ranges(size_t column, size_t n) const;
+
+   void swap(soa_dirty_tracker& other) noexcept;
+
+private:
+   size_t _columns;
+   /** Elements per bit */
+   size_t _block;
+   bool _enabled = false;
+   /** Words of bits per column */
+   size_t _words = 0;
+   std::unique_ptr<std::atomic<uint64_t>[]> _bits;
+};
+
+template < class T, class = std::void_t<> >
+struct soa_element_value_type;
+
+template < class V >
+struct soa_initializer;
+
+template < class T, class = void >
+struct soa_has_default_value: std::false_type {};
+
+template < class T >
+struct soa_has_default_value<T, std::void_t<decltype(soa_default_value<T>::value)>>: std::true_type {};
+} // namespace detail
+
+template < class Soa >
+class soa_append_buffer;
+
+/** Structure of arrays holding one array (column) per type in Types
+ * @tparam Allocator allocator policy of the raw pointer columns,
+ *         soa_column_allocator or soa_arena_allocator
+ * @tparam Types column types, raw pointers (T*) or containers such as std::vector
+ */
+template < class Allocator, class... Types >
+class basic_static_soa
 {
    using Tuple = std::tuple<std::remove_cv_t<std::remove_reference_t<Types>>...>;
 public:
@@ -26,41 +350,84 @@ public:
       using const_reference = const T&;
 
       meta_handle() = default;
-      meta_handle(static_soa<Types...>* parent): _parent(parent) {}
+      meta_handle(basic_static_soa* parent): _parent(parent) {}
 
-      reference data() const noexcept { return _parent->get_data<I>(); }
+      reference data() const noexcept { return _parent->template get_data<I>(); }
 
-      static_soa<Types...>* parent() noexcept { return _parent; }
+      basic_static_soa* parent() const noexcept { return _parent; }
    private:
-      static_soa<Types...>* _parent;
+      basic_static_soa* _parent = nullptr;
    };
 
+   /** Type erased handle to one of the arrays of a static_soa container
+    *
+    * The handle is trivially copyable and only stores the parent, the byte
+    * offset of the array inside of the parent and the array index, so
+    * data<T>() is a single pointer add. In debug builds data<T>() checks T
+    * against the per-instantiation table of array types.
+    */
    struct handle
    {
+      handle() = default;
+
       template < class T, size_t I >
-      handle(const meta_handle<T,I>& mh)
-      {
-         this->_get_data_f = [mh](void) -> void*
-         {
-            return &mh.data();
-         };
-      }
+      handle(const meta_handle<T,I>& mh) noexcept:
+         _parent(mh.parent()),
+         _offset(static_cast<uint32_t>(reinterpret_cast<const char*>(&std::get<I>(mh.parent()->_data)) - reinterpret_cast<const char*>(mh.parent()))),
+         _index(static_cast<uint32_t>(I))
+      {}
 
       template < class T >
-      T& data()
+      T& data() const noexcept
       {
-         return *reinterpret_cast<T*>(_get_data_f());
+         assert(this->is<T>() && "handle does not refer to an array of type T");
+         return *reinterpret_cast<T*>(reinterpret_cast<char*>(_parent) + _offset);
       }
+
+      /** Check the type of the array the handle refers to
+       * @return true if the array has type T
+       */
       template < class T >
-      T& data() const
+      bool is() const noexcept
       {
-         return *reinterpret_cast<T*>(_get_data_f());
+         return _parent && _type_ids[_index] == detail::type_id<T>();
       }
 
+      basic_static_soa* parent() const noexcept { return _parent; }
+
+      size_t index() const noexcept { return _index; }
+
    private:
-      std::function<void*(void)> _get_data_f;
+      basic_static_soa* _parent = nullptr;
+      uint32_t _offset = 0;
+      uint32_t _index = 0;
    };
 
+   /** Receives the changes of a static_soa that give elements new indices,
+    * so that structures indexing the elements (e.g. soa_csr_index) can stay
+    * valid. Callbacks run on the thread that changed the container, after
+    * the change.
+    */
+   class observer
+   {
+   public:
+      virtual ~observer() = default;
+
+      /** Elements [old_size, soa.size()) were added or [soa.size(), old_size)
+       * were removed, every other element kept its index
+       */
+      virtual void resized(basic_static_soa& soa, size_t old_size) = 0;
+
+      /** Elements were moved to new indices and possibly removed, e.g. by
+       * reorder, sort_by or erase_if
+       */
+      virtual void reordered(basic_static_soa& soa, size_t old_size) = 0;
+
+      /** The container and its observers were moved to soa, or destroyed if
+       * soa is nullptr
+       */
+      virtual void relocated(basic_static_soa* soa) = 0;
+   };
 
    template < size_t I >
    using value_type = std::tuple_element_t<I,Tuple>;
@@ -70,6 +437,16 @@ public:
    using const_reference = const std::tuple_element_t<I,Tuple>&;
    template < size_t I >
    using meta_handle_t = meta_handle<value_type<I>, I>;
+   /** Type of the elements of the array at index I */
+   template < size_t I >
+   using element_type = typename detail::soa_element_value_type<value_type<I>>::value_type;
+
+   basic_static_soa() = default;
+   basic_static_soa(const basic_static_soa&) = delete;
+   basic_static_soa& operator=(const basic_static_soa&) = delete;
+   basic_static_soa(basic_static_soa&& other) noexcept;
+   basic_static_soa& operator=(basic_static_soa&& other) noexcept;
+   ~basic_static_soa();
 
    /** Get a handle to data stored at index I in the static_soa container
     * @return handle to data stored at index I in the static_soa container
@@ -139,6 +516,121 @@ public:
    template < class CallBack, class... Args >
    void apply_per_element(CallBack&& f, Args&&... args);
 
+   /** Apply a function that takes the Types::reference..., Args... as inputs
+    * to every element, splitting the index range across threads
+    * @tparam ExecutionPolicy one of the xlib::execution policies
+    * @tparam CallBack Type of the callback function
+    * @tparam Args List of extra argument types
+    * @param policy execution policy, e.g. xlib::execution::par.deterministic()
+    * @param f Callback function, called concurrently for different elements
+    * @param args list of extra arguments to pass to f
+    */
+   template < class ExecutionPolicy, class CallBack, class... Args,
+      class = std::enable_if_t<execution::is_execution_policy_v<ExecutionPolicy>> >
+   void apply_per_element(ExecutionPolicy&& policy, CallBack&& f, Args&&... args);
+
+   /** Apply a function to contiguous blocks of all of the arrays
+    * The callback is invoked as f(begin, n, Types::pointer..., args...) for
+    * each block [begin, begin + n), where each pointer points to element begin
+    * of its array, so a kernel can run a plain loop over [0, n).
+    * @tparam BlockSize maximum number of elements per block
+    * @tparam CallBack Type of the callback function
+    * @tparam Args List of extra argument types
+    * @param f Callback function
+    * @param args list of extra arguments to pass to f
+    */
+   template < size_t BlockSize = soa_default_block_size, class CallBack, class... Args >
+   void apply_blocked(CallBack&& f, Args&&... args);
+
+   /** Apply a function to contiguous blocks of all of the arrays, splitting
+    * the blocks across threads. Chunks handed to a thread are rounded up to a
+    * multiple of BlockSize.
+    * @tparam BlockSize maximum number of elements per block
+    * @tparam ExecutionPolicy one of the xlib::execution policies
+    * @tparam CallBack Type of the callback function
+    * @tparam Args List of extra argument types
+    * @param policy execution policy
+    * @param f Callback function, called concurrently for different blocks
+    * @param args list of extra arguments to pass to f
+    */
+   template < size_t BlockSize = soa_default_block_size, class ExecutionPolicy, class CallBack, class... Args,
+      class = std::enable_if_t<execution::is_execution_policy_v<ExecutionPolicy>> >
+   void apply_blocked(ExecutionPolicy&& policy, CallBack&& f, Args&&... args);
+
+   /** Reduce array I with an operation, starting from init
+    *
+    * Elements are converted to T and combined in interleaved lanes and fixed
+    * size chunks, see detail::soa_reduce. The sequenced version gives the
+    * same result bitwise as parallel policies with a deterministic schedule,
+    * for any number of threads.
+    * @tparam I index of the array
+    * @param op associative and commutative operation, as for std::reduce
+    * @param init initial value, its type is the accumulator type
+    * @return reduction of init and every element
+    */
+   template < size_t I, class BinaryOp, class T,
+      class = std::enable_if_t<!execution::is_execution_policy_v<BinaryOp>> >
+   T reduce(BinaryOp op, T init) const;
+
+   /** Reduce array I with an operation across threads
+    * @param policy execution policy, xlib::execution::par.deterministic() for
+    *        results that do not depend on the number of threads
+    * @param op associative and commutative operation, called concurrently
+    * @param init initial value, its type is the accumulator type
+    */
+   template < size_t I, class ExecutionPolicy, class BinaryOp, class T,
+      class = std::enable_if_t<execution::is_execution_policy_v<ExecutionPolicy>> >
+   T reduce(ExecutionPolicy&& policy, BinaryOp op, T init) const;
+
+   /** Sum of array I, accumulated in promote_fp_t of its element type for
+    * arithmetic elements (e.g. int32_t elements sum into float)
+    */
+   template < size_t I >
+   detail::soa_accumulator_t<element_type<I>> sum() const;
+
+   /** Sum of array I across threads
+    */
+   template < size_t I, class ExecutionPolicy,
+      class = std::enable_if_t<execution::is_execution_policy_v<ExecutionPolicy>> >
+   detail::soa_accumulator_t<element_type<I>> sum(ExecutionPolicy&& policy) const;
+
+   /** Reduce a value computed from every element with an operation
+    *
+    * Values are accumulated in promote_fp_t of the result of f for
+    * arithmetic results, starting from a value initialized accumulator.
+    * Nothing is marked dirty.
+    * @param f callable as f(Types::reference..., size_t index)
+    * @param op associative and commutative operation, as for std::reduce
+    * @return reduction of the values of every element
+    */
+   template < class Transform, class BinaryOp,
+      class = std::enable_if_t<!execution::is_execution_policy_v<Transform>> >
+   auto transform_reduce(Transform f, BinaryOp op);
+
+   /** Reduce a value computed from every element with an operation, starting
+    * from init
+    * @param init initial value, its type is the accumulator type
+    */
+   template < class Transform, class BinaryOp, class T,
+      class = std::enable_if_t<!execution::is_execution_policy_v<Transform>> >
+   T transform_reduce(Transform f, BinaryOp op, T init);
+
+   /** Reduce a value computed from every element with an operation across threads
+    * @param policy execution policy
+    * @param f transform, called concurrently for different elements
+    * @param op associative and commutative operation, called concurrently
+    */
+   template < class ExecutionPolicy, class Transform, class BinaryOp,
+      class = std::enable_if_t<execution::is_execution_policy_v<ExecutionPolicy>> >
+   auto transform_reduce(ExecutionPolicy&& policy, Transform f, BinaryOp op);
+
+   /** Reduce a value computed from every element with an operation across
+    * threads, starting from init
+    */
+   template < class ExecutionPolicy, class Transform, class BinaryOp, class T,
+      class = std::enable_if_t<execution::is_execution_policy_v<ExecutionPolicy>> >
+   T transform_reduce(ExecutionPolicy&& policy, Transform f, BinaryOp op, T init);
+
    /** Get the element i from all of the arrays in the static soa container
     * @param i index in the arrays to get elements from
     * @return std::tuple with the reference values of all of the array elements
@@ -146,85 +638,317 @@ public:
    decltype(auto) get_element(size_t i);
 
    /** Resize all of the data in the static_soa container
+    * Raw pointer columns that grow by more than XLIB_SOA_FIRST_TOUCH_BYTES
+    * are moved and constructed with soa_first_touch_policy.
     * @param n new size
     */
    void resize(size_t n);
 
+   /** Resize all of the data in the static_soa container, moving and
+    * constructing the elements of raw pointer columns across threads
+    * Elements are touched in chunks over [0, n) on the threads that run the
+    * same chunks of later kernels with the same policy. Container columns
+    * are resized serially.
+    * @param policy execution policy, e.g. soa_first_touch_policy
+    * @param n new size
+    */
+   template < class ExecutionPolicy,
+      class = std::enable_if_t<execution::is_execution_policy_v<ExecutionPolicy>> >
+   void resize(ExecutionPolicy&& policy, size_t n);
+
+   /** Resize all of the data in the static_soa container without
+    * initializing new elements of raw pointer columns of trivial types, for
+    * elements that are written before they are read. Elements of other raw
+    * pointer columns are default constructed, container columns resize as
+    * usual.
+    * @param n new size
+    */
+   void resize(size_t n, uninitialized_t);
+
+   /** Resize without initializing new elements of trivial types, see
+    * resize(size_t, uninitialized_t), constructing across threads
+    * @param policy execution policy
+    * @param n new size
+    */
+   template < class ExecutionPolicy,
+      class = std::enable_if_t<execution::is_execution_policy_v<ExecutionPolicy>> >
+   void resize(ExecutionPolicy&& policy, size_t n, uninitialized_t);
+
+   /** Set the value that resize initializes new elements of array I with
+    * @param value default element
+    */
+   template < size_t I >
+   void set_default(const element_type<I>& value);
+
+   /** Initialize new elements of array I with the soa_default_value of the
+    * element type again, or value initialize them if it has none
+    */
+   template < size_t I >
+   void reset_default() noexcept;
+
+   /** Value that resize initializes new elements of array I with
+    * @return default element
+    */
+   template < size_t I >
+   element_type<I> get_default() const;
+
    /** Resize all of the data in the static_soa container
     * @return size of data structures in static_soa container
     */
    size_t size() const noexcept;
 
-   /** Reorder the elements of all of the arrays
-    * @param new_index_map new indices of each element
+   /** Reserve storage in all of the arrays for at least n elements
+    * @param n minimum capacity
+    */
+   void reserve(size_t n);
+
+   /** Reserve storage in all of the arrays for at least n elements, moving
+    * the elements of raw pointer columns across threads
+    * @param policy execution policy
+    * @param n minimum capacity
+    */
+   template < class ExecutionPolicy,
+      class = std::enable_if_t<execution::is_execution_policy_v<ExecutionPolicy>> >
+   void reserve(ExecutionPolicy&& policy, size_t n);
+
+   /** Number of elements the arrays can hold without reallocating
+    * @return capacity of the first array in the static_soa container
+    */
+   size_t capacity() const noexcept;
+
+   /** Release any storage beyond size() held by the arrays
+    */
+   void shrink_to_fit();
+
+   /** Reorder the elements of all of the arrays in place by following the
+    * cycles of the permutation, no per array scratch storage is needed
+    * @param new_index_map new indices of each element, element i moves to
+    *        new_index_map[i], must be a permutation of [0, size())
     */
    template < class T, class = std::enable_if_t<std::is_integral<T>::value> >
    void reorder(const std::vector<T>& new_index_map);
 
+   /** Reorder the elements of all of the arrays
+    * Parallel policies scatter each array into new storage across threads,
+    * which needs one array worth of scratch storage at a time.
+    * @param policy execution policy, execution::seq reorders in place
+    * @param new_index_map new indices of each element, element i moves to
+    *        new_index_map[i], must be a permutation of [0, size())
+    */
+   template < class ExecutionPolicy, class T,
+      class = std::enable_if_t<execution::is_execution_policy_v<ExecutionPolicy>>,
+      class = std::enable_if_t<std::is_integral<T>::value> >
+   void reorder(ExecutionPolicy&& policy, const std::vector<T>& new_index_map);
+
+   /** Sort the elements of all of the arrays by the values of array I
+    * Integral keys use an LSD radix sort, which is stable, other keys are
+    * compared with operator<. The resulting permutation is applied to every
+    * array with reorder().
+    * @tparam I index of the key array
+    */
+   template < size_t I >
+   void sort_by();
+
+   /** Sort the elements of all of the arrays by the values of array I
+    * @tparam I index of the key array
+    * @param policy execution policy used by the radix sort and the reorder
+    */
+   template < size_t I, class ExecutionPolicy,
+      class = std::enable_if_t<execution::is_execution_policy_v<ExecutionPolicy>> >
+   void sort_by(ExecutionPolicy&& policy);
+
+   /** Sort the elements of all of the arrays by the values of array I,
+    * keeping the relative order of elements with equal keys
+    * @tparam I index of the key array
+    */
+   template < size_t I >
+   void stable_sort_by();
+
+   /** Sort the elements of all of the arrays by the values of array I,
+    * keeping the relative order of elements with equal keys
+    * @tparam I index of the key array
+    * @param policy execution policy used by the radix sort and the reorder
+    */
+   template < size_t I, class ExecutionPolicy,
+      class = std::enable_if_t<execution::is_execution_policy_v<ExecutionPolicy>> >
+   void stable_sort_by(ExecutionPolicy&& policy);
+
+   /** Remove every element for which a predicate is true from all of the
+    * arrays, keeping the order of the remaining elements
+    * @tparam Predicate callable as pred(Types::reference..., size_t index)
+    * @param pred predicate selecting the elements to remove
+    * @return number of removed elements
+    */
+   template < class Predicate >
+   size_t erase_if(Predicate&& pred);
+
+   /** Remove every element for which a predicate is true from all of the
+    * arrays, keeping the order of the remaining elements
+    * Parallel policies evaluate the predicate across threads, find the new
+    * index of every remaining element with a prefix sum and move the
+    * remaining elements into new arrays across threads.
+    * @tparam Predicate callable as pred(Types::reference..., size_t index)
+    * @param policy execution policy
+    * @param pred predicate selecting the elements to remove, called
+    *        concurrently for different elements by parallel policies
+    * @return number of removed elements
+    */
+   template < class ExecutionPolicy, class Predicate,
+      class = std::enable_if_t<execution::is_execution_policy_v<ExecutionPolicy>> >
+   size_t erase_if(ExecutionPolicy&& policy, Predicate&& pred);
+
+   /** Remove every element for which a predicate is true from all of the
+    * arrays, filling each hole with the last remaining element. Only the
+    * holes in front of the new size are touched, but the order of the
+    * remaining elements is not kept.
+    * @tparam Predicate callable as pred(Types::reference..., size_t index)
+    * @param pred predicate selecting the elements to remove
+    * @return number of removed elements
+    */
+   template < class Predicate >
+   size_t erase_if_unordered(Predicate&& pred);
+
+   /** Start or stop recording which ranges of every column are written
+    *
+    * While tracking, apply_to_element, get_element, apply_per_element and
+    * apply_blocked mark the elements they visit in every column, resizes
+    * mark the added elements and reorders and erases mark everything. Writes
+    * through get_data<I>() have to be marked with mark_dirty<I>.
+    * @param enable true to start tracking with every element clean
+    */
+   void track_dirty(bool enable = true);
+
+   /** Whether written ranges are being recorded
+    */
+   bool tracks_dirty() const noexcept { return _dirty.enabled(); }
+
+   /** Record writes to elements [begin, end) of array I, safe to call
+    * concurrently
+    */
+   template < size_t I >
+   void mark_dirty(size_t begin, size_t end) noexcept;
+
+   /** Record writes to elements [begin, end) of every array, safe to call
+    * concurrently
+    */
+   void mark_dirty(size_t begin, size_t end) noexcept;
+
+   /** Ranges of array I written since the current epoch started
+    *
+    * Ranges are sorted, disjoint, rounded out to XLIB_SOA_DIRTY_BLOCK
+    * elements and clipped to size(). Without tracking every element is
+    * reported as written.
+    * @return merged written ranges
+    */
+   template < size_t I >
+   std::vector<soa_interval> dirty_ranges() const;
+
+   /** Number of times clear_dirty was called
+    */
+   size_t dirty_epoch() const noexcept { return _dirty_epoch; }
+
+   /** Mark every element of every array as clean and start a new epoch
+    * @return the new epoch
+    */
+   size_t clear_dirty() noexcept;
+
+   /** Allocator policy instance holding the raw pointer column storage
+    */
+   const Allocator& get_allocator() const noexcept { return _allocator; }
+
+   /** Notify an observer of the changes to the container until it is
+    * detached, observers move along with the container
+    * @param o observer, must outlive the attachment
+    */
+   void attach(observer* o);
+
+   /** Stop notifying an observer
+    * @param o attached observer
+    */
+   void detach(observer* o) noexcept;
+
 private:
-   Tuple _data;
-};
-} // namespace xlib
+   /** Fills the appended elements before it notifies the observers */
+   template < class Soa >
+   friend class soa_append_buffer;
 
-#include "detail/static_soa.hpp"
+   static constexpr const void* _type_ids[] = {detail::type_id<std::remove_cv_t<std::remove_reference_t<Types>>>()...};
 
-/*
-struct ParcelDataStorage
-{
-   xlib::static_soa<std::vector<xlib::vec<double,3>>>
-};
+   template < size_t I, class ExecutionPolicy >
+   void sort_by_impl(ExecutionPolicy&& policy, bool stable);
+
+   /** Columns whose storage is managed by a shared storage allocator */
+   using pointer_indices = detail::soa_pointer_indices_t<Tuple>;
+   /** Columns that manage their own storage */
+   using container_indices = detail::soa_container_indices_t<Tuple>;
 
-#define CREATE_PARCEL_STORAGE(TYPE, PDATA, MDATA)\
-struct TYPE##Parcel\
-{\
-   using type = std::tuble<UNROLL_TYPES(__VA_ARGS__)>\
-   enum TYPE##Ids\
-   {\
-      cell_index_id,
-      position_id,
-      velocity_id,
-      UNROLL_NAMES_ENUM(__VA_ARGS__),\
-      NUM_##TYPE##_VARS\
-   };\
-   std::vector<int64_t>& cell_index() { return _data->get_data<cell_index_id>(); }
-   std::vector<int64_t>& cell_index() { return _data->get_data<position_id>(); }
-   std::vector<int64_t>& cell_index() { return _data->get_data<velocity_id>(); }
-   UNROLL_NAME_GETTERS(__VA_ARGS__)\
-private:\
-   xlib::static_soa<
-      std::vector<int64_t>,
-      std::vector<xlib::vec<double,3>
-      std::vector<xlib::vec<double,3>
-      UNROLL_TYPES(__VA_ARGS__)>* _data;\
+   /** Resize every array, with the given policy or the default policy of each array
+    */
+   template < class... ExecutionPolicy >
+   void resize_impl(size_t n, bool uninitialized, ExecutionPolicy&&... policy);
+
+   /** Resize the arrays at the given indices with Resize, soa_resize or soa_resize_in_place
+    */
+   template < template<class> class Resize, size_t... I, class... ExecutionPolicy >
+   void resize_columns(std::index_sequence<I...>, size_t n, bool uninitialized, ExecutionPolicy&&... policy);
+
+   /** How resize constructs the new elements of array I
+    */
+   template < size_t I >
+   detail::soa_initializer<element_type<I>> initializer(bool uninitialized) const noexcept;
+
+   /** Resize the raw pointer columns of a shared storage allocator
+    */
+   template < class ExecutionPolicy >
+   void resize_shared(ExecutionPolicy&& policy, size_t n, bool uninitialized);
+
+   /** Size of the raw pointer columns of a shared storage allocator
+    */
+   size_t shared_size() const noexcept;
+
+   /** Move the raw pointer columns of a shared storage allocator into new
+    * storage of the given capacity, keeping their elements
+    */
+   template < class ExecutionPolicy >
+   void reallocate_shared(ExecutionPolicy&& policy, size_t capacity);
+
+   /** Bytes per element of the raw pointer columns
+    */
+   static constexpr size_t shared_element_bytes() noexcept;
+
+   /** Call f on element i without marking it as written
+    */
+   template < class CallBack, class... Args >
+   decltype(auto) invoke_element(size_t i, CallBack&& f, Args&&... args);
+
+   /** Mark every element as written and notify the observers after
+    * elements moved to new indices
+    */
+   void elements_reordered(size_t old_size);
+
+   /** Call f(observer&) for every attached observer
+    */
+   template < class F >
+   void notify(F&& f);
+
+   Tuple _data;
+   Allocator _allocator;
+   /** Defaults set with set_default */
+   std::tuple<std::optional<typename detail::soa_element_value_type<std::remove_cv_t<std::remove_reference_t<Types>>>::value_type>...> _defaults;
+   std::vector<observer*> _observers;
+   detail::soa_dirty_tracker _dirty{sizeof...(Types)};
+   size_t _dirty_epoch = 0;
 };
 
-// Create a parcel data type
-CREATE_PARCEL_STORAGE(Liquid,
-   PARCEL_DATA(
-      (std::vector<xlib::vec<double,3>>, position),
-      (std::vector<xlib::vec<double,3>>, velocity)
-      (std::vector<double>, radius),
-      (xlib::nd_array<double,2>, species_mf)
-   ),
-   MEMBER_DATA(
-      (double, asdf, 1.0 /* Default value//)
-   )
-);
-
-
-int main()
-{
-   Mesh* mesh = new Mesh;
-
-   // Register parcel data type
-   mesh->addParcelData<LiquidParcelData>("liquid_spray_1");
-   auto& pdata = mesh->getParcelData<LiquidParcelData>("liquid_spray_1");
-   pdata.position(i); // zero overhead, compile time getter
-   pdata.position(i)[j];
-   pdata.species_mf(i)[j];
-   pdata.member<int>("num_species") = num_parcel_species;
-   pdata.member<struct species_defintion**>("species") = new struct species_defintion*[num_parcel_species];
+/** Structure of arrays with one allocation per raw pointer column
+ */
+template < class... Types >
+using static_soa = basic_static_soa<soa_column_allocator, Types...>;
 
-}
-*/
+/** Structure of arrays with all raw pointer columns in one slab
+ */
+template < class... Types >
+using arena_static_soa = basic_static_soa<soa_arena_allocator, Types...>;
+} // namespace xlib
 
+#include "detail/static_soa.hpp"
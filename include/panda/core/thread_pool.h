@@ -0,0 +1,82 @@
+#pragma once
+
+#include <xlib/core/class_traits.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace xlib
+{
+
+/** Persistent pool of worker threads used by the parallel execution policies
+ *
+ * A parallel region runs a job on a fixed number of threads, the calling
+ * thread always participates as thread 0 and worker w always runs as thread w,
+ * so a static partition of work maps to the same threads on every call.
+ */
+class thread_pool: non_copyable, non_moveable
+{
+public:
+   ~thread_pool();
+
+   /** Get the process wide thread pool
+    * @return thread pool shared by all parallel execution policies
+    */
+   static thread_pool& instance();
+
+   /** Default number of threads in a parallel region, read from the
+    * XLIB_NUM_THREADS environment variable or the hardware concurrency
+    * @return default number of threads
+    */
+   static size_t default_concurrency();
+
+   /** Check if the calling thread is currently running a parallel region
+    * @return true inside of a parallel region
+    */
+   static bool in_parallel() noexcept;
+
+   /** Run a function on num_threads threads and wait for all of them to finish
+    * Nested calls from inside a parallel region run all thread indices serially
+    * on the calling thread.
+    * @tparam F functor type callable as f(size_t thread_index, size_t num_threads)
+    * @param num_threads number of threads to run f on, 0 for default_concurrency()
+    * @param f function to run
+    */
+   template < class F >
+   void run(size_t num_threads, F&& f);
+
+private:
+   thread_pool() = default;
+
+   struct job
+   {
+      void (*invoke)(void* f, size_t thread_index, size_t num_threads) = nullptr;
+      void* f = nullptr;
+      size_t num_threads = 0;
+   };
+
+   void run_job(const job& j);
+   void grow(size_t num_workers);
+   void worker_loop(size_t thread_index, size_t generation);
+
+   std::mutex _run_lock;
+
+   std::mutex _lock;
+   std::condition_variable _start;
+   std::condition_variable _done;
+   std::vector<std::thread> _workers;
+   job _job;
+   size_t _generation = 0;
+   size_t _remaining = 0;
+   bool _stop = false;
+   std::exception_ptr _error;
+};
+
+} // namespace xlib
+
+#include "detail/thread_pool.hpp"
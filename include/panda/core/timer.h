@@ -1,10 +1,49 @@
 #pragma once
 
 #include <chrono>
+#include <cstdint>
 
-struct Timer
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define XLIB_HAS_TSC 1
+#else
+#define XLIB_HAS_TSC 0
+#endif
+
+namespace xlib
+{
+
+/** Cheapest monotonic tick counter available
+ *
+ * Reads the time stamp counter on x86 and falls back to steady_clock
+ * nanoseconds elsewhere. Ticks are converted to seconds with a rate measured
+ * against steady_clock.
+ */
+struct tsc_clock
 {
-   using clock = std::chrono::high_resolution_clock;
+   static constexpr bool is_tsc = XLIB_HAS_TSC;
+
+   static uint64_t now() noexcept
+   {
+#if XLIB_HAS_TSC
+      return __rdtsc();
+#else
+      return std::chrono::duration_cast<std::chrono::nanoseconds>(
+         std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+   }
+
+   /** Seconds per tick, the first call busy waits a millisecond to
+    * calibrate the time stamp counter
+    */
+   static double seconds_per_tick();
+};
+
+/** Stop watch, tic() starts and toc() stops a measurement
+ */
+struct timer
+{
+   using clock = std::chrono::steady_clock;
    using tpoint = clock::time_point;
 
    void tic()
@@ -17,7 +56,7 @@ struct Timer
    }
 
    template < class T >
-   typename T::rep elapsed()
+   typename T::rep elapsed() const
    {
       T elapsed = std::chrono::duration_cast<T>(end - start);
       return  elapsed.count();
@@ -25,3 +64,39 @@ struct Timer
    tpoint start, end;
 };
 
+inline double tsc_clock::seconds_per_tick()
+{
+   if constexpr(!is_tsc)
+   {
+      return 1e-9;
+   }
+   else
+   {
+      using steady = std::chrono::steady_clock;
+      struct anchor
+      {
+         steady::time_point time = steady::now();
+         uint64_t ticks = tsc_clock::now();
+      };
+      static const anchor first;
+      static const double rate = []
+      {
+         // Calibrate over a 1 ms window against steady_clock
+         steady::time_point t;
+         uint64_t ticks;
+         do
+         {
+            t = steady::now();
+            ticks = tsc_clock::now();
+         } while(t - first.time < std::chrono::milliseconds(1));
+         return std::chrono::duration<double>(t - first.time).count() / double(ticks - first.ticks);
+      }();
+      return rate;
+   }
+}
+
+} // namespace xlib
+
+/** Deprecated name of xlib::timer
+ */
+using Timer = xlib::timer;
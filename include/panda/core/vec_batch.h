@@ -0,0 +1,76 @@
+#pragma once
+
+#include <xlib/core/vector.h>
+#include <xlib/core/static_soa.h>
+
+namespace xlib
+{
+
+/** Batched vec operations over whole arrays of vecs, e.g. static_soa columns
+ *
+ * vec<double,3>, vec<float,3> and vec<float,4> use SSE2/AVX kernels when the
+ * target supports them, every other shape uses the scalar vec operations.
+ */
+namespace batch
+{
+
+/** out[i] = a[i].dot(b[i]) for i in [0, n)
+ */
+template < class T, size_t N >
+void dot(const vec<T,N>* a, const vec<T,N>* b, promote_fp_t<T>* out, size_t n);
+
+/** out[i] = a[i].cross(b[i]) for i in [0, n)
+ */
+template < class T >
+void cross(const vec<T,3>* a, const vec<T,3>* b, vec<promote_fp_t<T>,3>* out, size_t n);
+
+/** out[i] = a[i].norm() for i in [0, n)
+ */
+template < class T, size_t N >
+void norm(const vec<T,N>* a, promote_fp_t<T>* out, size_t n);
+
+/** Dot product of every element of two columns of vecs
+ * @param a column of vecs (std::vector or raw pointer column)
+ * @param b column of vecs with the same size as a
+ * @param out column of scalars with the same size as a
+ */
+template < class ColA, class ColB, class ColOut >
+void dot(const ColA& a, const ColB& b, ColOut& out);
+
+/** Dot product of every element of two columns of vecs, split across threads
+ */
+template < class ExecutionPolicy, class ColA, class ColB, class ColOut,
+   class = std::enable_if_t<execution::is_execution_policy_v<ExecutionPolicy>> >
+void dot(ExecutionPolicy&& policy, const ColA& a, const ColB& b, ColOut& out);
+
+/** Cross product of every element of two columns of 3-vecs
+ * @param a column of vecs (std::vector or raw pointer column)
+ * @param b column of vecs with the same size as a
+ * @param out column of vecs with the same size as a
+ */
+template < class ColA, class ColB, class ColOut >
+void cross(const ColA& a, const ColB& b, ColOut& out);
+
+/** Cross product of every element of two columns of 3-vecs, split across threads
+ */
+template < class ExecutionPolicy, class ColA, class ColB, class ColOut,
+   class = std::enable_if_t<execution::is_execution_policy_v<ExecutionPolicy>> >
+void cross(ExecutionPolicy&& policy, const ColA& a, const ColB& b, ColOut& out);
+
+/** Norm of every element of a column of vecs
+ * @param a column of vecs (std::vector or raw pointer column)
+ * @param out column of scalars with the same size as a
+ */
+template < class ColA, class ColOut >
+void norm(const ColA& a, ColOut& out);
+
+/** Norm of every element of a column of vecs, split across threads
+ */
+template < class ExecutionPolicy, class ColA, class ColOut,
+   class = std::enable_if_t<execution::is_execution_policy_v<ExecutionPolicy>> >
+void norm(ExecutionPolicy&& policy, const ColA& a, ColOut& out);
+
+} // namespace batch
+} // namespace xlib
+
+#include "detail/vec_batch.hpp"
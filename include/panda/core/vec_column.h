@@ -0,0 +1,245 @@
+#pragma once
+
+#include <xlib/core/vector.h>
+#include <xlib/core/vec_batch.h>
+#include <xlib/core/static_soa.h>
+
+#include <type_traits>
+#include <cstddef>
+
+namespace xlib
+{
+
+/** Reference to one element of a vec_column
+ *
+ * Component c of the element lives at p[c * stride]. Assigning to a vec_ref
+ * writes through to the column, copying a vec_ref only copies the reference.
+ * Use load() to get a vec value for arithmetic.
+ */
+template < class T, size_t N >
+class vec_ref
+{
+public:
+   using value_type = vec<std::remove_const_t<T>,N>;
+
+   vec_ref(T* p, size_t stride) noexcept: _p(p), _stride(stride) {}
+   vec_ref(const vec_ref&) = default;
+
+   template < class U, class = std::enable_if_t<std::is_same<const U,T>::value && !std::is_same<U,T>::value> >
+   vec_ref(const vec_ref<U,N>& other) noexcept: _p(other._p), _stride(other._stride) {}
+
+   T& operator[](size_t c) const { _XLIB_ASSERT(RANGE, 0, N, c); return _p[c * _stride]; }
+
+   static constexpr size_t size() noexcept { return N; }
+
+   value_type load() const noexcept
+   {
+      value_type v;
+      for(size_t c = 0; c < N; ++c) v[c] = _p[c * _stride];
+      return v;
+   }
+
+   operator value_type() const noexcept { return this->load(); }
+
+   const vec_ref& operator=(const value_type& v) const noexcept
+   {
+      for(size_t c = 0; c < N; ++c) _p[c * _stride] = v[c];
+      return *this;
+   }
+
+   const vec_ref& operator=(const vec_ref& rhs) const noexcept
+   {
+      return *this = rhs.load();
+   }
+
+   template < class U >
+   const vec_ref& operator=(const vec_ref<U,N>& rhs) const noexcept
+   {
+      return *this = rhs.load();
+   }
+
+   const vec_ref& operator+=(const value_type& v) const noexcept
+   {
+      for(size_t c = 0; c < N; ++c) _p[c * _stride] += v[c];
+      return *this;
+   }
+
+   const vec_ref& operator-=(const value_type& v) const noexcept
+   {
+      for(size_t c = 0; c < N; ++c) _p[c * _stride] -= v[c];
+      return *this;
+   }
+
+   const vec_ref& operator*=(std::remove_const_t<T> s) const noexcept
+   {
+      for(size_t c = 0; c < N; ++c) _p[c * _stride] *= s;
+      return *this;
+   }
+
+private:
+   T* _p;
+   size_t _stride;
+   template < class, size_t > friend class vec_ref;
+};
+
+/** Column of N-component vecs stored by component instead of by element
+ *
+ * With W == 0 every component is stored in its own plane,
+ *    | x0 x1 ... | y0 y1 ... | z0 z1 ... |
+ * with W > 0 elements are stored in tiles of W elements (AoSoA),
+ *    | x0 .. xW-1 y0 .. yW-1 z0 .. zW-1 | xW .. |
+ * so that every component is unit stride within a plane or tile. The column
+ * behaves like a std::vector of vec<T,N> whose operator[] returns vec_ref
+ * proxies, and plugs into static_soa through the soa_* column traits.
+ *
+ * Callbacks passed to static_soa::apply_to_element and friends receive
+ * vec_ref<T,N> by value for vec_column columns, so they should take auto
+ * parameters.
+ *
+ * @tparam T component type, must be arithmetic
+ * @tparam N number of components
+ * @tparam W tile width, 0 for separate component planes
+ */
+template < class T, size_t N, size_t W = 0 >
+class vec_column
+{
+   static_assert(std::is_arithmetic<T>::value, "vec_column components must be arithmetic");
+   static_assert(N > 0, "vec_column requires at least one component");
+public:
+   using value_type = vec<T,N>;
+   using component_type = T;
+   using reference = vec_ref<T,N>;
+   using const_reference = vec_ref<const T,N>;
+
+   static constexpr size_t num_components = N;
+   static constexpr size_t tile_width = W;
+
+   /** Position in a vec_column, the result of data(), used by
+    * static_soa::apply_blocked to hand out blocks of a column
+    */
+   template < class Column >
+   class basic_pointer
+   {
+   public:
+      basic_pointer(Column* col, size_t offset) noexcept: _col(col), _offset(offset) {}
+
+      basic_pointer operator+(size_t n) const noexcept { return basic_pointer(_col, _offset + n); }
+      auto operator[](size_t i) const { return (*_col)[_offset + i]; }
+
+      /** Unit stride pointer to component c of the elements from this
+       * position up to the end of the plane (W == 0) or tile (W > 0)
+       */
+      auto component(size_t c) const noexcept { return &_col->component(_offset, c); }
+
+      /** Number of elements from this position on that component(c) covers
+       */
+      size_t run_length() const noexcept { return _col->run_length(_offset); }
+
+   private:
+      Column* _col;
+      size_t _offset;
+   };
+
+   using pointer = basic_pointer<vec_column>;
+   using const_pointer = basic_pointer<const vec_column>;
+
+   vec_column() = default;
+   explicit vec_column(size_t n);
+   vec_column(const vec_column& other);
+   vec_column(vec_column&& other) noexcept;
+   vec_column& operator=(const vec_column& other);
+   vec_column& operator=(vec_column&& other) noexcept;
+   ~vec_column();
+
+   reference operator[](size_t i) noexcept;
+   const_reference operator[](size_t i) const noexcept;
+
+   /** Component c of element i
+    */
+   T& component(size_t i, size_t c) noexcept { return _data[this->offset(i, c)]; }
+   const T& component(size_t i, size_t c) const noexcept { return _data[this->offset(i, c)]; }
+
+   pointer data() noexcept { return pointer(this, 0); }
+   const_pointer data() const noexcept { return const_pointer(this, 0); }
+
+   size_t size() const noexcept { return _size; }
+   size_t capacity() const noexcept { return _capacity; }
+   bool empty() const noexcept { return _size == 0; }
+
+   /** Resize the column, new elements are value initialized
+    * @param n new number of elements
+    */
+   void resize(size_t n);
+
+   void reserve(size_t n);
+   void shrink_to_fit();
+
+   /** Number of consecutive elements, starting at element i, whose
+    * components are unit stride
+    */
+   size_t run_length(size_t i) const noexcept;
+
+   void swap(vec_column& other) noexcept;
+
+private:
+   size_t offset(size_t i, size_t c) const noexcept;
+
+   /** Number of components between two components of the same element
+    */
+   size_t stride() const noexcept { return W ? W : _capacity; }
+
+   /** Move storage to a new capacity, capacity must fit the current size and
+    * be rounded with round_capacity
+    */
+   void reallocate(size_t capacity);
+
+   static size_t round_capacity(size_t n) noexcept;
+
+   T* _data = nullptr;
+   size_t _size = 0;
+   size_t _capacity = 0;
+};
+
+template < class T, size_t N, size_t W >
+void swap(vec_column<T,N,W>& lhs, vec_column<T,N,W>& rhs) noexcept
+{
+   lhs.swap(rhs);
+}
+
+namespace batch
+{
+
+/** Dot product of every element of two vec_columns, unit stride per component
+ * @param out column of scalars with the same size as a
+ */
+template < class T, size_t N, size_t W, class ColOut >
+void dot(const vec_column<T,N,W>& a, const vec_column<T,N,W>& b, ColOut& out);
+
+template < class ExecutionPolicy, class T, size_t N, size_t W, class ColOut,
+   class = std::enable_if_t<execution::is_execution_policy_v<ExecutionPolicy>> >
+void dot(ExecutionPolicy&& policy, const vec_column<T,N,W>& a, const vec_column<T,N,W>& b, ColOut& out);
+
+/** Cross product of every element of two vec_columns, unit stride per component
+ * @param out vec_column with the same size and layout as a, may be a or b
+ */
+template < class T, size_t W >
+void cross(const vec_column<T,3,W>& a, const vec_column<T,3,W>& b, vec_column<T,3,W>& out);
+
+template < class ExecutionPolicy, class T, size_t W,
+   class = std::enable_if_t<execution::is_execution_policy_v<ExecutionPolicy>> >
+void cross(ExecutionPolicy&& policy, const vec_column<T,3,W>& a, const vec_column<T,3,W>& b, vec_column<T,3,W>& out);
+
+/** Norm of every element of a vec_column, unit stride per component
+ * @param out column of scalars with the same size as a
+ */
+template < class T, size_t N, size_t W, class ColOut >
+void norm(const vec_column<T,N,W>& a, ColOut& out);
+
+template < class ExecutionPolicy, class T, size_t N, size_t W, class ColOut,
+   class = std::enable_if_t<execution::is_execution_policy_v<ExecutionPolicy>> >
+void norm(ExecutionPolicy&& policy, const vec_column<T,N,W>& a, ColOut& out);
+
+} // namespace batch
+} // namespace xlib
+
+#include "detail/vec_column.hpp"
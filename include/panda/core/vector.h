@@ -1,4 +1,11 @@
+#pragma once
+
 #include <xlib/core/assert.h>
+#include <xlib/core/fp_promotion.h>
+
+#include <cmath>
+#include <cstddef>
+#include <type_traits>
 
 namespace xlib
 {
@@ -7,23 +14,127 @@ template < class T, size_t N >
 class vec
 {
 public:
-   T& operator[](size_t i) { _XLIB_ASSERT(RANGE, 0, N, i); return _data[i]; }
-   T& operator[](size_t i) { _XLIB_ASSERT(RANGE, 0, N, i); return _data[i]; }
+   using value_type = T;
+
+   vec() = default;
+
+   /** Construct from N components
+    */
+   template < class... Args, class = std::enable_if_t<sizeof...(Args) == N && N != 0> >
+   constexpr vec(Args... args) noexcept: _data{static_cast<T>(args)...} {}
+
+   constexpr T& operator[](size_t i) { _XLIB_ASSERT(RANGE, 0, N, i); return _data[i]; }
+   constexpr const T& operator[](size_t i) const { _XLIB_ASSERT(RANGE, 0, N, i); return _data[i]; }
+
+   static constexpr size_t size() noexcept { return N; }
+
+   constexpr T* data() noexcept { return _data; }
+   constexpr const T* data() const noexcept { return _data; }
 
    template < class U, class = std::enable_if_t<std::is_convertible<T,U>::value> >
-   xlib::promote_fp_t<T> dot(const vec<U,N>& lhs)
+   constexpr xlib::promote_fp_t<std::common_type_t<T,U>> dot(const vec<U,N>& rhs) const
+   {
+      using R = xlib::promote_fp_t<std::common_type_t<T,U>>;
+      R sum = R();
+      for(size_t i = 0; i < N; ++i)
+      {
+         sum += static_cast<R>(_data[i]) * static_cast<R>(rhs[i]);
+      }
+      return sum;
+   }
+
+   template < class U, size_t M = N, class = std::enable_if_t<std::is_convertible<T,U>::value && M == 3> >
+   constexpr vec<xlib::promote_fp_t<std::common_type_t<T,U>>,N> cross(const vec<U,N>& rhs) const
+   {
+      using R = xlib::promote_fp_t<std::common_type_t<T,U>>;
+      const vec<T,N>& lhs = *this;
+      return vec<R,N>(
+         static_cast<R>(lhs[1]) * rhs[2] - static_cast<R>(lhs[2]) * rhs[1],
+         static_cast<R>(lhs[2]) * rhs[0] - static_cast<R>(lhs[0]) * rhs[2],
+         static_cast<R>(lhs[0]) * rhs[1] - static_cast<R>(lhs[1]) * rhs[0]);
+   }
+
+   /** Squared euclidean norm
+    */
+   constexpr xlib::promote_fp_t<T> norm2() const
+   {
+      return this->dot(*this);
+   }
+
+   /** Euclidean norm
+    */
+   xlib::promote_fp_t<T> norm() const
+   {
+      return std::sqrt(this->norm2());
+   }
+
+   constexpr vec& operator+=(const vec& rhs)
    {
+      for(size_t i = 0; i < N; ++i) _data[i] += rhs._data[i];
+      return *this;
+   }
 
+   constexpr vec& operator-=(const vec& rhs)
+   {
+      for(size_t i = 0; i < N; ++i) _data[i] -= rhs._data[i];
+      return *this;
+   }
+
+   constexpr vec& operator*=(T s)
+   {
+      for(size_t i = 0; i < N; ++i) _data[i] *= s;
+      return *this;
    }
 
-   template < class U, class = std::enable_if_t<std::is_convertible<T,U>::value && N == 3> >
-   vec<xlib::promote_fp_t<T>,N> cross(const vec<U,N>& lhs)
+   constexpr vec& operator/=(T s)
    {
+      for(size_t i = 0; i < N; ++i) _data[i] /= s;
+      return *this;
+   }
+
+   friend constexpr vec operator+(vec lhs, const vec& rhs) { return lhs += rhs; }
+   friend constexpr vec operator-(vec lhs, const vec& rhs) { return lhs -= rhs; }
+   friend constexpr vec operator*(vec lhs, T s) { return lhs *= s; }
+   friend constexpr vec operator*(T s, vec rhs) { return rhs *= s; }
+   friend constexpr vec operator/(vec lhs, T s) { return lhs /= s; }
 
+   friend constexpr vec operator-(vec v)
+   {
+      for(size_t i = 0; i < N; ++i) v._data[i] = -v._data[i];
+      return v;
    }
 
+   friend constexpr bool operator==(const vec& lhs, const vec& rhs)
+   {
+      for(size_t i = 0; i < N; ++i)
+      {
+         if(!(lhs._data[i] == rhs._data[i])) return false;
+      }
+      return true;
+   }
+
+   friend constexpr bool operator!=(const vec& lhs, const vec& rhs) { return !(lhs == rhs); }
+
 private:
    T _data[N];
 };
 
-}
\ No newline at end of file
+template < class T, class U, size_t N >
+constexpr auto dot(const vec<T,N>& lhs, const vec<U,N>& rhs)
+{
+   return lhs.dot(rhs);
+}
+
+template < class T, class U >
+constexpr auto cross(const vec<T,3>& lhs, const vec<U,3>& rhs)
+{
+   return lhs.cross(rhs);
+}
+
+template < class T, size_t N >
+auto norm(const vec<T,N>& v)
+{
+   return v.norm();
+}
+
+}
@@ -2,11 +2,23 @@
 
 #include <xlib/core/assert.h>
 #include <xlib/core/class_traits.h>
-//#include <xlib/core/vector.h>
+#include <xlib/core/double_buffer.h>
+#include <xlib/core/execution.h>
+#include <xlib/core/vector.h>
+#include <xlib/core/vec_batch.h>
+#include <xlib/core/vec_column.h>
 //#include <xlib/core/matrix.h>
 //#include <xlib/core/cube.h>
-//#include <xlib/core/fp_promotions.h>
-//#include <xlib/core/soa.h>
+#include <xlib/core/fp_promotion.h>
+#include <xlib/core/mapped_column.h>
+#include <xlib/core/nd_array.h>
+#include <xlib/core/numa.h>
+#include <xlib/core/parcel_storage.h>
+#include <xlib/core/profiler.h>
+#include <xlib/core/soa.h>
+#include <xlib/core/soa_append_buffer.h>
+#include <xlib/core/soa_checkpoint.h>
+#include <xlib/core/soa_csr_index.h>
 #include <xlib/core/static_soa.h>
 #include <xlib/core/timer.h>
 
@@ -0,0 +1,319 @@
+#include "xlib/core/mapped_column.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace xlib
+{
+namespace detail
+{
+
+namespace
+{
+
+constexpr char mapped_magic[8] = {'X', 'L', 'I', 'B', 'C', 'O', 'L', '1'};
+
+[[noreturn]] void throw_errno(const std::string& what)
+{
+   throw std::system_error(errno, std::generic_category(), "mapped_column: " + what);
+}
+
+/** Length of a mapping of bytes bytes including its last partial page
+ */
+size_t round_to_pages(size_t bytes) noexcept
+{
+   static const size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+   return (bytes + page - 1) / page * page;
+}
+
+} // namespace
+
+struct mapped_storage::header
+{
+   char magic[8];
+   uint64_t element_size;
+   uint64_t data_offset;
+   uint64_t size;
+};
+
+mapped_storage::mapped_storage(size_t element_size, size_t alignment) noexcept:
+   _element_size(element_size),
+   _offset(std::max(alignment, sizeof(header)))
+{}
+
+mapped_storage::mapped_storage(const std::string& path, map_mode mode, size_t element_size, size_t alignment):
+   _mode(mode),
+   _element_size(element_size),
+   _offset(std::max(alignment, sizeof(header)))
+{
+   int flags = mode == map_mode::create ? O_RDWR | O_CREAT | O_TRUNC
+             : mode == map_mode::open ? O_RDWR
+             : O_RDONLY;
+   _fd = ::open(path.c_str(), flags, 0644);
+   if(_fd < 0) throw_errno("open " + path);
+
+   if(mode == map_mode::create)
+   {
+      try
+      {
+         this->reallocate(0);
+      }
+      catch(...)
+      {
+         ::close(_fd);
+         throw;
+      }
+      return;
+   }
+
+   struct stat st;
+   if(::fstat(_fd, &st) != 0)
+   {
+      int err = errno;
+      ::close(_fd);
+      throw std::system_error(err, std::generic_category(), "mapped_column: stat " + path);
+   }
+   if(static_cast<size_t>(st.st_size) < sizeof(header))
+   {
+      ::close(_fd);
+      throw std::runtime_error("mapped_column: " + path + " is not a column file");
+   }
+
+   int prot = PROT_READ | PROT_WRITE;
+   int share = mode == map_mode::open ? MAP_SHARED : MAP_PRIVATE;
+   void* base = ::mmap(nullptr, st.st_size, prot, share, _fd, 0);
+   if(base == MAP_FAILED)
+   {
+      int err = errno;
+      ::close(_fd);
+      throw std::system_error(err, std::generic_category(), "mapped_column: mmap " + path);
+   }
+   _base = static_cast<char*>(base);
+   _bytes = st.st_size;
+   _file_bytes = round_to_pages(_bytes);
+
+   const header* h = this->get_header();
+   const char* error = nullptr;
+   if(std::memcmp(h->magic, mapped_magic, sizeof(mapped_magic)) != 0)
+   {
+      error = " is not a column file";
+   }
+   else if(h->element_size != element_size)
+   {
+      error = " holds elements of a different size";
+   }
+   else if(h->data_offset % alignment != 0 || h->data_offset < sizeof(header) ||
+      h->data_offset + h->size * element_size > _bytes)
+   {
+      error = " is corrupted";
+   }
+   if(error)
+   {
+      ::munmap(_base, _bytes);
+      ::close(_fd);
+      throw std::runtime_error("mapped_column: " + path + error);
+   }
+   _offset = h->data_offset;
+}
+
+mapped_storage::mapped_storage(mapped_storage&& other) noexcept:
+   _element_size(other._element_size),
+   _offset(other._offset)
+{
+   this->swap(other);
+}
+
+mapped_storage& mapped_storage::operator=(mapped_storage&& other) noexcept
+{
+   this->swap(other);
+   return *this;
+}
+
+mapped_storage::~mapped_storage()
+{
+   if(_base)
+   {
+      if(this->file_backed())
+      {
+         // Drop the unused capacity from the file
+         size_t bytes = _offset + this->size() * _element_size;
+         ::munmap(_base, _bytes);
+         int rc = ::ftruncate(_fd, bytes);
+         (void)rc;
+      }
+      else
+      {
+         ::munmap(_base, _bytes);
+      }
+   }
+   if(_fd >= 0) ::close(_fd);
+}
+
+size_t mapped_storage::size() const noexcept
+{
+   return _base ? this->get_header()->size : 0;
+}
+
+void mapped_storage::set_size(size_t n) noexcept
+{
+   assert(_base && n <= this->capacity());
+   this->get_header()->size = n;
+}
+
+size_t mapped_storage::capacity() const noexcept
+{
+   return _base ? (_bytes - _offset) / _element_size : 0;
+}
+
+void mapped_storage::reallocate(size_t capacity)
+{
+   assert(capacity >= this->size());
+   size_t bytes = _offset + capacity * _element_size;
+
+   if(!_base && _fd < 0)
+   {
+      void* base = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if(base == MAP_FAILED) throw_errno("mmap");
+      _base = static_cast<char*>(base);
+      _bytes = bytes;
+   }
+   else if(_mode == map_mode::copy_on_write)
+   {
+#if defined(__linux__)
+      this->remap_private(bytes);
+#else
+      // The file is never written, move the column to anonymous memory
+      void* base = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if(base == MAP_FAILED) throw_errno("mmap");
+      std::memcpy(base, _base, _offset + this->size() * _element_size);
+      ::munmap(_base, _bytes);
+      ::close(_fd);
+      _fd = -1;
+      _mode = map_mode::create;
+      _base = static_cast<char*>(base);
+      _bytes = bytes;
+#endif
+      return;
+   }
+   else if(!_base)
+   {
+      // Newly created file
+      if(::ftruncate(_fd, bytes) != 0) throw_errno("ftruncate");
+      void* base = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+      if(base == MAP_FAILED) throw_errno("mmap");
+      _base = static_cast<char*>(base);
+      _bytes = bytes;
+   }
+   else if(_fd >= 0)
+   {
+      // Grow the file before the mapping and shrink it after, the mapping
+      // never reaches past the end of the file
+      if(bytes > _bytes && ::ftruncate(_fd, bytes) != 0) throw_errno("ftruncate");
+      this->remap(bytes);
+      if(bytes < _bytes && ::ftruncate(_fd, bytes) != 0) throw_errno("ftruncate");
+      _bytes = bytes;
+      return;
+   }
+   else
+   {
+      this->remap(bytes);
+      _bytes = bytes;
+      return;
+   }
+
+   header* h = this->get_header();
+   std::memcpy(h->magic, mapped_magic, sizeof(mapped_magic));
+   h->element_size = _element_size;
+   h->data_offset = _offset;
+   h->size = 0;
+}
+
+void mapped_storage::remap(size_t bytes)
+{
+#if defined(__linux__)
+   void* base = ::mremap(_base, _bytes, bytes, MREMAP_MAYMOVE);
+   if(base == MAP_FAILED) throw_errno("mremap");
+#else
+   int share = _fd >= 0 ? MAP_SHARED : MAP_PRIVATE | MAP_ANONYMOUS;
+   void* base = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, share, _fd, 0);
+   if(base == MAP_FAILED) throw_errno("mmap");
+   if(_fd < 0) std::memcpy(base, _base, std::min(bytes, _bytes));
+   ::munmap(_base, _bytes);
+#endif
+   _base = static_cast<char*>(base);
+}
+
+#if defined(__linux__)
+void mapped_storage::remap_private(size_t bytes)
+{
+   size_t old_pages = round_to_pages(_bytes);
+   size_t new_pages = round_to_pages(bytes);
+   if(new_pages <= old_pages)
+   {
+      if(new_pages < old_pages && ::munmap(_base + new_pages, old_pages - new_pages) != 0) throw_errno("munmap");
+      _file_bytes = std::min(_file_bytes, new_pages);
+      _bytes = bytes;
+      return;
+   }
+
+   // Reserve zeroed anonymous memory and move the private file mapping over
+   // its front. mremap keeps the pages that were written and leaves the rest
+   // backed by the file, so nothing is read that was not touched before.
+   void* reserved = ::mmap(nullptr, new_pages, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+   if(reserved == MAP_FAILED) throw_errno("mmap");
+   char* base = static_cast<char*>(reserved);
+   if(::mremap(_base, _file_bytes, _file_bytes, MREMAP_MAYMOVE | MREMAP_FIXED, base) == MAP_FAILED)
+   {
+      int err = errno;
+      ::munmap(base, new_pages);
+      throw std::system_error(err, std::generic_category(), "mapped_column: mremap");
+   }
+   // Anonymous pages behind the file from an earlier growth
+   if(old_pages > _file_bytes &&
+      ::mremap(_base + _file_bytes, old_pages - _file_bytes, old_pages - _file_bytes,
+         MREMAP_MAYMOVE | MREMAP_FIXED, base + _file_bytes) == MAP_FAILED)
+   {
+      int err = errno;
+      // Move the file mapping back so the column stays intact
+      void* back = ::mremap(base, _file_bytes, _file_bytes, MREMAP_MAYMOVE | MREMAP_FIXED, _base);
+      assert(back != MAP_FAILED);
+      (void)back;
+      ::munmap(base + _file_bytes, new_pages - _file_bytes);
+      throw std::system_error(err, std::generic_category(), "mapped_column: mremap");
+   }
+   _base = base;
+   _bytes = bytes;
+}
+#endif
+
+void mapped_storage::sync()
+{
+   if(_base && this->file_backed() && ::msync(_base, _bytes, MS_SYNC) != 0)
+   {
+      throw_errno("msync");
+   }
+}
+
+void mapped_storage::swap(mapped_storage& other) noexcept
+{
+   std::swap(_base, other._base);
+   std::swap(_bytes, other._bytes);
+   std::swap(_file_bytes, other._file_bytes);
+   std::swap(_fd, other._fd);
+   std::swap(_mode, other._mode);
+   std::swap(_element_size, other._element_size);
+   std::swap(_offset, other._offset);
+}
+
+} // namespace detail
+} // namespace xlib
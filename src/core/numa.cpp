@@ -0,0 +1,108 @@
+#include "xlib/core/numa.h"
+
+#include <cstring>
+
+#if defined(__linux__)
+#include <dirent.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace xlib
+{
+
+size_t numa_node_count() noexcept
+{
+#if defined(__linux__)
+   static const size_t count = []
+   {
+      size_t nodes = 0;
+      if(DIR* dir = ::opendir("/sys/devices/system/node"))
+      {
+         while(dirent* entry = ::readdir(dir))
+         {
+            if(std::strncmp(entry->d_name, "node", 4) == 0 && entry->d_name[4] >= '0' && entry->d_name[4] <= '9') nodes++;
+         }
+         ::closedir(dir);
+      }
+      return nodes ? nodes : size_t(1);
+   }();
+   return count;
+#else
+   return 1;
+#endif
+}
+
+int numa_current_node() noexcept
+{
+#if defined(__linux__) && defined(SYS_getcpu)
+   unsigned cpu = 0, node = 0;
+   if(::syscall(SYS_getcpu, &cpu, &node, nullptr) == 0) return static_cast<int>(node);
+#endif
+   return 0;
+}
+
+void numa_nodes_of(const void* const* pages, size_t count, int* nodes) noexcept
+{
+   std::fill(nodes, nodes + count, -1);
+#if defined(__linux__) && defined(SYS_move_pages)
+   // Without target nodes move_pages only reports where every page is placed,
+   // negative statuses mark pages that are not mapped yet
+   if(count && ::syscall(SYS_move_pages, 0, count, pages, nullptr, nodes, 0) != 0)
+   {
+      std::fill(nodes, nodes + count, -1);
+   }
+   for(size_t i = 0; i < count; ++i)
+   {
+      if(nodes[i] < 0) nodes[i] = -1;
+   }
+#endif
+}
+
+int numa_node_of(const void* p) noexcept
+{
+   int node = -1;
+   numa_nodes_of(&p, 1, &node);
+   return node;
+}
+
+namespace detail
+{
+
+int numa_majority_node(const char* data, size_t bytes)
+{
+   if(bytes == 0) return -1;
+
+   constexpr uintptr_t page_size = 4096;
+   uintptr_t first = reinterpret_cast<uintptr_t>(data) & ~(page_size - 1);
+   uintptr_t last = (reinterpret_cast<uintptr_t>(data) + bytes - 1) & ~(page_size - 1);
+   size_t num_pages = (last - first) / page_size + 1;
+   size_t samples = std::min(num_pages, numa_sampled_pages);
+
+   const void* pages[numa_sampled_pages];
+   int nodes[numa_sampled_pages];
+   for(size_t s = 0; s < samples; ++s)
+   {
+      size_t page = samples > 1 ? s * (num_pages - 1) / (samples - 1) : 0;
+      pages[s] = reinterpret_cast<const void*>(first + page * page_size);
+   }
+   numa_nodes_of(pages, samples, nodes);
+
+   // Most frequent known node, ties go to the lower node
+   int best = -1;
+   size_t best_count = 0;
+   for(size_t s = 0; s < samples; ++s)
+   {
+      if(nodes[s] < 0) continue;
+      size_t c = std::count(nodes, nodes + samples, nodes[s]);
+      if(c > best_count || (c == best_count && nodes[s] < best))
+      {
+         best = nodes[s];
+         best_count = c;
+      }
+   }
+   return best;
+}
+
+} // namespace detail
+} // namespace xlib
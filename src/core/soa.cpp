@@ -1,20 +1,154 @@
 #include "xlib/core/soa.h"
 
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+
 namespace xlib
 {
 
+soa_bucket::~soa_bucket()
+{
+   // Destroy entries in reverse registration order
+   while(!_data.empty())
+   {
+      _data.pop_back();
+   }
+}
 
-soa_bucket::soa_bucket(soa_bucket&& other)
+void soa_bucket::add_data_dependency(const handle& h, const handle& dependency_handle)
 {
-   std::swap(other._data, this->_data);
+   assert(h.entry() && h.entry()->parent() == this);
+   assert(dependency_handle.entry() && dependency_handle.entry()->parent() == this);
+
+   std::lock_guard<std::mutex> lk(_map_lock);
+   entry* e = h.entry();
+   entry* dep = dependency_handle.entry();
+
+   // Reject the link if e is already reachable from the dependency
+   std::vector<entry*> stack{dep};
+   std::vector<bool> visited(_data.size(), false);
+   while(!stack.empty())
+   {
+      entry* x = stack.back();
+      stack.pop_back();
+      if(x == e)
+      {
+         throw std::invalid_argument("soa_bucket::add_data_dependency: dependency cycle");
+      }
+      if(visited[x->index()]) continue;
+      visited[x->index()] = true;
+      stack.insert(stack.end(), x->_dependencies.begin(), x->_dependencies.end());
+   }
+
+   auto& deps = e->_dependencies;
+   if(std::find(deps.begin(), deps.end(), dep) == deps.end())
+   {
+      deps.push_back(dep);
+      _levels_valid = false;
+   }
 }
 
-soa_bucket::~soa_bucket()
+void soa_bucket::update_levels()
 {
+   if(_levels_valid) return;
+
+   // Level of an entry is one more than the deepest of its dependencies
+   std::vector<size_t> level(_data.size(), 0);
+   std::vector<size_t> pending(_data.size(), 0);
+   std::vector<std::vector<entry*>> dependents(_data.size());
+   std::vector<entry*> ready;
    for(auto& e: _data)
    {
-      delete e.first;
+      pending[e->index()] = e->_dependencies.size();
+      for(entry* dep: e->_dependencies)
+      {
+         dependents[dep->index()].push_back(e.get());
+      }
+      if(e->_dependencies.empty()) ready.push_back(e.get());
+   }
+
+   _levels.clear();
+   while(!ready.empty())
+   {
+      entry* e = ready.back();
+      ready.pop_back();
+      size_t l = level[e->index()];
+      if(_levels.size() <= l) _levels.resize(l + 1);
+      _levels[l].push_back(e);
+      for(entry* d: dependents[e->index()])
+      {
+         level[d->index()] = std::max(level[d->index()], l + 1);
+         if(--pending[d->index()] == 0) ready.push_back(d);
+      }
+   }
+   for(auto& l: _levels)
+   {
+      std::sort(l.begin(), l.end(), [](entry* a, entry* b) { return a->index() < b->index(); });
+   }
+   _levels_valid = true;
+}
+
+void soa_bucket::for_each_in_dependency_order(size_t num_threads, const std::function<void(entry&)>& f)
+{
+   this->update_levels();
+   for(auto& level: _levels)
+   {
+      size_t threads = std::min(num_threads, level.size());
+      if(threads <= 1)
+      {
+         for(entry* e: level) f(*e);
+         continue;
+      }
+
+      std::atomic<size_t> next{0};
+      thread_pool::instance().run(threads, [&](size_t, size_t)
+      {
+         for(size_t k = next++; k < level.size(); k = next++)
+         {
+            f(*level[k]);
+         }
+      });
    }
 }
 
-}
\ No newline at end of file
+void soa_bucket::resize_impl(size_t num_threads, size_t n)
+{
+   std::lock_guard<std::mutex> lk(_map_lock);
+   this->for_each_in_dependency_order(num_threads, [n](entry& e) { e.resize(n); });
+   _size = n;
+}
+
+void soa_bucket::reorder_impl(size_t num_threads, const std::vector<size_t>& new_index_map)
+{
+   std::lock_guard<std::mutex> lk(_map_lock);
+   assert(new_index_map.size() == _size);
+
+   detail::soa_permutation<size_t> perm(new_index_map);
+   if(perm.cycle_leaders.empty()) return;
+   this->for_each_in_dependency_order(num_threads, [&perm](entry& e) { e.reorder(perm); });
+}
+
+void soa_bucket::resize(size_t n)
+{
+   this->resize_impl(thread_pool::default_concurrency(), n);
+}
+
+void soa_bucket::reorder(const std::vector<size_t>& new_index_map)
+{
+   this->reorder_impl(thread_pool::default_concurrency(), new_index_map);
+}
+
+size_t soa_bucket::size() const
+{
+   std::lock_guard<std::mutex> lk(_map_lock);
+   return _size;
+}
+
+size_t soa_bucket::num_entries() const
+{
+   std::lock_guard<std::mutex> lk(_map_lock);
+   return _data.size();
+}
+
+}
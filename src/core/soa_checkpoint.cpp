@@ -0,0 +1,272 @@
+#include "xlib/core/soa_checkpoint.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <system_error>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace xlib
+{
+namespace detail
+{
+
+namespace
+{
+
+constexpr char checkpoint_magic[8] = {'X', 'L', 'I', 'B', 'S', 'O', 'A', '1'};
+
+/** Payloads start on a page boundary so they can be mapped or read with
+ * direct I/O
+ */
+constexpr uint64_t checkpoint_payload_alignment = 4096;
+
+inline uint64_t align(uint64_t x) noexcept
+{
+   return (x + checkpoint_payload_alignment - 1) / checkpoint_payload_alignment * checkpoint_payload_alignment;
+}
+
+struct checkpoint_header
+{
+   char magic[8];
+   uint64_t num_columns;
+   uint64_t size;
+   uint64_t reserved;
+};
+
+constexpr uint64_t hash_prime1 = 0x9E3779B185EBCA87ull;
+constexpr uint64_t hash_prime2 = 0xC2B2AE3D27D4EB4Full;
+constexpr uint64_t hash_prime3 = 0x165667B19E3779F9ull;
+
+inline uint64_t rotl(uint64_t x, int r) noexcept
+{
+   return (x << r) | (x >> (64 - r));
+}
+
+inline uint64_t hash_round(uint64_t acc, uint64_t word) noexcept
+{
+   return rotl(acc + word * hash_prime2, 31) * hash_prime1;
+}
+
+[[noreturn]] void throw_errno(const std::string& what, const std::string& path)
+{
+   throw std::system_error(errno, std::generic_category(), "checkpoint: " + what + " " + path);
+}
+
+} // namespace
+
+checkpoint_hasher::checkpoint_hasher() noexcept:
+   _lanes{hash_prime1 + hash_prime2, hash_prime2, 0, 0 - hash_prime1}
+{}
+
+void checkpoint_hasher::consume(const unsigned char* block) noexcept
+{
+   for(size_t l = 0; l < 4; ++l)
+   {
+      uint64_t word;
+      std::memcpy(&word, block + 8 * l, 8);
+      _lanes[l] = hash_round(_lanes[l], word);
+   }
+}
+
+void checkpoint_hasher::update(const void* data, size_t bytes) noexcept
+{
+   if(bytes == 0) return;
+   const unsigned char* p = static_cast<const unsigned char*>(data);
+   _total += bytes;
+
+   if(_tail_bytes)
+   {
+      size_t n = std::min(bytes, sizeof(_tail) - _tail_bytes);
+      std::memcpy(_tail + _tail_bytes, p, n);
+      _tail_bytes += n;
+      p += n;
+      bytes -= n;
+      if(_tail_bytes < sizeof(_tail)) return;
+      this->consume(_tail);
+      _tail_bytes = 0;
+   }
+   for(; bytes >= sizeof(_tail); p += sizeof(_tail), bytes -= sizeof(_tail))
+   {
+      this->consume(p);
+   }
+   std::memcpy(_tail, p, bytes);
+   _tail_bytes = bytes;
+}
+
+uint64_t checkpoint_hasher::digest() const noexcept
+{
+   uint64_t h = rotl(_lanes[0], 1) + rotl(_lanes[1], 7) + rotl(_lanes[2], 12) + rotl(_lanes[3], 18);
+   h += _total;
+   for(size_t i = 0; i < _tail_bytes; ++i)
+   {
+      h = rotl(h ^ (_tail[i] * hash_prime3), 11) * hash_prime1;
+   }
+   h ^= h >> 33;
+   h *= hash_prime2;
+   h ^= h >> 29;
+   h *= hash_prime3;
+   h ^= h >> 32;
+   return h;
+}
+
+checkpoint_file::checkpoint_file(const std::string& path, open_mode mode):
+   _path(path)
+{
+   int flags = mode == open_read ? O_RDONLY
+             : mode == open_update ? O_RDWR
+             : O_RDWR | O_CREAT | O_TRUNC;
+   _fd = ::open(path.c_str(), flags, 0644);
+   if(_fd < 0) throw_errno("open", path);
+}
+
+checkpoint_file::~checkpoint_file()
+{
+   if(_fd >= 0) ::close(_fd);
+}
+
+bool checkpoint_file::read_header(uint64_t& size, std::vector<checkpoint_column>& columns)
+{
+   checkpoint_header h;
+   struct stat st;
+   if(::fstat(_fd, &st) != 0) throw_errno("stat", _path);
+   if(static_cast<uint64_t>(st.st_size) < sizeof(h)) return false;
+
+   this->read(&h, sizeof(h), 0);
+   if(std::memcmp(h.magic, checkpoint_magic, sizeof(checkpoint_magic)) != 0) return false;
+   if(sizeof(h) + h.num_columns * sizeof(checkpoint_column) > static_cast<uint64_t>(st.st_size)) return false;
+
+   columns.resize(h.num_columns);
+   this->read(columns.data(), columns.size() * sizeof(checkpoint_column), sizeof(h));
+   for(auto& c: columns)
+   {
+      if(c.offset + c.bytes > static_cast<uint64_t>(st.st_size)) return false;
+   }
+   size = h.size;
+   return true;
+}
+
+void checkpoint_file::write_header(uint64_t size, const std::vector<checkpoint_column>& columns)
+{
+   checkpoint_header h = {};
+   std::memcpy(h.magic, checkpoint_magic, sizeof(checkpoint_magic));
+   h.num_columns = columns.size();
+   h.size = size;
+   // One write, so that an incremental save switches between the old and
+   // the new payloads at once
+   std::vector<char> block(sizeof(h) + columns.size() * sizeof(checkpoint_column));
+   std::memcpy(block.data(), &h, sizeof(h));
+   std::memcpy(block.data() + sizeof(h), columns.data(), columns.size() * sizeof(checkpoint_column));
+   this->write(block.data(), block.size(), 0);
+}
+
+void checkpoint_file::layout(std::vector<checkpoint_column>& columns)
+{
+   uint64_t offset = align(sizeof(checkpoint_header) + columns.size() * sizeof(checkpoint_column));
+   for(auto& c: columns)
+   {
+      c.offset = offset;
+      offset = align(offset + c.bytes);
+   }
+   if(::ftruncate(_fd, offset) != 0) throw_errno("ftruncate", _path);
+}
+
+void checkpoint_file::relocate(std::vector<checkpoint_column>& columns, const std::vector<size_t>& which,
+   const std::vector<checkpoint_column>& live)
+{
+   // Regions in use, sorted by offset
+   std::vector<std::pair<uint64_t, uint64_t>> used;
+   for(size_t k = 0; k < live.size(); ++k)
+   {
+      if(live[k].bytes) used.emplace_back(live[k].offset, align(live[k].offset + live[k].bytes));
+   }
+   for(size_t k = 0; k < columns.size(); ++k)
+   {
+      if(columns[k].bytes && std::find(which.begin(), which.end(), k) == which.end())
+      {
+         used.emplace_back(columns[k].offset, align(columns[k].offset + columns[k].bytes));
+      }
+   }
+
+   const uint64_t first = align(sizeof(checkpoint_header) + columns.size() * sizeof(checkpoint_column));
+   for(size_t k: which)
+   {
+      std::sort(used.begin(), used.end());
+      // First gap behind the header that fits the column
+      uint64_t offset = first;
+      uint64_t end = align(offset + columns[k].bytes);
+      for(const auto& u: used)
+      {
+         if(u.first >= end) break;
+         offset = std::max(offset, u.second);
+         end = align(offset + columns[k].bytes);
+      }
+      columns[k].offset = offset;
+      if(columns[k].bytes) used.emplace_back(offset, end);
+   }
+}
+
+void checkpoint_file::trim(const std::vector<checkpoint_column>& columns)
+{
+   uint64_t end = align(sizeof(checkpoint_header) + columns.size() * sizeof(checkpoint_column));
+   for(const auto& c: columns) end = std::max(end, align(c.offset + c.bytes));
+   if(::ftruncate(_fd, end) != 0) throw_errno("ftruncate", _path);
+}
+
+void checkpoint_file::write(const void* data, size_t bytes, uint64_t offset)
+{
+   const char* p = static_cast<const char*>(data);
+   while(bytes > 0)
+   {
+      ssize_t n = ::pwrite(_fd, p, bytes, offset);
+      if(n < 0)
+      {
+         if(errno == EINTR) continue;
+         throw_errno("write", _path);
+      }
+      p += n;
+      bytes -= n;
+      offset += n;
+   }
+}
+
+void checkpoint_file::read(void* data, size_t bytes, uint64_t offset)
+{
+   char* p = static_cast<char*>(data);
+   while(bytes > 0)
+   {
+      ssize_t n = ::pread(_fd, p, bytes, offset);
+      if(n < 0)
+      {
+         if(errno == EINTR) continue;
+         throw_errno("read", _path);
+      }
+      if(n == 0)
+      {
+         errno = EIO;
+         throw_errno("unexpected end of file", _path);
+      }
+      p += n;
+      bytes -= n;
+      offset += n;
+   }
+}
+
+void checkpoint_file::sync()
+{
+   if(::fdatasync(_fd) != 0) throw_errno("sync", _path);
+}
+
+void checkpoint_file::replace(const std::string& path)
+{
+   if(std::rename(_path.c_str(), path.c_str()) != 0) throw_errno("rename", _path);
+   _path = path;
+}
+
+} // namespace detail
+} // namespace xlib
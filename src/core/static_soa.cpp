@@ -0,0 +1,201 @@
+#include "xlib/core/static_soa.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <new>
+
+#include <sys/mman.h>
+
+namespace xlib
+{
+namespace detail
+{
+
+namespace
+{
+
+/** Slabs of at least this size are mapped and aligned to it so that the
+ * kernel can back them with transparent huge pages
+ */
+constexpr size_t huge_page_size = size_t(2) << 20;
+
+} // namespace
+
+void* soa_arena_allocate(size_t bytes)
+{
+   // Small slabs come from the heap, which recycles memory without a system
+   // call per allocation
+   if(bytes < huge_page_size)
+   {
+      return ::operator new(bytes, std::align_val_t(soa_arena_allocator::page_size));
+   }
+
+   size_t mapped = bytes + huge_page_size;
+   void* p = ::mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+   if(p == MAP_FAILED) throw std::bad_alloc();
+
+   // Trim the mapping to a huge page aligned range of bytes
+   char* begin = static_cast<char*>(p);
+   char* slab = reinterpret_cast<char*>((reinterpret_cast<uintptr_t>(begin) + huge_page_size - 1) & ~uintptr_t(huge_page_size - 1));
+   if(slab > begin) ::munmap(begin, slab - begin);
+   size_t tail = (begin + mapped) - (slab + bytes);
+   if(tail) ::munmap(slab + bytes, tail);
+#if defined(MADV_HUGEPAGE)
+   ::madvise(slab, bytes, MADV_HUGEPAGE);
+#endif
+   return slab;
+}
+
+void soa_arena_deallocate(void* slab, size_t bytes) noexcept
+{
+   if(bytes < huge_page_size)
+   {
+      ::operator delete(slab, std::align_val_t(soa_arena_allocator::page_size));
+   }
+   else
+   {
+      ::munmap(slab, bytes);
+   }
+}
+
+void* soa_map_allocate(size_t bytes)
+{
+   void* p = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+   if(p == MAP_FAILED) throw std::bad_alloc();
+   return p;
+}
+
+void* soa_map_reallocate(void* p, size_t old_bytes, size_t new_bytes)
+{
+#if defined(MREMAP_MAYMOVE)
+   void* q = ::mremap(p, old_bytes, new_bytes, MREMAP_MAYMOVE);
+   if(q == MAP_FAILED) throw std::bad_alloc();
+   return q;
+#else
+   void* q = soa_map_allocate(new_bytes);
+   std::memcpy(q, p, std::min(old_bytes, new_bytes));
+   soa_map_deallocate(p, old_bytes);
+   return q;
+#endif
+}
+
+void soa_map_deallocate(void* p, size_t bytes) noexcept
+{
+   ::munmap(p, bytes);
+}
+
+void soa_dirty_tracker::enable(bool enable, size_t n)
+{
+   _enabled = enable;
+   _words = 0;
+   _bits.reset();
+   if(enable) this->resize(n);
+}
+
+void soa_dirty_tracker::resize(size_t n)
+{
+   size_t blocks = (n + _block - 1) / _block;
+   size_t words = (blocks + 63) / 64;
+   if(words <= _words) return;
+
+   // Grow geometrically so that repeated small resizes do not copy every time
+   words = std::max(words, 2 * _words);
+   std::unique_ptr<std::atomic<uint64_t>[]> bits(new std::atomic<uint64_t>[_columns * words]);
+   for(size_t c = 0; c < _columns; ++c)
+   {
+      for(size_t w = 0; w < words; ++w)
+      {
+         uint64_t value = w < _words ? _bits[c * _words + w].load(std::memory_order_relaxed) : 0;
+         bits[c * words + w].store(value, std::memory_order_relaxed);
+      }
+   }
+   _bits = std::move(bits);
+   _words = words;
+}
+
+void soa_dirty_tracker::clear() noexcept
+{
+   for(size_t w = 0; w < _columns * _words; ++w) _bits[w].store(0, std::memory_order_relaxed);
+}
+
+void soa_dirty_tracker::mark(size_t column, size_t begin, size_t end) noexcept
+{
+   if(begin >= end) return;
+   size_t first = begin / _block;
+   size_t last = (end - 1) / _block;
+   assert(column < _columns && last / 64 < _words);
+
+   std::atomic<uint64_t>* bits = &_bits[column * _words];
+   for(size_t w = first / 64; w <= last / 64; ++w)
+   {
+      size_t lo = w == first / 64 ? first % 64 : 0;
+      size_t hi = w == last / 64 ? last % 64 : 63;
+      uint64_t mask = (~uint64_t(0) >> (63 - hi)) & (~uint64_t(0) << lo);
+      // Blocks that are already dirty are only read, so that threads marking
+      // the same blocks do not keep stealing the cache line from each other
+      if((bits[w].load(std::memory_order_relaxed) & mask) != mask)
+      {
+         bits[w].fetch_or(mask, std::memory_order_relaxed);
+      }
+   }
+}
+
+void soa_dirty_tracker::mark_all(size_t begin, size_t end) noexcept
+{
+   for(size_t c = 0; c < _columns; ++c) this->mark(c, begin, end);
+}
+
+std::vector<soa_interval> soa_dirty_tracker::ranges(size_t column, size_t n) const
+{
+   std::vector<soa_interval> ranges;
+   size_t blocks = std::min((n + _block - 1) / _block, 64 * _words);
+   const std::atomic<uint64_t>* bits = &_bits[column * _words];
+
+   size_t b = 0;
+   while(b < blocks)
+   {
+      // Skip to the next dirty block
+      uint64_t word = bits[b / 64].load(std::memory_order_relaxed) >> (b % 64);
+      if(word == 0)
+      {
+         b = (b / 64 + 1) * 64;
+         continue;
+      }
+      b += static_cast<size_t>(__builtin_ctzll(word));
+      if(b >= blocks) break;
+
+      // Extend the range up to the next clean block
+      size_t e = b;
+      while(e < blocks)
+      {
+         uint64_t clean = ~bits[e / 64].load(std::memory_order_relaxed) >> (e % 64);
+         if(clean == 0)
+         {
+            e = (e / 64 + 1) * 64;
+         }
+         else
+         {
+            e += static_cast<size_t>(__builtin_ctzll(clean));
+            break;
+         }
+      }
+      e = std::min(e, blocks);
+      ranges.push_back(soa_interval{b * _block, std::min(e * _block, n)});
+      b = e;
+   }
+   return ranges;
+}
+
+void soa_dirty_tracker::swap(soa_dirty_tracker& other) noexcept
+{
+   std::swap(_columns, other._columns);
+   std::swap(_block, other._block);
+   std::swap(_enabled, other._enabled);
+   std::swap(_words, other._words);
+   std::swap(_bits, other._bits);
+}
+
+} // namespace detail
+} // namespace xlib
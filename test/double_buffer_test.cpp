@@ -0,0 +1,114 @@
+#include <gtest/gtest.h>
+#include <numeric>
+#include <vector>
+
+#include <xlib/core/double_buffer.h>
+
+namespace
+{
+
+// current() holds the id of every element and next() twice the id
+template < class Soa >
+void check_state(Soa& soa)
+{
+   auto& x = soa.template get_data<0>();
+   auto& v = soa.template get_data<1>();
+   const int* id = soa.template get_data<2>();
+   ASSERT_EQ(x.size(), soa.size());
+   ASSERT_EQ(v.current().size(), soa.size());
+   ASSERT_EQ(v.next().size(), soa.size());
+   for(size_t i = 0; i < soa.size(); i++)
+   {
+      ASSERT_EQ(x.current()[i], id[i]) << i;
+      ASSERT_EQ(x.next()[i], 2.0 * id[i]) << i;
+      ASSERT_EQ(v[i], float(id[i])) << i;
+      ASSERT_EQ(v.next()[i], 2.0f * id[i]) << i;
+   }
+}
+
+} // namespace
+
+TEST(double_buffer, swap_buffers)
+{
+   xlib::static_soa<xlib::double_buffer<double*>, double*> soa;
+   soa.set_default<0>(1.0);
+   soa.resize(100);
+   auto& x = soa.get_data<0>();
+   const double* v = soa.get_data<1>();
+   ASSERT_EQ(x.size(), 100u);
+   for(size_t i = 0; i < soa.size(); i++)
+   {
+      ASSERT_EQ(x.current()[i], 1.0);
+      ASSERT_EQ(x.next()[i], 1.0);
+   }
+
+   // Swapping only exchanges the buffers
+   const double* a = x.current();
+   const double* b = x.next();
+   for(int step = 0; step < 3; step++)
+   {
+      for(size_t i = 0; i < soa.size(); i++) x.next()[i] = x.current()[i] + 0.5 * (v[i] + 1.0);
+      x.swap_buffers();
+      std::swap(a, b);
+      EXPECT_EQ(x.current(), a);
+      EXPECT_EQ(x.next(), b);
+   }
+   soa.apply_per_element([](double x, double, size_t) { EXPECT_EQ(x, 2.5); });
+   EXPECT_EQ(soa.sum<0>(), 250.0);
+}
+
+TEST(double_buffer, structural_operations)
+{
+   using state = xlib::static_soa<xlib::double_buffer<double*>, xlib::double_buffer<std::vector<float>>, int*>;
+   state soa;
+   const size_t n = 1000;
+   soa.resize(n);
+   auto set = [n](state& s, size_t begin)
+   {
+      for(size_t i = begin; i < s.size(); i++)
+      {
+         int id = static_cast<int>(2 * n - i);
+         s.get_data<2>()[i] = id;
+         s.get_data<0>().current()[i] = id;
+         s.get_data<0>().next()[i] = 2.0 * id;
+         s.get_data<1>().current()[i] = float(id);
+         s.get_data<1>().next()[i] = 2.0f * id;
+      }
+   };
+   set(soa, 0);
+   check_state(soa);
+
+   soa.reserve(4 * n);
+   EXPECT_GE(soa.get_data<0>().capacity(), 4 * n);
+   EXPECT_GE(soa.get_data<1>().next().capacity(), 4 * n);
+   soa.resize(2 * n);
+   set(soa, n);
+   check_state(soa);
+
+   soa.sort_by<2>();
+   check_state(soa);
+   for(size_t i = 1; i < soa.size(); i++) ASSERT_LE(soa.get_data<2>()[i - 1], soa.get_data<2>()[i]);
+
+   std::vector<size_t> reversed(soa.size());
+   std::iota(reversed.rbegin(), reversed.rend(), size_t(0));
+   soa.reorder(xlib::execution::par, reversed);
+   check_state(soa);
+
+   EXPECT_EQ(soa.erase_if([](double, float, int id, size_t) { return id % 3 == 0; }), 2 * n / 3);
+   check_state(soa);
+   size_t even = 0;
+   for(size_t id = 1; id <= 2 * n; id++) even += id % 2 == 0 && id % 3 != 0;
+   EXPECT_EQ(soa.erase_if(xlib::execution::par, [](double, float, int id, size_t) { return id % 2 == 0; }), even);
+   check_state(soa);
+   soa.erase_if_unordered([](double, float, int id, size_t) { return id % 5 == 0; });
+   check_state(soa);
+   for(size_t i = 0; i < soa.size(); i++)
+   {
+      int id = soa.get_data<2>()[i];
+      ASSERT_TRUE(id % 2 && id % 3 && id % 5) << id;
+   }
+
+   soa.shrink_to_fit();
+   state moved(std::move(soa));
+   check_state(moved);
+}
@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <stdexcept>
+#include <thread>
+
+#include <xlib/core/execution.h>
+
+TEST(execution, parallel_for_covers_range)
+{
+   for(auto policy: {xlib::execution::par.threads(4), xlib::execution::par.threads(4).chunk(7), xlib::execution::par.threads(5).deterministic().chunk(100)})
+   {
+      std::vector<int> hits(10007, 0);
+      xlib::detail::parallel_for(policy, 3, hits.size(), [&hits](size_t begin, size_t end)
+      {
+         for(size_t i = begin; i < end; i++) hits[i]++;
+      });
+      for(size_t i = 0; i < hits.size(); i++)
+      {
+         ASSERT_EQ(hits[i], i < 3 ? 0 : 1);
+      }
+   }
+}
+
+TEST(execution, deterministic_chunks)
+{
+   // Chunk boundaries and the thread running each chunk only depend on the policy
+   auto record = [](size_t num_threads)
+   {
+      std::vector<std::pair<size_t,size_t>> chunks(100);
+      std::vector<std::thread::id> owners(100);
+      xlib::detail::parallel_for(xlib::execution::par.threads(num_threads).deterministic().chunk(10), 0, 1000, [&](size_t begin, size_t end)
+      {
+         chunks[begin / 10] = {begin, end};
+         owners[begin / 10] = std::this_thread::get_id();
+      });
+      for(size_t k = 0; k < chunks.size(); k++)
+      {
+         EXPECT_EQ(chunks[k].first, 10 * k);
+         EXPECT_EQ(chunks[k].second, 10 * k + 10);
+         EXPECT_EQ(owners[k], owners[k % num_threads]);
+      }
+   };
+   record(1);
+   record(4);
+   record(7);
+}
+
+TEST(execution, exceptions_propagate)
+{
+   ASSERT_THROW(
+      xlib::detail::parallel_for(xlib::execution::par.threads(4).chunk(1), 0, 16, [](size_t begin, size_t)
+      {
+         if(begin == 11) throw std::runtime_error("chunk failed");
+      }),
+      std::runtime_error);
+
+   // The pool is still usable after a failed region
+   std::atomic<size_t> count{0};
+   xlib::thread_pool::instance().run(4, [&count](size_t, size_t){ count++; });
+   ASSERT_EQ(count, 4);
+}
+
+TEST(execution, nested_regions_run_serially)
+{
+   std::atomic<size_t> count{0};
+   xlib::thread_pool::instance().run(3, [&count](size_t, size_t)
+   {
+      xlib::thread_pool::instance().run(4, [&count](size_t, size_t){ count++; });
+   });
+   ASSERT_EQ(count, 12);
+}
@@ -0,0 +1,153 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <numeric>
+#include <string>
+#include <cstdio>
+#include <stdexcept>
+#include <system_error>
+
+#include <xlib/core/mapped_column.h>
+
+static std::string temp_file(const char* name)
+{
+   std::string path = ::testing::TempDir() + name;
+   std::remove(path.c_str());
+   return path;
+}
+
+TEST(mapped_column, anonymous)
+{
+   xlib::mapped_column<int> col;
+   ASSERT_EQ(col.size(), 0u);
+   ASSERT_FALSE(col.file_backed());
+   col.resize(100);
+   std::iota(col.begin(), col.end(), 0);
+   col.resize(10);
+   col.resize(5000);
+   for(size_t i = 0; i < col.size(); i++)
+   {
+      ASSERT_EQ(col[i], i < 10 ? int(i) : 0) << i;
+   }
+   ASSERT_EQ(reinterpret_cast<uintptr_t>(col.data()) % xlib::soa_alignment_v<int>, 0u);
+   col.shrink_to_fit();
+   ASSERT_EQ(col.capacity(), col.size());
+}
+
+TEST(mapped_column, restart)
+{
+   std::string path = temp_file("xlib_mapped_column_restart.col");
+   {
+      xlib::mapped_column<double> col(path, xlib::map_mode::create);
+      ASSERT_TRUE(col.file_backed());
+      col.resize(100000);
+      for(size_t i = 0; i < col.size(); i++) col[i] = 0.5 * i;
+      col.sync();
+   }
+   {
+      // Private mapping, writes do not reach the file
+      xlib::mapped_column<double> col(path, xlib::map_mode::copy_on_write);
+      ASSERT_EQ(col.size(), 100000u);
+      ASSERT_EQ(col[99999], 0.5 * 99999);
+      col[0] = -1;
+      col.resize(200000); // appends anonymous memory behind the file
+      ASSERT_FALSE(col.file_backed());
+      ASSERT_EQ(col[0], -1);
+      ASSERT_EQ(col[99999], 0.5 * 99999);
+      ASSERT_EQ(col[199999], 0);
+   }
+   {
+      xlib::mapped_column<double> col(path, xlib::map_mode::open);
+      ASSERT_EQ(col.size(), 100000u);
+      ASSERT_EQ(col[0], 0);
+      col.resize(50);
+      col[1] = 7;
+   }
+   xlib::mapped_column<double> col(path);
+   ASSERT_EQ(col.size(), 50u);
+   ASSERT_EQ(col[1], 7);
+
+   ASSERT_THROW(xlib::mapped_column<float>{path}, std::runtime_error);
+   ASSERT_THROW(xlib::mapped_column<float>{temp_file("xlib_missing.col")}, std::system_error);
+}
+
+static std::vector<char> read_file(const std::string& path)
+{
+   std::vector<char> bytes;
+   FILE* f = std::fopen(path.c_str(), "rb");
+   char buffer[4096];
+   for(size_t n; (n = std::fread(buffer, 1, sizeof(buffer), f)) > 0;) bytes.insert(bytes.end(), buffer, buffer + n);
+   std::fclose(f);
+   return bytes;
+}
+
+TEST(mapped_column, copy_on_write_growth)
+{
+   std::string path = temp_file("xlib_mapped_column_cow.col");
+   {
+      xlib::mapped_column<int> col(path, xlib::map_mode::create);
+      col.resize(10000);
+      std::iota(col.begin(), col.end(), 0);
+   }
+   std::vector<char> original = read_file(path);
+
+   xlib::mapped_column<int> col(path, xlib::map_mode::copy_on_write);
+   col[3] = -3;
+   col.resize(25000);
+   col[20000] = 7;
+   // The second growth moves the file pages and the anonymous tail
+   col.resize(80000);
+   col[70000] = 8;
+   for(size_t i = 0; i < 10000; i++) ASSERT_EQ(col[i], i == 3 ? -3 : int(i)) << i;
+   ASSERT_EQ(col[20000], 7);
+   ASSERT_EQ(col[70000], 8);
+   ASSERT_EQ(col[79999], 0);
+
+   col.resize(5000);
+   col.shrink_to_fit();
+   ASSERT_EQ(col.capacity(), 5000u);
+   col.resize(30000);
+   ASSERT_EQ(col[3], -3);
+   ASSERT_EQ(col[4999], 4999);
+   for(size_t i = 5000; i < col.size(); i++) ASSERT_EQ(col[i], 0) << i;
+
+   ASSERT_EQ(read_file(path), original);
+}
+
+TEST(mapped_column, static_soa)
+{
+   std::string ids = temp_file("xlib_mapped_column_ids.col");
+   std::string mass = temp_file("xlib_mapped_column_mass.col");
+   {
+      xlib::static_soa<xlib::mapped_column<int>, xlib::mapped_column<double>, std::vector<double>> soa;
+      soa.get_data<0>() = xlib::mapped_column<int>(ids, xlib::map_mode::create);
+      soa.get_data<1>() = xlib::mapped_column<double>(mass, xlib::map_mode::create);
+      soa.resize(1000);
+      soa.apply_per_element([](int& id, double& m, double& v, size_t i)
+      {
+         id = static_cast<int>(i);
+         m = 2. * i;
+         v = 3. * i;
+      });
+
+      std::vector<size_t> reversed(soa.size());
+      std::iota(reversed.rbegin(), reversed.rend(), 0);
+      soa.reorder(xlib::execution::par.threads(4), reversed);
+      ASSERT_TRUE(soa.get_data<0>().file_backed());
+      soa.erase_if(xlib::execution::par.threads(4).chunk(10), [](int id, double, double, size_t) { return id % 3 == 0; });
+      ASSERT_TRUE(soa.get_data<1>().file_backed());
+      for(size_t i = 0; i < soa.size(); i++)
+      {
+         int id = soa.get_data<0>()[i];
+         ASSERT_NE(id % 3, 0);
+         ASSERT_EQ(soa.get_data<1>()[i], 2. * id);
+         ASSERT_EQ(soa.get_data<2>()[i], 3. * id);
+      }
+   }
+
+   xlib::static_soa<xlib::mapped_column<int>, xlib::mapped_column<double>> soa;
+   soa.get_data<0>() = xlib::mapped_column<int>(ids, xlib::map_mode::copy_on_write);
+   soa.get_data<1>() = xlib::mapped_column<double>(mass, xlib::map_mode::copy_on_write);
+   ASSERT_EQ(soa.size(), 666u);
+   ASSERT_EQ(soa.get_data<0>()[0], 998);
+   ASSERT_EQ(soa.get_data<1>()[0], 2. * 998);
+}
@@ -0,0 +1,104 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <numeric>
+
+#include <xlib/core/nd_array.h>
+
+using xlib::nd_layout;
+
+template < nd_layout Layout >
+void check_array()
+{
+   xlib::nd_array<double,3,Layout> a({2, 3}, 5);
+   ASSERT_EQ(a.width(), 6u);
+   ASSERT_EQ(a.size(), 5u);
+   for(size_t i = 0; i < a.size(); i++)
+   {
+      for(size_t r = 0; r < 2; r++)
+      {
+         for(size_t c = 0; c < 3; c++) a[i](r, c) = 100 * i + 10 * r + c;
+      }
+   }
+   a.resize(1000); // reallocates, keeps the old elements
+   a.resize(7, std::vector<double>(6, -1.0));
+   a.resize(9, std::vector<double>(6, -2.0));
+   for(size_t i = 0; i < a.size(); i++)
+   {
+      for(size_t j = 0; j < a.width(); j++)
+      {
+         double expected = i < 5 ? 100.0 * i + 10.0 * (j / 3) + j % 3 : i < 7 ? 0.0 : -2.0;
+         ASSERT_EQ(a[i][j], expected) << i << " " << j;
+         ASSERT_EQ(&a[i][j], &a.component(i, j));
+      }
+   }
+   if constexpr(Layout == nd_layout::row_major)
+   {
+      ASSERT_EQ(a[1].stride(), 1u);
+      ASSERT_EQ(a[1].data(), a[0].data() + 6);
+   }
+   else
+   {
+      ASSERT_EQ(a.plane(4) + 1, &a.component(1, 4));
+   }
+
+   xlib::nd_array<double,3,Layout> b(a);
+   b[0].fill(3);
+   b[1] = a[2];
+   ASSERT_EQ(b[1].load(), a[2].load());
+   ASSERT_EQ(b[0].load(), std::vector<double>(6, 3.0));
+   ASSERT_EQ(a[0][5], 12);
+}
+
+TEST(nd_array, row_major)
+{
+   check_array<nd_layout::row_major>();
+}
+
+TEST(nd_array, column_major)
+{
+   check_array<nd_layout::column_major>();
+}
+
+template < nd_layout Layout >
+void check_soa()
+{
+   const size_t species = 5;
+   xlib::static_soa<std::vector<int>, xlib::nd_array<double,2,Layout>> soa;
+   soa.template get_data<1>().set_extents({species});
+   soa.template set_default<1>(std::vector<double>(species, 0.2));
+   soa.resize(1001);
+   ASSERT_EQ(soa.template get_data<1>()[1000].load(), std::vector<double>(species, 0.2));
+   soa.apply_per_element([](int& id, auto y, size_t i)
+   {
+      id = static_cast<int>(i);
+      for(size_t k = 0; k < y.size(); k++) y[k] = i + 0.1 * k;
+   });
+
+   std::vector<size_t> reversed(soa.size());
+   std::iota(reversed.rbegin(), reversed.rend(), 0);
+   soa.reorder(reversed);
+   soa.reorder(xlib::execution::par.threads(4), reversed);
+   soa.reorder(reversed);
+
+   soa.erase_if(xlib::execution::par.threads(4), [](int id, auto, size_t) { return id % 2 == 1; });
+   ASSERT_EQ(soa.size(), 501u);
+   for(size_t i = 0; i < soa.size(); i++)
+   {
+      size_t id = soa.template get_data<0>()[i];
+      ASSERT_EQ(id, 1000 - 2 * i);
+      auto y = soa.template get_data<1>()[i];
+      ASSERT_EQ(y.size(), species);
+      for(size_t k = 0; k < species; k++) ASSERT_DOUBLE_EQ(y[k], id + 0.1 * k);
+   }
+   ASSERT_EQ(soa.template get_data<1>().extent(0), species);
+}
+
+TEST(nd_array, static_soa_row_major)
+{
+   check_soa<nd_layout::row_major>();
+}
+
+TEST(nd_array, static_soa_column_major)
+{
+   check_soa<nd_layout::column_major>();
+}
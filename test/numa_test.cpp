@@ -0,0 +1,46 @@
+#include <gtest/gtest.h>
+#include <vector>
+
+#include <xlib/core/numa.h>
+#include <xlib/core/static_soa.h>
+
+TEST(numa, topology)
+{
+   ASSERT_GE(xlib::numa_node_count(), 1);
+   int node = xlib::numa_current_node();
+   ASSERT_GE(node, 0);
+   ASSERT_LT(size_t(node), xlib::numa_node_count());
+
+   // A touched page is placed on a node, unless the kernel can not tell
+   std::vector<double> data(1024, 1.);
+   int placed = xlib::numa_node_of(data.data());
+   ASSERT_GE(placed, -1);
+   ASSERT_LT(placed, int(xlib::numa_node_count()));
+}
+
+TEST(numa, partitions)
+{
+   xlib::static_soa<double*> soa;
+   soa.resize(xlib::soa_first_touch_policy.threads(3).chunk(1000), 10500);
+   const double* data = soa.get_data<0>();
+
+   auto partitions = xlib::numa_partitions(xlib::soa_first_touch_policy.threads(3).chunk(1000), data, soa.size());
+   ASSERT_EQ(partitions.size(), 11);
+   for(size_t k = 0; k < partitions.size(); ++k)
+   {
+      ASSERT_EQ(partitions[k].begin, k * 1000);
+      ASSERT_EQ(partitions[k].end, std::min<size_t>(10500, (k + 1) * 1000));
+      ASSERT_EQ(partitions[k].thread, k % 3);
+      ASSERT_GE(partitions[k].node, -1);
+   }
+
+   auto dynamic = xlib::numa_partitions(xlib::execution::par.threads(2).chunk(4000), data, soa.size());
+   ASSERT_EQ(dynamic.size(), 3);
+   ASSERT_EQ(dynamic.back().end, 10500);
+   ASSERT_EQ(dynamic.front().thread, xlib::numa_partition::any_thread);
+
+   auto serial = xlib::numa_partitions(xlib::execution::seq, data, soa.size());
+   ASSERT_EQ(serial.size(), 1);
+   ASSERT_EQ(serial[0].thread, 0);
+   ASSERT_TRUE(xlib::numa_partitions(xlib::execution::seq, data, 0).empty());
+}
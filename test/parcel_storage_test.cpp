@@ -0,0 +1,97 @@
+#include <gtest/gtest.h>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <xlib/core/parcel_storage.h>
+#include <xlib/core/vector.h>
+
+XLIB_PARCEL_STORAGE(liquid_parcels,
+   XLIB_PARCEL_DATA(
+      (position, std::vector<xlib::vec<double,3>>),
+      (radius, double*),
+      (cell_index, std::vector<int64_t>),
+      (tags, std::map<int, std::string>*)
+   ),
+   XLIB_MEMBER_DATA(
+      (density, 1000.0, double),
+      (num_species, 3, int),
+      (origin, (xlib::vec<double,3>{1., 2., 3.}), xlib::vec<double,3>)
+   )
+);
+
+XLIB_PARCEL_STORAGE(tracer_parcels,
+   XLIB_PARCEL_DATA(
+      (id, int64_t*)
+   )
+);
+
+TEST(parcel_storage, fields)
+{
+   static_assert(liquid_parcels::num_fields == 4);
+   static_assert(liquid_parcels::num_members == 3);
+   static_assert(static_cast<size_t>(liquid_parcels::field::cell_index) == 2);
+   static_assert(std::is_same_v<liquid_parcels::storage_type,
+      xlib::static_soa<std::vector<xlib::vec<double,3>>, double*, std::vector<int64_t>, std::map<int, std::string>*>>);
+   static_assert(std::is_same_v<decltype(std::declval<liquid_parcels&>().radius(0)), double&>);
+   static_assert(std::is_same_v<decltype(std::declval<const liquid_parcels&>().radius(0)), const double&>);
+   ASSERT_STREQ(liquid_parcels::type_name(), "liquid_parcels");
+   ASSERT_STREQ(liquid_parcels::field_names[0], "position");
+   ASSERT_STREQ(liquid_parcels::field_names[3], "tags");
+
+   liquid_parcels pdata;
+   pdata.resize(10);
+   ASSERT_EQ(pdata.size(), 10);
+   for(size_t i = 0; i < pdata.size(); ++i)
+   {
+      pdata.position(i)[1] = i;
+      pdata.radius(i) = 0.5 * i;
+      pdata.cell_index(i) = i / 3;
+   }
+   pdata.tags(4)[1] = "four";
+
+   // Named accessors refer to the same storage as the indices
+   ASSERT_EQ(&pdata.radius(), &pdata.storage().get_data<1>());
+   ASSERT_EQ(&pdata.get<liquid_parcels::field::cell_index>(), &pdata.storage().get_data<2>());
+   const liquid_parcels& cdata = pdata;
+   ASSERT_EQ(cdata.position(7)[1], 7.);
+   ASSERT_EQ(cdata.radius(6), 3.);
+   ASSERT_EQ(cdata.cell_index().back(), 3);
+   ASSERT_EQ(cdata.tags(4).at(1), "four");
+
+   std::vector<std::string> names;
+   pdata.for_each_field([&](const char* name, auto& column)
+   {
+      names.push_back(name);
+      ASSERT_EQ(xlib::detail::soa_size_of<std::remove_reference_t<decltype(column)>>()(column), 10);
+   });
+   ASSERT_EQ(names, (std::vector<std::string>{"position", "radius", "cell_index", "tags"}));
+
+   tracer_parcels tracers;
+   tracers.resize(3);
+   tracers.id(2) = 42;
+   ASSERT_EQ(tracers.get<tracer_parcels::field::id>()[2], 42);
+   size_t visited = 0;
+   tracers.for_each_member([&](const char*, auto&) { ++visited; });
+   ASSERT_EQ(visited, 0);
+}
+
+TEST(parcel_storage, members)
+{
+   liquid_parcels pdata;
+   ASSERT_EQ(pdata.density, 1000.);
+   ASSERT_EQ(pdata.num_species, 3);
+   ASSERT_EQ(pdata.origin[2], 3.);
+   pdata.num_species = 5;
+
+   std::vector<std::string> names;
+   pdata.for_each_member([&](const char* name, auto& value)
+   {
+      names.push_back(name);
+      if constexpr(std::is_same_v<std::decay_t<decltype(value)>, int>)
+      {
+         ASSERT_EQ(value, 5);
+      }
+   });
+   ASSERT_EQ(names, (std::vector<std::string>{"density", "num_species", "origin"}));
+}
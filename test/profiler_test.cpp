@@ -0,0 +1,134 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <algorithm>
+
+#include <xlib/core/profiler.h>
+#include <xlib/core/static_soa.h>
+
+using xlib::profiler;
+
+static const profiler::region_stats* find(const std::vector<profiler::region_stats>& stats, const std::string& path)
+{
+   auto it = std::find_if(stats.begin(), stats.end(), [&](auto& s) { return s.path == path; });
+   return it == stats.end() ? nullptr : &*it;
+}
+
+static void spin(size_t n)
+{
+   volatile size_t x = 0;
+   for(size_t i = 0; i < n; ++i) x = x + i;
+}
+
+struct profiler_test: ::testing::Test
+{
+   void SetUp() override
+   {
+      profiler::instance().reset();
+      profiler::instance().enable();
+   }
+   void TearDown() override
+   {
+      profiler::instance().disable();
+      profiler::instance().reset();
+   }
+};
+
+TEST_F(profiler_test, nested)
+{
+   for(int i = 0; i < 3; ++i)
+   {
+      XLIB_PROFILE_SCOPE("outer");
+      spin(1000);
+      for(int j = 0; j < 2; ++j)
+      {
+         XLIB_PROFILE_SCOPE("inner");
+         spin(1000);
+      }
+   }
+   auto stats = profiler::instance().stats();
+   ASSERT_EQ(stats.size(), 2);
+
+   auto outer = find(stats, "outer");
+   auto inner = find(stats, "outer/inner");
+   ASSERT_TRUE(outer && inner);
+   EXPECT_EQ(outer->calls, 3);
+   EXPECT_EQ(outer->depth, 0);
+   EXPECT_EQ(inner->calls, 6);
+   EXPECT_EQ(inner->depth, 1);
+   EXPECT_EQ(outer->threads, 1);
+   EXPECT_GT(inner->inclusive, 0);
+   EXPECT_GE(outer->inclusive, inner->inclusive);
+   EXPECT_NEAR(outer->exclusive, outer->inclusive - inner->inclusive, 1e-9);
+   EXPECT_DOUBLE_EQ(inner->exclusive, inner->inclusive);
+}
+
+TEST_F(profiler_test, disabled)
+{
+   profiler::instance().disable();
+   {
+      XLIB_PROFILE_SCOPE("off");
+   }
+   EXPECT_TRUE(profiler::instance().stats().empty());
+}
+
+TEST_F(profiler_test, threads)
+{
+   auto policy = xlib::execution::par.threads(4).chunk(1);
+   xlib::detail::parallel_for(policy, 0, 64, [](size_t begin, size_t end)
+   {
+      XLIB_PROFILE_SCOPE("work");
+      spin(100 * (end - begin));
+   });
+   auto stats = profiler::instance().stats();
+   auto work = find(stats, "work");
+   ASSERT_TRUE(work);
+   EXPECT_EQ(work->calls, 64);
+   EXPECT_GE(work->threads, 1);
+   EXPECT_LE(work->threads, 4);
+   EXPECT_GE(work->imbalance, 1.0);
+}
+
+TEST_F(profiler_test, chrome_trace)
+{
+   profiler::instance().enable(true, 2);
+   for(int i = 0; i < 3; ++i)
+   {
+      XLIB_PROFILE_SCOPE("traced \"region\"");
+   }
+   std::ostringstream os;
+   profiler::instance().write_chrome_trace(os);
+   std::string trace = os.str();
+   EXPECT_NE(trace.find("\"traceEvents\""), std::string::npos);
+   EXPECT_NE(trace.find("traced \\\"region\\\""), std::string::npos);
+   EXPECT_EQ(profiler::local().dropped_events, 1);
+
+   size_t events = 0;
+   for(size_t p = trace.find("\"ph\":\"X\""); p != std::string::npos; p = trace.find("\"ph\":\"X\"", p + 1)) events++;
+   EXPECT_EQ(events, 2);
+}
+
+TEST_F(profiler_test, static_soa)
+{
+   xlib::static_soa<std::vector<double>, std::vector<int>> soa;
+   soa.resize(1000);
+   soa.apply_per_element(xlib::execution::par.threads(2), [](double& d, int& i, size_t index)
+   {
+      d = index;
+      i = -index;
+   });
+   std::vector<size_t> map(soa.size());
+   for(size_t i = 0; i < map.size(); ++i) map[i] = map.size() - 1 - i;
+   soa.reorder(map);
+
+   auto stats = profiler::instance().stats();
+   EXPECT_TRUE(find(stats, "static_soa::resize"));
+   EXPECT_TRUE(find(stats, "static_soa::reorder"));
+   ASSERT_TRUE(find(stats, "static_soa::apply_per_element"));
+   EXPECT_EQ(find(stats, "static_soa::apply_per_element")->calls, 1);
+
+   std::ostringstream os;
+   profiler::instance().report(os);
+   EXPECT_NE(os.str().find("static_soa::reorder"), std::string::npos);
+}
@@ -0,0 +1,129 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <xlib/core/soa_append_buffer.h>
+#include <xlib/core/soa_csr_index.h>
+
+namespace
+{
+
+using parcels = xlib::static_soa<std::vector<double>, int32_t*, std::vector<std::string>>;
+
+} // namespace
+
+TEST(soa_append_buffer, concurrent_injection)
+{
+   const size_t num_threads = 64;
+   const size_t per_thread = 2000;
+
+   parcels soa;
+   soa.resize(10);
+   for(size_t i = 0; i < 10; i++) soa.get_data<1>()[i] = -1;
+
+   xlib::soa_append_buffer<parcels> buffer(soa, num_threads);
+   EXPECT_EQ(buffer.max_stages(), num_threads);
+
+   for(int round = 0; round < 2; round++)
+   {
+      std::vector<std::thread> threads;
+      for(size_t t = 0; t < num_threads; t++)
+      {
+         threads.emplace_back([&buffer, t, per_thread, round]
+         {
+            auto& stage = buffer.acquire();
+            for(size_t j = 0; j < per_thread; j++)
+            {
+               size_t i = stage.append();
+               auto id = static_cast<int32_t>(t * per_thread + j);
+               stage.rows().get_data<0>()[i] = 0.5 * id;
+               stage.rows().get_data<1>()[i] = id;
+               stage.rows().get_data<2>()[i] = std::to_string(round);
+            }
+         });
+      }
+      for(auto& th: threads) th.join();
+      EXPECT_THROW(buffer.acquire(), std::length_error);
+      EXPECT_EQ(buffer.size(), num_threads * per_thread);
+
+      size_t old_size = soa.size();
+      EXPECT_EQ(buffer.commit(xlib::execution::par), old_size);
+      EXPECT_EQ(buffer.size(), 0u);
+      ASSERT_EQ(soa.size(), old_size + num_threads * per_thread);
+
+      // Every row was appended exactly once, each stage as one block in order
+      std::vector<int> seen(num_threads * per_thread, 0);
+      for(size_t i = old_size; i < soa.size(); i++)
+      {
+         int32_t id = soa.get_data<1>()[i];
+         ASSERT_GE(id, 0);
+         ASSERT_LT(size_t(id), seen.size());
+         seen[id]++;
+         ASSERT_EQ(soa.get_data<0>()[i], 0.5 * id) << i;
+         ASSERT_EQ(soa.get_data<2>()[i], std::to_string(round)) << i;
+         if((i - old_size) % per_thread != 0)
+         {
+            ASSERT_EQ(id, soa.get_data<1>()[i - 1] + 1) << i;
+         }
+      }
+      EXPECT_TRUE(std::all_of(seen.begin(), seen.end(), [](int s) { return s == 1; }));
+   }
+   for(size_t i = 0; i < 10; i++) EXPECT_EQ(soa.get_data<1>()[i], -1);
+}
+
+TEST(soa_append_buffer, fixed_stages)
+{
+   using rows = xlib::static_soa<std::vector<double>, int*>;
+   rows soa;
+   xlib::soa_append_buffer<rows> buffer(soa, 3);
+
+   buffer.get_stage(2).push_back(2.0, 20);
+   buffer.get_stage(0).push_back(0.0, 0);
+   buffer.get_stage(0).push_back(1.0, 10);
+   size_t total = 0;
+   buffer.for_each_stage([&](rows& r) { total += r.size(); });
+   EXPECT_EQ(total, 3u);
+
+   EXPECT_EQ(buffer.commit(), 0u);
+   ASSERT_EQ(soa.size(), 3u);
+   for(size_t i = 0; i < 3; i++)
+   {
+      EXPECT_EQ(soa.get_data<0>()[i], double(i));
+      EXPECT_EQ(soa.get_data<1>()[i], int(10 * i));
+   }
+
+   // Empty commits leave the target alone
+   EXPECT_EQ(buffer.commit(xlib::execution::par), 3u);
+   EXPECT_EQ(soa.size(), 3u);
+}
+
+template < class Rows >
+void check_indexed_commit()
+{
+   const size_t num_cells = 8;
+   Rows soa;
+   soa.resize(20);
+   for(size_t i = 0; i < soa.size(); i++) soa.template get_data<0>()[i] = static_cast<int>(i % num_cells);
+   xlib::soa_csr_index<Rows, 0> index(soa, num_cells);
+   xlib::soa_append_buffer<Rows> buffer(soa, 2);
+
+   // Injected parcels land in cell 3, the index sees their keys on commit
+   for(int j = 0; j < 5; j++) buffer.get_stage(j % 2).push_back(3, 1.0 * j);
+   EXPECT_EQ(buffer.commit(), 20u);
+   ASSERT_EQ(soa.size(), 25u);
+   ASSERT_EQ(index.size(), 25u);
+   EXPECT_EQ(index.count(3), 8u);
+   for(size_t c = 0; c < num_cells; c++)
+   {
+      for(size_t i: index[c]) ASSERT_EQ(size_t(soa.template get_data<0>()[i]), c) << i;
+   }
+   EXPECT_EQ(index.update(), 0u);
+}
+
+TEST(soa_append_buffer, indexed_commit)
+{
+   check_indexed_commit<xlib::static_soa<int*, double*>>();
+   check_indexed_commit<xlib::static_soa<std::vector<int>, std::vector<double>>>();
+}
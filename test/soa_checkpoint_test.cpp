@@ -0,0 +1,133 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <stdexcept>
+
+#include <xlib/core/soa_checkpoint.h>
+#include <xlib/core/vec_column.h>
+
+using parcels = xlib::static_soa<std::vector<int64_t>, double*, std::vector<xlib::vec<double,3>>, xlib::vec_column<float,3,8>>;
+
+static std::string temp_file(const char* name)
+{
+   std::string path = ::testing::TempDir() + name;
+   std::remove(path.c_str());
+   return path;
+}
+
+static void fill(parcels& soa, size_t n, double shift)
+{
+   soa.resize(n);
+   soa.apply_per_element([shift](int64_t& id, double& m, xlib::vec<double,3>& x, auto v, size_t i)
+   {
+      id = static_cast<int64_t>(i);
+      m = shift + i;
+      x = xlib::vec<double,3>(i, shift, -1.0 * i);
+      v = xlib::vec<float,3>(1, 2, i);
+   });
+}
+
+static void expect_equal(parcels& a, parcels& b)
+{
+   ASSERT_EQ(a.size(), b.size());
+   for(size_t i = 0; i < a.size(); i++)
+   {
+      ASSERT_EQ(a.get_data<0>()[i], b.get_data<0>()[i]);
+      ASSERT_EQ(a.get_data<1>()[i], b.get_data<1>()[i]);
+      ASSERT_EQ(a.get_data<2>()[i], b.get_data<2>()[i]);
+      ASSERT_EQ(a.get_data<3>()[i].load(), b.get_data<3>()[i].load());
+   }
+}
+
+TEST(soa_checkpoint, save_load)
+{
+   std::string path = temp_file("xlib_checkpoint_save_load.soa");
+   parcels soa;
+   fill(soa, 10007, 0.5);
+   ASSERT_EQ(xlib::save(soa, path), 4u);
+
+   parcels loaded;
+   xlib::load(loaded, path);
+   expect_equal(soa, loaded);
+
+   // Empty data round trips too
+   parcels empty;
+   xlib::save(empty, path);
+   xlib::load(loaded, path);
+   ASSERT_EQ(loaded.size(), 0u);
+}
+
+TEST(soa_checkpoint, incremental)
+{
+   std::string path = temp_file("xlib_checkpoint_incremental.soa");
+   parcels soa;
+   fill(soa, 5000, 0);
+
+   // No previous checkpoint, everything is written
+   ASSERT_EQ(xlib::save(soa, path, xlib::checkpoint_mode::incremental), 4u);
+   ASSERT_EQ(xlib::save(soa, path, xlib::checkpoint_mode::incremental), 0u);
+
+   soa.get_data<1>()[42] = -1;
+   soa.get_data<3>()[4999] = xlib::vec<float,3>(0, 0, 0);
+   ASSERT_EQ(xlib::save(soa, path, xlib::checkpoint_mode::incremental), 2u);
+
+   parcels loaded;
+   xlib::load(loaded, path);
+   expect_equal(soa, loaded);
+
+   // Changed columns go next to the previous payloads, so a save that dies
+   // before its header is written leaves the previous checkpoint readable
+   parcels previous;
+   xlib::load(previous, path);
+   std::vector<char> header(4096);
+   {
+      FILE* f = std::fopen(path.c_str(), "rb");
+      ASSERT_EQ(std::fread(header.data(), 1, header.size(), f), header.size());
+      std::fclose(f);
+   }
+   soa.get_data<2>()[7] = xlib::vec<double,3>(-1, -2, -3);
+   ASSERT_EQ(xlib::save(soa, path, xlib::checkpoint_mode::incremental), 1u);
+   xlib::load(loaded, path);
+   expect_equal(soa, loaded);
+   {
+      FILE* f = std::fopen(path.c_str(), "r+b");
+      ASSERT_EQ(std::fwrite(header.data(), 1, header.size(), f), header.size());
+      std::fclose(f);
+   }
+   xlib::load(loaded, path);
+   expect_equal(previous, loaded);
+
+   // A different size rewrites the whole checkpoint
+   fill(soa, 6000, 1);
+   ASSERT_EQ(xlib::save(soa, path, xlib::checkpoint_mode::incremental), 4u);
+   xlib::load(loaded, path);
+   expect_equal(soa, loaded);
+}
+
+TEST(soa_checkpoint, mismatch)
+{
+   std::string path = temp_file("xlib_checkpoint_mismatch.soa");
+   parcels soa;
+   fill(soa, 100, 0);
+   xlib::save(soa, path);
+
+   xlib::static_soa<std::vector<int64_t>, double*, std::vector<xlib::vec<double,3>>, std::vector<xlib::vec<float,3>>> same_layout;
+   xlib::load(same_layout, path);
+   ASSERT_EQ(same_layout.get_data<3>()[7], (xlib::vec<float,3>(1, 2, 7)));
+
+   xlib::static_soa<std::vector<int64_t>, double*, std::vector<xlib::vec<double,3>>, std::vector<xlib::vec<int,3>>> other_type;
+   ASSERT_THROW(xlib::load(other_type, path), std::runtime_error);
+   xlib::static_soa<std::vector<int64_t>> fewer_columns;
+   ASSERT_THROW(xlib::load(fewer_columns, path), std::runtime_error);
+
+   // Flip a payload byte
+   {
+      std::FILE* f = std::fopen(path.c_str(), "r+b");
+      std::fseek(f, 4096 + 8, SEEK_SET);
+      std::fputc(0x7f, f);
+      std::fclose(f);
+   }
+   parcels corrupted;
+   ASSERT_THROW(xlib::load(corrupted, path), std::runtime_error);
+}
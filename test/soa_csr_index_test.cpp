@@ -0,0 +1,156 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include <xlib/core/soa_csr_index.h>
+
+namespace
+{
+
+using parcels = xlib::static_soa<std::vector<int>, int32_t*>;
+using cell_index = xlib::soa_csr_index<parcels, 1>;
+
+// Compare the index against the cells stored in the container
+void check_index(parcels& soa, const cell_index& index)
+{
+   ASSERT_EQ(index.size(), soa.size());
+   std::vector<int> seen(soa.size(), 0);
+   for(size_t c = 0; c < index.num_keys(); c++)
+   {
+      ASSERT_EQ(index.count(c), index[c].size());
+      for(size_t i: index[c])
+      {
+         ASSERT_LT(i, soa.size());
+         ASSERT_EQ(size_t(soa.get_data<1>()[i]), c) << i;
+         seen[i]++;
+      }
+   }
+   ASSERT_TRUE(std::all_of(seen.begin(), seen.end(), [](int s) { return s == 1; }));
+}
+
+} // namespace
+
+TEST(soa_csr_index, build_and_update)
+{
+   const size_t num_cells = 50;
+   parcels soa;
+   soa.resize(2000);
+   std::mt19937 rng(7);
+   std::uniform_int_distribution<int> cell(0, num_cells - 1);
+   soa.apply_per_element([&](int& id, int32_t& c, size_t i)
+   {
+      id = static_cast<int>(i);
+      c = cell(rng);
+   });
+
+   cell_index index(soa, num_cells);
+   check_index(soa, index);
+   // Ranges list their elements in increasing order after a rebuild
+   for(size_t c = 0; c < num_cells; c++)
+   {
+      ASSERT_TRUE(std::is_sorted(index[c].begin(), index[c].end()));
+   }
+
+   // A few parcels move to arbitrary cells
+   int32_t* cells = soa.get_data<1>();
+   std::vector<size_t> moved;
+   for(size_t i = 0; i < soa.size(); i += 97)
+   {
+      cells[i] = cell(rng);
+      moved.push_back(i);
+   }
+   index.update();
+   check_index(soa, index);
+
+   // Parcels piling up in one cell outgrow its slack and move its range,
+   // eventually the abandoned ranges force a rebuild
+   for(size_t step = 0; step < 100; step++)
+   {
+      for(size_t i = step; i < soa.size(); i += 200) cells[i] = 0;
+      index.update();
+      check_index(soa, index);
+   }
+
+   cells[5] = (cells[5] + 3) % num_cells;
+   cells[1234] = 0;
+   moved = {5, 1234, 5};
+   ASSERT_LE(index.update(moved), 2u);
+   check_index(soa, index);
+   ASSERT_EQ(index.update(), 0u);
+
+   // Every parcel changes cell, which rebuilds the index
+   for(size_t i = 0; i < soa.size(); i++) cells[i] = cell(rng);
+   index.update();
+   check_index(soa, index);
+
+   index.set_num_keys(2 * num_cells);
+   ASSERT_EQ(index.num_keys(), 2 * num_cells);
+   check_index(soa, index);
+}
+
+TEST(soa_csr_index, follows_the_container)
+{
+   const size_t num_cells = 64;
+   parcels soa;
+   soa.set_default<1>(num_cells - 1);
+   soa.resize(300000);
+   soa.apply_per_element(xlib::execution::par.threads(4), [](int& id, int32_t& c, size_t i)
+   {
+      id = static_cast<int>(i);
+      c = static_cast<int32_t>((i * 7919) % num_cells);
+   });
+
+   cell_index index(soa, num_cells, xlib::execution::par.threads(4));
+   check_index(soa, index);
+
+   size_t last_cell = index.count(num_cells - 1);
+   soa.resize(300010);
+   check_index(soa, index);
+   ASSERT_EQ(index.count(num_cells - 1), last_cell + 10);
+   soa.resize(299990);
+   check_index(soa, index);
+   soa.resize(10);
+   check_index(soa, index);
+   soa.resize(300000);
+   check_index(soa, index);
+   soa.apply_per_element([](int& id, int32_t& c, size_t i)
+   {
+      id = static_cast<int>(i);
+      c = static_cast<int32_t>((i * 7919) % num_cells);
+   });
+   index.update();
+   check_index(soa, index);
+
+   std::vector<size_t> reversed(soa.size());
+   std::iota(reversed.rbegin(), reversed.rend(), 0);
+   soa.reorder(xlib::execution::par.threads(4), reversed);
+   check_index(soa, index);
+
+   soa.erase_if(xlib::execution::par.threads(4), [](int id, int32_t, size_t) { return id % 3 == 0; });
+   check_index(soa, index);
+   soa.erase_if_unordered([](int id, int32_t, size_t) { return id % 5 == 0; });
+   check_index(soa, index);
+
+   soa.sort_by<1>(xlib::execution::par.threads(4));
+   check_index(soa, index);
+   // Sorted by cell the ranges in key order are the identity
+   size_t next = 0;
+   for(size_t c = 0; c < num_cells; c++)
+   {
+      for(size_t i: index[c]) ASSERT_EQ(i, next++);
+   }
+   ASSERT_EQ(next, index.size());
+
+   // The index moves along with the container and detaches when it is destroyed
+   parcels moved(std::move(soa));
+   ASSERT_EQ(index.soa(), &moved);
+   moved.resize(moved.size() + 1);
+   check_index(moved, index);
+   {
+      parcels other(std::move(moved));
+      ASSERT_EQ(index.soa(), &other);
+   }
+   ASSERT_EQ(index.soa(), nullptr);
+}
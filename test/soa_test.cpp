@@ -0,0 +1,188 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <numeric>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <functional>
+
+#include <xlib/core/soa.h>
+
+namespace
+{
+// Column that records the order structural operations reach it in
+struct logged_column
+{
+   static std::atomic<int> clock;
+
+   size_t size() const { return values.size(); }
+   void resize(size_t n)
+   {
+      stamp = clock++;
+      if(on_resize) on_resize();
+      values.resize(n);
+   }
+   int& operator[](size_t i) { return values[i]; }
+
+   std::vector<int> values;
+   int stamp = -1;
+   std::function<void()> on_resize;
+};
+std::atomic<int> logged_column::clock{0};
+}
+
+TEST(soa_bucket, register_data)
+{
+   xlib::soa_bucket bucket;
+   bucket.resize(10);
+
+   auto radius = bucket.register_data<std::vector<double>>();
+   auto id = bucket.register_data<int*>();
+   std::vector<float> temperature(3, 300.f);
+   auto temp = bucket.register_data(temperature);
+   auto mass = bucket.register_data(std::vector<double>(10, 2.0));
+
+   ASSERT_EQ(bucket.num_entries(), 4);
+   ASSERT_EQ(radius.data().size(), 10);
+   ASSERT_EQ(xlib::detail::soa_size_of<int*>()(id.data()), 10);
+   ASSERT_EQ(temp.data().size(), 10);
+   ASSERT_EQ(temp.data()[2], 300.f);
+   ASSERT_EQ(mass.data()[9], 2.0);
+
+   std::iota(radius.data().begin(), radius.data().end(), 0.);
+   std::iota(id.data(), id.data() + 10, 0);
+
+   bucket.resize(20);
+   ASSERT_EQ(bucket.size(), 20);
+   ASSERT_EQ(radius.data().size(), 20);
+   ASSERT_EQ(xlib::detail::soa_size_of<int*>()(id.data()), 20);
+   for(int i = 0; i < 10; i++)
+   {
+      ASSERT_EQ(radius.data()[i], i);
+      ASSERT_EQ(id.data()[i], i);
+   }
+
+   // Type erased access
+   xlib::soa_bucket::handle h = radius;
+   ASSERT_TRUE(h.is<std::vector<double>>());
+   ASSERT_FALSE(h.is<std::vector<float>>());
+   ASSERT_EQ(&bucket.get_data<std::vector<double>>(h), &radius.data());
+   ASSERT_EQ(&bucket.get_data(radius), &radius.data());
+   ASSERT_EQ(bucket.get_entry<std::vector<double>>(h), radius.entry());
+   ASSERT_EQ(h.entry()->size(), 20);
+   ASSERT_EQ(h.entry()->index(), 0);
+   ASSERT_EQ(h.entry()->parent(), &bucket);
+
+#ifndef NDEBUG
+   ASSERT_DEATH(h.data<std::vector<float>>(), "");
+#endif
+}
+
+TEST(soa_bucket, concurrent_registration)
+{
+   xlib::soa_bucket bucket;
+   bucket.resize(100);
+   auto base = bucket.register_data<std::vector<double>>();
+   std::fill(base.data().begin(), base.data().end(), 1.0);
+
+   // Readers never lock, registration from other threads must not disturb them
+   std::vector<std::thread> threads;
+   std::vector<xlib::soa_bucket::meta_handle<std::vector<int>>> registered(8);
+   for(size_t t = 0; t < registered.size(); t++)
+   {
+      threads.emplace_back([&, t]
+      {
+         registered[t] = bucket.register_data<std::vector<int>>();
+         registered[t].data()[0] = t;
+         double sum = 0;
+         for(int r = 0; r < 100; r++)
+         {
+            for(double v: base.data()) sum += v;
+         }
+         EXPECT_EQ(sum, 100 * 100.0);
+      });
+   }
+   for(auto& t: threads) t.join();
+
+   ASSERT_EQ(bucket.num_entries(), registered.size() + 1);
+   for(size_t t = 0; t < registered.size(); t++)
+   {
+      ASSERT_EQ(registered[t].data().size(), 100);
+      ASSERT_EQ(registered[t].data()[0], t);
+   }
+}
+
+TEST(soa_bucket, diamond_dependencies)
+{
+   // Diamond: b and c depend on a, d depends on both b and c
+   //   a --> b --> d
+   //   a --> c --> d
+   xlib::soa_bucket bucket;
+   auto d = bucket.register_data(logged_column{});
+   auto b = bucket.register_data(logged_column{});
+   auto c = bucket.register_data(logged_column{});
+   auto a = bucket.register_data(logged_column{});
+   auto other = bucket.register_data<std::vector<int>>();
+   bucket.add_data_dependency(b, a);
+   bucket.add_data_dependency(c, a);
+   bucket.add_data_dependency(d, b);
+   bucket.add_data_dependency(d, c);
+   bucket.add_data_dependency(d, c);
+
+   ASSERT_THROW(bucket.add_data_dependency(a, d), std::invalid_argument);
+   ASSERT_THROW(bucket.add_data_dependency(a, a), std::invalid_argument);
+
+   auto check_order = [&]
+   {
+      ASSERT_LT(a.data().stamp, b.data().stamp);
+      ASSERT_LT(a.data().stamp, c.data().stamp);
+      ASSERT_LT(b.data().stamp, d.data().stamp);
+      ASSERT_LT(c.data().stamp, d.data().stamp);
+   };
+
+   bucket.resize(xlib::execution::seq, 10);
+   check_order();
+
+   // b and c do not depend on each other, so they are resized concurrently
+   std::atomic<bool> b_running{false}, c_running{false};
+   auto wait_for = [](std::atomic<bool>& flag)
+   {
+      auto start = std::chrono::steady_clock::now();
+      while(!flag && std::chrono::steady_clock::now() - start < std::chrono::seconds(5))
+      {
+         std::this_thread::yield();
+      }
+      return flag.load();
+   };
+   bool overlapped_b = false, overlapped_c = false;
+   b.data().on_resize = [&]{ b_running = true; overlapped_b = wait_for(c_running); };
+   c.data().on_resize = [&]{ c_running = true; overlapped_c = wait_for(b_running); };
+   bucket.resize(xlib::execution::par.threads(4), 100);
+   check_order();
+   ASSERT_TRUE(overlapped_b);
+   ASSERT_TRUE(overlapped_c);
+   b.data().on_resize = nullptr;
+   c.data().on_resize = nullptr;
+
+   ASSERT_EQ(a.data().values.size(), 100);
+   ASSERT_EQ(d.data().values.size(), 100);
+   ASSERT_EQ(other.data().size(), 100);
+
+   // Reorder reaches every entry
+   for(int i = 0; i < 100; i++)
+   {
+      a.data()[i] = b.data()[i] = c.data()[i] = d.data()[i] = other.data()[i] = i;
+   }
+   std::vector<size_t> reverse(100);
+   for(size_t i = 0; i < 100; i++) reverse[i] = 99 - i;
+   bucket.reorder(reverse);
+   for(int i = 0; i < 100; i++)
+   {
+      ASSERT_EQ(a.data()[i], 99 - i);
+      ASSERT_EQ(b.data()[i], 99 - i);
+      ASSERT_EQ(c.data()[i], 99 - i);
+      ASSERT_EQ(d.data()[i], 99 - i);
+      ASSERT_EQ(other.data()[i], 99 - i);
+   }
+}
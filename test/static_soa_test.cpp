@@ -2,6 +2,8 @@
 #include <vector>
 #include <algorithm>
 #include <numeric>
+#include <atomic>
+#include <string>
 
 #include <xlib/xlib.h>
 
@@ -72,6 +74,48 @@ TEST(static_soa, handles)
    }
 
 }
+TEST(static_soa, handle_is_trivial)
+{
+   using TestBucket = xlib::static_soa<char*, std::vector<double>, int*, char*, long double*>;
+   static_assert(std::is_trivially_copyable<TestBucket::handle>::value, "handle must be trivially copyable");
+   static_assert(sizeof(TestBucket::handle) <= 2 * sizeof(void*), "handle must stay small");
+
+   TestBucket bucket;
+   std::vector<TestBucket::handle> registry(1000);
+   for(size_t i = 0; i < registry.size(); i++)
+   {
+      registry[i] = i % 2 ? TestBucket::handle(bucket.get_handle<1>()) : TestBucket::handle(bucket.get_handle<4>());
+   }
+
+   bucket.resize(10);
+   bucket.get_data<1>()[3] = 3.;
+   bucket.get_data<4>()[3] = 4.;
+   for(size_t i = 0; i < registry.size(); i++)
+   {
+      const auto& h = registry[i];
+      ASSERT_EQ(h.parent(), &bucket);
+      if(i % 2)
+      {
+         ASSERT_EQ(h.index(), 1);
+         ASSERT_TRUE(h.is<std::vector<double>>());
+         ASSERT_FALSE(h.is<long double*>());
+         ASSERT_EQ(h.data<std::vector<double>>()[3], 3.);
+         ASSERT_EQ(&bucket.get_data<std::vector<double>>(h), &bucket.get_data<1>());
+      }
+      else
+      {
+         ASSERT_EQ(h.index(), 4);
+         ASSERT_TRUE(h.is<long double*>());
+         ASSERT_EQ(h.data<long double*>()[3], 4.);
+      }
+   }
+   ASSERT_FALSE(TestBucket::handle().is<char*>());
+
+#ifndef NDEBUG
+   ASSERT_DEATH(registry[0].data<int*>(), "");
+#endif
+}
+
 TEST(static_soa, main)
 {
    xlib::static_soa<char*, std::vector<double>, int*, char*, long double*> bucket;
@@ -100,9 +144,20 @@ TEST(static_soa, main)
          ASSERT_EQ(ldvec[i], i);
       }
    }
-   bucket.reorder(std::vector<int>{9,8,76,5,4,3,2,1,0});
-   bucket.reorder(std::vector<size_t>{9,8,76,5,4,3,2,1,0});
-   bucket.reorder(std::vector<long>{9,8,76,5,4,3,2,1,0});
+   bucket.reorder(std::vector<int>{9,8,7,6,5,4,3,2,1,0});
+   {
+      auto& dvec = bucket.get_data<0>();
+      auto& ivec = bucket.get_data<1>();
+      auto& ldvec = bucket.get_data<3>();
+      for(int i = 0; i < size; i++)
+      {
+         ASSERT_EQ(ivec[i], 9 - i);
+         ASSERT_EQ(dvec[i], 9 - i);
+         ASSERT_EQ(ldvec[i], 9 - i);
+      }
+   }
+   bucket.reorder(std::vector<size_t>{9,8,7,6,5,4,3,2,1,0});
+   bucket.reorder(std::vector<long>{0,1,2,3,4,5,6,7,8,9});
    bucket.resize(size = 20);
    ASSERT_EQ(bucket.size(), size);
    {
@@ -170,3 +225,677 @@ TEST(static_soa, main)
       }
    }
 }
+
+TEST(static_soa, aligned_columns)
+{
+   using TestBucket = xlib::static_soa<char*, std::vector<double>, int*, char*, long double*>;
+   TestBucket bucket;
+
+   for(size_t n: {1, 3, 17, 100, 1000})
+   {
+      bucket.resize(n);
+      ASSERT_EQ(reinterpret_cast<uintptr_t>(bucket.get_data<0>()) % xlib::soa_alignment_v<char>, 0);
+      ASSERT_EQ(reinterpret_cast<uintptr_t>(bucket.get_data<2>()) % xlib::soa_alignment_v<int>, 0);
+      ASSERT_EQ(reinterpret_cast<uintptr_t>(bucket.get_data<3>()) % xlib::soa_alignment_v<char>, 0);
+      ASSERT_EQ(reinterpret_cast<uintptr_t>(bucket.get_data<4>()) % xlib::soa_alignment_v<long double>, 0);
+   }
+}
+
+TEST(static_soa, geometric_growth)
+{
+   xlib::static_soa<int*, long double*> bucket;
+
+   size_t reallocations = 0;
+   int* last = nullptr;
+   for(size_t n = 0; n < 100000; n += 300)
+   {
+      bucket.resize(n);
+      auto& ivec = bucket.get_data<0>();
+      if(ivec != last) reallocations++;
+      last = ivec;
+      ASSERT_GE(bucket.capacity(), n);
+      if(n > 0)
+      {
+         ivec[n-1] = n;
+         if(n > 300) ASSERT_EQ(ivec[n-301], n-300);
+      }
+   }
+   ASSERT_LT(reallocations, 20);
+}
+
+TEST(static_soa, reserve)
+{
+   xlib::static_soa<char*, std::vector<double>, int*> bucket;
+
+   bucket.reserve(1000);
+   ASSERT_EQ(bucket.size(), 0);
+   ASSERT_GE(bucket.capacity(), 1000);
+   ASSERT_GE(bucket.get_data<1>().capacity(), 1000);
+
+   bucket.resize(10);
+   auto* ivec = bucket.get_data<2>();
+   std::iota(ivec, ivec + 10, 0);
+   bucket.resize(1000);
+   ASSERT_EQ(ivec, bucket.get_data<2>());
+
+   bucket.resize(10);
+   bucket.shrink_to_fit();
+   ASSERT_EQ(bucket.size(), 10);
+   ASSERT_EQ(bucket.capacity(), 10);
+   ivec = bucket.get_data<2>();
+   for(int i = 0; i < 10; i++)
+   {
+      ASSERT_EQ(ivec[i], i);
+   }
+}
+
+TEST(static_soa, parallel_apply_per_element)
+{
+   using TestBucket = xlib::static_soa<char*, std::vector<double>, int*, char*, long double*>;
+   TestBucket bucket;
+   bucket.resize(100000);
+
+   auto kernel = [](char& c, double& d, int& i, char& c2, long double& ld, size_t index, int scale)
+   {
+      c = index % 64;
+      d = 0.5 * index;
+      i = scale * index;
+      c2 = c * 2;
+      ld = d + 1;
+   };
+   auto check = [&bucket](int scale)
+   {
+      for(size_t index = 0; index < bucket.size(); index++)
+      {
+         ASSERT_EQ(bucket.get_data<0>()[index], index % 64);
+         ASSERT_EQ(bucket.get_data<1>()[index], 0.5 * index);
+         ASSERT_EQ(bucket.get_data<2>()[index], scale * index);
+         ASSERT_EQ(bucket.get_data<3>()[index], 2 * (index % 64));
+         ASSERT_EQ(bucket.get_data<4>()[index], 0.5 * index + 1);
+      }
+   };
+
+   bucket.apply_per_element(xlib::execution::seq, kernel, 1);
+   check(1);
+   bucket.apply_per_element(xlib::execution::par.threads(4), kernel, 2);
+   check(2);
+   bucket.apply_per_element(xlib::execution::par_unseq.threads(4).chunk(1000), kernel, 3);
+   check(3);
+   bucket.apply_per_element(xlib::execution::par.threads(3).deterministic(), kernel, 4);
+   check(4);
+}
+
+TEST(static_soa, apply_blocked)
+{
+   xlib::static_soa<std::vector<double>, double*, int*> bucket;
+   bucket.resize(10000);
+   std::iota(bucket.get_data<0>().begin(), bucket.get_data<0>().end(), 0.);
+   std::fill(bucket.get_data<1>(), bucket.get_data<1>() + bucket.size(), 2.);
+
+   std::vector<int> blocks;
+   bucket.apply_blocked<512>([&blocks](size_t begin, size_t n, double* XLIB_RESTRICT pos, const double* XLIB_RESTRICT vel, int* XLIB_RESTRICT id, double dt)
+   {
+      blocks.push_back(n);
+      for(size_t i = 0; i < n; i++)
+      {
+         pos[i] += dt * vel[i];
+         id[i] = begin + i;
+      }
+   }, 0.5);
+
+   ASSERT_EQ(blocks.size(), 20);
+   ASSERT_EQ(blocks.back(), 10000 - 19 * 512);
+   for(size_t i = 0; i < bucket.size(); i++)
+   {
+      ASSERT_EQ(bucket.get_data<0>()[i], i + 1.);
+      ASSERT_EQ(bucket.get_data<2>()[i], i);
+   }
+
+   std::atomic<size_t> visited{0};
+   bucket.apply_blocked<64>(xlib::execution::par.threads(4).chunk(100), [&visited](size_t begin, size_t n, double* pos, double* vel, int* id, double dt)
+   {
+      ASSERT_EQ(begin % 64, 0);
+      ASSERT_LE(n, 64);
+      visited += n;
+      for(size_t i = 0; i < n; i++)
+      {
+         pos[i] -= dt * vel[i];
+         ASSERT_EQ(id[i], begin + i);
+      }
+   }, 0.5);
+
+   ASSERT_EQ(visited, bucket.size());
+   for(size_t i = 0; i < bucket.size(); i++)
+   {
+      ASSERT_EQ(bucket.get_data<0>()[i], i);
+   }
+}
+
+TEST(static_soa, reorder)
+{
+   xlib::static_soa<std::vector<double>, int*, long double*, std::vector<std::string>> bucket;
+
+   const size_t n = 50000;
+   bucket.resize(n);
+   for(size_t i = 0; i < n; i++)
+   {
+      bucket.get_data<0>()[i] = i;
+      bucket.get_data<1>()[i] = i;
+      bucket.get_data<2>()[i] = i;
+      bucket.get_data<3>()[i] = std::to_string(i);
+   }
+
+   // Random permutation with cycles of many different lengths
+   std::vector<size_t> new_index(n);
+   std::iota(new_index.begin(), new_index.end(), 0);
+   uint64_t state = 12345;
+   for(size_t i = n - 1; i > 0; i--)
+   {
+      state = state * 6364136223846793005ull + 1442695040888963407ull;
+      std::swap(new_index[i], new_index[(state >> 33) % (i + 1)]);
+   }
+
+   auto check = [&bucket, n](auto&& origin)
+   {
+      for(size_t i = 0; i < n; i++)
+      {
+         size_t o = origin(i);
+         ASSERT_EQ(bucket.get_data<0>()[i], o);
+         ASSERT_EQ(bucket.get_data<1>()[i], o);
+         ASSERT_EQ(bucket.get_data<2>()[i], o);
+         ASSERT_EQ(bucket.get_data<3>()[i], std::to_string(o));
+      }
+   };
+
+   std::vector<size_t> inverse(n);
+   for(size_t i = 0; i < n; i++) inverse[new_index[i]] = i;
+
+   bucket.reorder(new_index);
+   check([&inverse](size_t i){ return inverse[i]; });
+
+   // Moving back in parallel restores the original order
+   bucket.reorder(xlib::execution::par.threads(4), inverse);
+   check([](size_t i){ return i; });
+
+   bucket.reorder(xlib::execution::par_unseq.threads(3).deterministic().chunk(1000), new_index);
+   check([&inverse](size_t i){ return inverse[i]; });
+
+   bucket.reorder(xlib::execution::seq, inverse);
+   check([](size_t i){ return i; });
+}
+
+TEST(static_soa, sort_by)
+{
+   using ParcelBucket = xlib::static_soa<std::vector<int64_t>, double*, std::vector<int>, int16_t*, std::vector<double>>;
+
+   for(size_t n: {0, 1, 1000, 200000})
+   {
+      ParcelBucket bucket;
+      bucket.resize(n);
+      uint64_t state = n;
+      for(size_t i = 0; i < n; i++)
+      {
+         state = state * 6364136223846793005ull + 1442695040888963407ull;
+         bucket.get_data<0>()[i] = static_cast<int64_t>((state >> 40) % 5000) - 2500;
+         bucket.get_data<1>()[i] = i;
+         bucket.get_data<2>()[i] = (state >> 20) % 300000;
+         bucket.get_data<3>()[i] = static_cast<int16_t>(state >> 48);
+         bucket.get_data<4>()[i] = (state >> 30) % 1000 * 0.25;
+      }
+
+      auto check_sorted = [&bucket, n](auto&& keys, auto&& tie_check)
+      {
+         for(size_t i = 1; i < n; i++)
+         {
+            ASSERT_LE(keys[i-1], keys[i]);
+            if(keys[i-1] == keys[i]) tie_check(i);
+         }
+      };
+      auto stable = [&bucket](size_t i){ ASSERT_LT(bucket.get_data<1>()[i-1], bucket.get_data<1>()[i]); };
+      auto any = [](size_t){};
+
+      auto reference = bucket.get_data<0>();
+      std::sort(reference.begin(), reference.end());
+
+      bucket.sort_by<0>();
+      ASSERT_EQ(bucket.get_data<0>(), reference);
+      check_sorted(bucket.get_data<0>(), stable);
+
+      bucket.stable_sort_by<3>(xlib::execution::par.threads(4));
+      check_sorted(bucket.get_data<3>(), any);
+
+      bucket.sort_by<2>(xlib::execution::par.threads(3));
+      check_sorted(bucket.get_data<2>(), any);
+
+      bucket.stable_sort_by<4>();
+      check_sorted(bucket.get_data<4>(), any);
+
+      // Every column moved with its key
+      bucket.stable_sort_by<1>(xlib::execution::par.threads(4));
+      std::vector<int64_t> keys(bucket.get_data<0>());
+      std::sort(keys.begin(), keys.end());
+      ASSERT_EQ(keys, reference);
+      for(size_t i = 0; i < n; i++)
+      {
+         ASSERT_EQ(bucket.get_data<1>()[i], i);
+      }
+
+      // Stable radix sort keeps the insertion order of equal keys
+      bucket.stable_sort_by<0>(xlib::execution::par.threads(4));
+      check_sorted(bucket.get_data<0>(), stable);
+   }
+}
+
+TEST(static_soa, erase_if)
+{
+   using ParcelBucket = xlib::static_soa<std::vector<double>, int*, std::string*, std::vector<std::string>>;
+
+   auto fill = [](ParcelBucket& bucket, size_t n)
+   {
+      bucket.resize(n);
+      for(size_t i = 0; i < n; i++)
+      {
+         bucket.get_data<0>()[i] = i;
+         bucket.get_data<1>()[i] = i;
+         bucket.get_data<2>()[i] = std::to_string(i);
+         bucket.get_data<3>()[i] = std::to_string(2 * i);
+      }
+   };
+   auto check = [](ParcelBucket& bucket, size_t i, size_t origin)
+   {
+      ASSERT_EQ(bucket.get_data<0>()[i], origin);
+      ASSERT_EQ(bucket.get_data<1>()[i], origin);
+      ASSERT_EQ(bucket.get_data<2>()[i], std::to_string(origin));
+      ASSERT_EQ(bucket.get_data<3>()[i], std::to_string(2 * origin));
+   };
+   // Remove every element whose index is divisible by 3 or 7
+   auto evaporated = [](double& d, int&, std::string&, std::string&, size_t index)
+   {
+      return index % 3 == 0 || static_cast<size_t>(d) % 7 == 0;
+   };
+
+   const size_t n = 100000;
+   std::vector<size_t> expected;
+   for(size_t i = 0; i < n; i++)
+   {
+      if(i % 3 != 0 && i % 7 != 0) expected.push_back(i);
+   }
+
+   {
+      ParcelBucket bucket;
+      fill(bucket, n);
+      ASSERT_EQ(bucket.erase_if(evaporated), n - expected.size());
+      ASSERT_EQ(bucket.size(), expected.size());
+      for(size_t i = 0; i < expected.size(); i++) check(bucket, i, expected[i]);
+      ASSERT_EQ(bucket.erase_if([](double& d, auto&&...){ return static_cast<size_t>(d) % 3 == 0; }), 0);
+   }
+
+   for(auto policy: {xlib::execution::par.threads(4), xlib::execution::par.threads(3).chunk(1000).deterministic()})
+   {
+      ParcelBucket bucket;
+      fill(bucket, n);
+      ASSERT_EQ(bucket.erase_if(policy, evaporated), n - expected.size());
+      ASSERT_EQ(bucket.size(), expected.size());
+      for(size_t i = 0; i < expected.size(); i++) check(bucket, i, expected[i]);
+   }
+
+   {
+      ParcelBucket bucket;
+      fill(bucket, n);
+      ASSERT_EQ(bucket.erase_if_unordered(evaporated), n - expected.size());
+      ASSERT_EQ(bucket.size(), expected.size());
+      std::vector<size_t> remaining;
+      for(size_t i = 0; i < bucket.size(); i++)
+      {
+         size_t origin = bucket.get_data<1>()[i];
+         check(bucket, i, origin);
+         remaining.push_back(origin);
+      }
+      std::sort(remaining.begin(), remaining.end());
+      ASSERT_EQ(remaining, expected);
+   }
+
+   {
+      ParcelBucket bucket;
+      fill(bucket, 100);
+      ASSERT_EQ(bucket.erase_if(xlib::execution::par.threads(2), [](auto&&...){ return true; }), 100);
+      ASSERT_EQ(bucket.size(), 0);
+      fill(bucket, 100);
+      ASSERT_EQ(bucket.erase_if_unordered([](auto&&...){ return true; }), 100);
+      ASSERT_EQ(bucket.size(), 0);
+   }
+}
+
+TEST(static_soa, arena)
+{
+   using arena_soa = xlib::arena_static_soa<double*, int*, std::vector<float>, char*, std::string*>;
+   arena_soa soa;
+   ASSERT_EQ(soa.get_allocator().data(), nullptr);
+
+   auto fill = [](double& d, int& i, float& f, char& c, std::string& s, size_t index)
+   {
+      d = index; i = -index; f = 0.5f * index; c = index & 0x7f; s = std::to_string(index);
+   };
+   auto check = [](arena_soa& soa, auto&& expected_index)
+   {
+      for(size_t k = 0; k < soa.size(); ++k)
+      {
+         size_t index = expected_index(k);
+         ASSERT_EQ(soa.get_data<0>()[k], index);
+         ASSERT_EQ(soa.get_data<1>()[k], -int(index));
+         ASSERT_EQ(soa.get_data<2>()[k], 0.5f * index);
+         ASSERT_EQ(soa.get_data<3>()[k], char(index & 0x7f));
+         ASSERT_EQ(soa.get_data<4>()[k], std::to_string(index));
+      }
+   };
+
+   soa.resize(1000);
+   soa.apply_per_element(fill);
+
+   // One slab holding every raw pointer column, aligned and staggered in the page
+   auto columns_in_slab = [](arena_soa& soa)
+   {
+      const char* slab = static_cast<const char*>(soa.get_allocator().data());
+      const char* end = slab + soa.get_allocator().bytes();
+      std::vector<const char*> data = {
+         reinterpret_cast<const char*>(soa.get_data<0>()), reinterpret_cast<const char*>(soa.get_data<1>()),
+         reinterpret_cast<const char*>(soa.get_data<3>()), reinterpret_cast<const char*>(soa.get_data<4>())};
+      std::vector<size_t> page_offsets;
+      for(const char* p: data)
+      {
+         ASSERT_GE(p, slab);
+         ASSERT_LE(p, end);
+         ASSERT_EQ(reinterpret_cast<uintptr_t>(p) % XLIB_SOA_ALIGNMENT, 0);
+         page_offsets.push_back(reinterpret_cast<uintptr_t>(p) % xlib::soa_arena_allocator::page_size);
+      }
+      std::sort(page_offsets.begin(), page_offsets.end());
+      ASSERT_EQ(std::unique(page_offsets.begin(), page_offsets.end()), page_offsets.end());
+   };
+   columns_in_slab(soa);
+   ASSERT_EQ(soa.get_allocator().capacity(), soa.capacity());
+
+   // Growing moves every column into a new slab
+   const void* slab = soa.get_allocator().data();
+   soa.resize(100000);
+   ASSERT_NE(soa.get_allocator().data(), slab);
+   columns_in_slab(soa);
+   soa.resize(1000);
+   check(soa, [](size_t k) { return k; });
+
+   soa.reserve(5000);
+   ASSERT_GE(soa.capacity(), 5000);
+   soa.shrink_to_fit();
+   ASSERT_EQ(soa.get_allocator().capacity(), 1000);
+   check(soa, [](size_t k) { return k; });
+
+   // Reorder in place and by scattering into a new slab
+   std::vector<uint32_t> reverse(soa.size());
+   for(size_t i = 0; i < reverse.size(); ++i) reverse[i] = reverse.size() - 1 - i;
+   soa.reorder(reverse);
+   check(soa, [](size_t k) { return 999 - k; });
+   soa.reorder(xlib::execution::par.threads(3), reverse);
+   check(soa, [](size_t k) { return k; });
+   columns_in_slab(soa);
+
+   size_t removed = soa.erase_if(xlib::execution::par.threads(3), [](double, int, float, char, const std::string&, size_t i) { return i % 2 == 1; });
+   ASSERT_EQ(removed, 500);
+   check(soa, [](size_t k) { return 2 * k; });
+
+   arena_soa moved(std::move(soa));
+   ASSERT_EQ(soa.get_allocator().data(), nullptr);
+   ASSERT_EQ(moved.size(), 500);
+   check(moved, [](size_t k) { return 2 * k; });
+
+   moved.resize(0);
+   moved.shrink_to_fit();
+   ASSERT_EQ(moved.get_allocator().data(), nullptr);
+   ASSERT_EQ(moved.get_data<0>(), nullptr);
+}
+
+TEST(static_soa, first_touch)
+{
+   auto run = [](auto soa)
+   {
+      auto policy = xlib::execution::par.threads(3).chunk(100);
+      soa.resize(policy, 1000);
+      ASSERT_EQ(soa.size(), 1000);
+      soa.apply_per_element([](double& d, std::string& s, int& i, size_t index)
+      {
+         ASSERT_EQ(d, 0.);
+         ASSERT_TRUE(s.empty());
+         ASSERT_EQ(i, 0);
+         d = index; s = std::to_string(index); i = index;
+      });
+
+      // Growing moves the old elements in parallel
+      soa.reserve(policy, 4000);
+      ASSERT_GE(soa.capacity(), 4000);
+      soa.resize(policy, 2500);
+
+      // Large enough to first touch with soa_first_touch_policy without asking
+      size_t large = XLIB_SOA_FIRST_TOUCH_BYTES / sizeof(double) + 1000;
+      soa.resize(large);
+      ASSERT_EQ(soa.size(), large);
+      for(size_t k = 0; k < large; ++k)
+      {
+         ASSERT_EQ(soa.template get_data<0>()[k], k < 1000 ? double(k) : 0.) << k;
+         ASSERT_EQ(soa.template get_data<1>()[k], k < 1000 ? std::to_string(k) : std::string()) << k;
+         ASSERT_EQ(soa.template get_data<2>()[k], k < 1000 ? int(k) : 0) << k;
+      }
+      soa.resize(policy, 10);
+      soa.shrink_to_fit();
+      ASSERT_EQ(soa.template get_data<1>()[9], "9");
+   };
+   run(xlib::static_soa<double*, std::string*, std::vector<int>>());
+   run(xlib::arena_static_soa<double*, std::string*, std::vector<int>>());
+}
+
+struct tagged
+{
+   int tag;
+};
+
+template <>
+struct xlib::soa_default_value<tagged>
+{
+   static constexpr tagged value{7};
+};
+
+TEST(static_soa, defaults)
+{
+   auto run = [](auto soa)
+   {
+      ASSERT_EQ(soa.template get_default<0>(), 0.);
+      ASSERT_EQ(soa.template get_default<3>().tag, 7);
+      soa.template set_default<0>(1.5);
+      soa.template set_default<1>(std::string("empty"));
+      soa.template set_default<2>(-1);
+      soa.resize(10);
+      soa.template set_default<0>(2.5);
+      soa.resize(xlib::execution::par.threads(3).chunk(4), 20);
+      for(size_t k = 0; k < soa.size(); ++k)
+      {
+         ASSERT_EQ(soa.template get_data<0>()[k], k < 10 ? 1.5 : 2.5);
+         ASSERT_EQ(soa.template get_data<1>()[k], "empty");
+         ASSERT_EQ(soa.template get_data<2>()[k], -1);
+         ASSERT_EQ(soa.template get_data<3>()[k].tag, 7);
+      }
+
+      // Existing elements keep their values when growing uninitialized
+      soa.template reset_default<0>();
+      ASSERT_EQ(soa.template get_default<0>(), 0.);
+      soa.template get_data<0>()[19] = 19.;
+      soa.resize(1000, xlib::uninitialized);
+      ASSERT_EQ(soa.size(), 1000);
+      ASSERT_EQ(soa.template get_data<0>()[19], 19.);
+      ASSERT_TRUE(soa.template get_data<1>()[999].empty());
+      ASSERT_EQ(soa.template get_data<2>()[999], -1);
+      soa.resize(xlib::execution::par.threads(2), 2000, xlib::uninitialized);
+      ASSERT_EQ(soa.size(), 2000);
+      soa.resize(2100);
+      ASSERT_EQ(soa.template get_data<0>()[2050], 0.);
+
+      auto moved = std::move(soa);
+      ASSERT_EQ(moved.template get_default<1>(), "empty");
+   };
+   run(xlib::static_soa<double*, std::string*, std::vector<int>, tagged*>());
+   run(xlib::arena_static_soa<double*, std::string*, std::vector<int>, tagged*>());
+}
+
+TEST(static_soa, remap)
+{
+   // Large trivially copyable columns are mapped and grow by remapping
+   xlib::static_soa<double*, int*, std::string*> soa;
+   size_t large = 2 * XLIB_SOA_REMAP_BYTES / sizeof(double);
+   soa.resize(large);
+   soa.apply_per_element([](double& d, int& i, std::string& s, size_t index)
+   {
+      d = index; i = -index;
+      if(index % 1000 == 0) s = std::to_string(index);
+   });
+   // Elements below the smallest size so far keep their values
+   size_t kept = large;
+   for(size_t n: {3 * large, large / 2, large / 8, large + 17, size_t(10)})
+   {
+      size_t old_size = soa.size();
+      soa.resize(n);
+      kept = std::min(kept, n);
+      ASSERT_EQ(soa.size(), n);
+      ASSERT_GE(soa.capacity(), n);
+      ASSERT_EQ(reinterpret_cast<uintptr_t>(soa.get_data<0>()) % XLIB_SOA_ALIGNMENT, 0);
+      for(size_t k = 0; k < kept; ++k)
+      {
+         ASSERT_EQ(soa.get_data<0>()[k], double(k)) << k;
+         ASSERT_EQ(soa.get_data<1>()[k], -int(k)) << k;
+      }
+      if(n > old_size)
+      {
+         ASSERT_EQ(soa.get_data<0>()[n - 1], 0.);
+         ASSERT_EQ(soa.get_data<1>()[n - 1], 0);
+      }
+   }
+   ASSERT_EQ(soa.get_data<2>()[0], "0");
+   soa.shrink_to_fit();
+   ASSERT_EQ(soa.capacity(), 10);
+   ASSERT_EQ(soa.get_data<0>()[9], 9.);
+}
+
+TEST(static_soa, dirty_ranges)
+{
+   using ranges = std::vector<std::pair<size_t,size_t>>;
+   auto dirty = [](const std::vector<xlib::soa_interval>& r)
+   {
+      ranges out;
+      for(auto& i: r) out.emplace_back(i.begin, i.end);
+      return out;
+   };
+   constexpr size_t B = XLIB_SOA_DIRTY_BLOCK;
+
+   xlib::static_soa<double*, std::vector<int>> soa;
+   soa.resize(100 * B + 5);
+   // Without tracking everything counts as written
+   ASSERT_EQ(dirty(soa.dirty_ranges<0>()), (ranges{{0, soa.size()}}));
+
+   soa.track_dirty();
+   ASSERT_TRUE(soa.tracks_dirty());
+   ASSERT_TRUE(soa.dirty_ranges<0>().empty());
+
+   // Explicit marks are rounded out to blocks and merged
+   soa.get_data<0>()[3] = 1;
+   soa.mark_dirty<0>(3, 4);
+   soa.mark_dirty<0>(B, 2 * B + 1);
+   soa.mark_dirty<0>(70 * B - 1, 70 * B);
+   ASSERT_EQ(dirty(soa.dirty_ranges<0>()), (ranges{{0, 3 * B}, {69 * B, 70 * B}}));
+   ASSERT_TRUE(soa.dirty_ranges<1>().empty());
+
+   soa.apply_to_element(99 * B + 2, [](double& d, int& i) { d = 1; i = 1; });
+   ASSERT_EQ(dirty(soa.dirty_ranges<1>()), (ranges{{99 * B, 100 * B}}));
+
+   // New elements are written, the last range is clipped to the size
+   soa.resize(200 * B + 7);
+   ASSERT_EQ(dirty(soa.dirty_ranges<1>()), (ranges{{99 * B, 200 * B + 7}}));
+
+   size_t epoch = soa.dirty_epoch();
+   ASSERT_EQ(soa.clear_dirty(), epoch + 1);
+   ASSERT_TRUE(soa.dirty_ranges<0>().empty());
+
+   // Concurrent marks from a parallel loop
+   xlib::detail::parallel_for(xlib::execution::par.threads(4).chunk(B / 2), 0, soa.size(), [&](size_t begin, size_t end)
+   {
+      for(size_t i = begin; i < end; ++i)
+      {
+         if(i % (10 * B) == 0) soa.mark_dirty<1>(i, i + 1);
+      }
+   });
+   ranges expected;
+   for(size_t i = 0; i < soa.size(); i += 10 * B) expected.emplace_back(i, std::min(i + B, soa.size()));
+   ASSERT_EQ(dirty(soa.dirty_ranges<1>()), expected);
+
+   soa.clear_dirty();
+   soa.apply_per_element(xlib::execution::par.threads(2), [](double&, int&, size_t) {});
+   ASSERT_EQ(dirty(soa.dirty_ranges<0>()), (ranges{{0, soa.size()}}));
+
+   soa.clear_dirty();
+   soa.erase_if([](double, int, size_t i) { return i == 5; });
+   ASSERT_EQ(dirty(soa.dirty_ranges<1>()), (ranges{{0, soa.size()}}));
+
+   soa.track_dirty(false);
+   ASSERT_FALSE(soa.tracks_dirty());
+}
+
+TEST(static_soa, reduce)
+{
+   using vec3 = xlib::vec<double,3>;
+   xlib::static_soa<double*, std::vector<int16_t>, std::vector<vec3>> soa;
+   const size_t n = 100003;
+   soa.resize(n);
+   soa.apply_per_element([](double& m, int16_t& c, vec3& v, size_t i)
+   {
+      m = 1.0 / (i + 1);
+      c = static_cast<int16_t>(i % 7) - 3;
+      v = vec3(1, -0.5 * (i % 3), 1e-3 * i);
+   });
+
+   // Small integers accumulate into float
+   auto count_sum = soa.sum<1>();
+   static_assert(std::is_same<decltype(count_sum), float>::value, "int16 sums promote to float");
+   int expected_count = 0;
+   for(size_t i = 0; i < n; ++i) expected_count += static_cast<int>(i % 7) - 3;
+   ASSERT_EQ(count_sum, float(expected_count));
+
+   double mass = soa.sum<0>();
+   double serial = 0;
+   for(size_t i = 0; i < n; ++i) serial += soa.get_data<0>()[i];
+   ASSERT_NEAR(mass, serial, 1e-12 * serial);
+   ASSERT_EQ(soa.reduce<0>([](double a, double b) { return std::max(a, b); }, 0.0), 1.0);
+   ASSERT_EQ(soa.reduce<0>(std::plus<double>(), 10.0), mass + 10.0);
+
+   // Deterministic chunks give the sequenced result for any number of threads
+   for(size_t t: {1, 2, 3, 4})
+   {
+      auto policy = xlib::execution::par.threads(t).deterministic();
+      ASSERT_EQ(soa.sum<0>(policy), mass) << t;
+      ASSERT_NEAR(soa.sum<0>(xlib::execution::par.threads(t)), mass, 1e-12 * mass);
+   }
+
+   // Total momentum and kinetic energy in one pass
+   auto momentum = soa.transform_reduce([](double m, int16_t, const vec3& v, size_t) { return m * v; }, std::plus<>());
+   static_assert(std::is_same<decltype(momentum), vec3>::value, "vec results accumulate as vecs");
+   double energy = soa.transform_reduce(xlib::execution::par.threads(3).deterministic(),
+      [](double m, int16_t, const vec3& v, size_t) { return 0.5 * m * v.dot(v); }, std::plus<>(), 0.0);
+   vec3 expected_momentum(0, 0, 0);
+   double expected_energy = 0;
+   for(size_t i = 0; i < n; ++i)
+   {
+      double m = soa.get_data<0>()[i];
+      const vec3& v = soa.get_data<2>()[i];
+      expected_momentum += m * v;
+      expected_energy += 0.5 * m * v.dot(v);
+   }
+   for(size_t c = 0; c < 3; ++c) ASSERT_NEAR(momentum[c], expected_momentum[c], 1e-12 * std::abs(expected_momentum[0]));
+   ASSERT_NEAR(energy, expected_energy, 1e-12 * expected_energy);
+   ASSERT_EQ(energy, soa.transform_reduce([](double m, int16_t, const vec3& v, size_t) { return 0.5 * m * v.dot(v); }, std::plus<>(), 0.0));
+
+   soa.resize(0);
+   ASSERT_EQ(soa.sum<0>(xlib::execution::par), 0.0);
+}
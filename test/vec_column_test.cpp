@@ -0,0 +1,138 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <numeric>
+
+#include <xlib/core/vec_column.h>
+
+using xlib::vec;
+
+template < class Column >
+void check_layout()
+{
+   using vec3 = vec<double,3>;
+   Column col;
+   col.resize(37);
+   for(size_t i = 0; i < col.size(); i++)
+   {
+      col[i] = vec3(i, 2 * i, 3 * i);
+   }
+   col.resize(1000); // reallocates, keeps the old elements
+   col.resize(50);
+   for(size_t i = 0; i < col.size(); i++)
+   {
+      vec3 expected = i < 37 ? vec3(i, 2 * i, 3 * i) : vec3(0, 0, 0);
+      ASSERT_EQ(col[i].load(), expected) << i;
+      // Components are unit stride within a run
+      size_t run = std::min(col.run_length(i), col.size() - i);
+      for(size_t c = 0; c < 3; c++)
+      {
+         ASSERT_EQ(&col.component(i, c) + run - 1, &col.component(i + run - 1, c));
+      }
+   }
+
+   Column copy = col;
+   copy[3] += vec3(1, 1, 1);
+   ASSERT_EQ(copy[3].load(), vec3(4, 7, 10));
+   ASSERT_EQ(col[3].load(), vec3(3, 6, 9));
+   copy[4] = col[5];
+   ASSERT_EQ(copy[4].load(), vec3(5, 10, 15));
+
+   copy.shrink_to_fit();
+   ASSERT_GE(copy.capacity(), copy.size());
+   ASSERT_EQ(copy[49].load(), vec3(0, 0, 0));
+}
+
+TEST(vec_column, planar)
+{
+   check_layout<xlib::vec_column<double,3>>();
+
+   // Planes start aligned
+   xlib::vec_column<float,3> col(5);
+   for(size_t c = 0; c < 3; c++)
+   {
+      ASSERT_EQ(reinterpret_cast<uintptr_t>(&col.component(0, c)) % xlib::soa_alignment_v<float>, 0u);
+   }
+}
+
+TEST(vec_column, tiled)
+{
+   check_layout<xlib::vec_column<double,3,8>>();
+   check_layout<xlib::vec_column<double,3,1>>();
+}
+
+template < class Column >
+void check_soa()
+{
+   using vec3 = vec<double,3>;
+   xlib::static_soa<std::vector<int>, Column, Column> soa;
+   soa.resize(1001);
+   soa.apply_per_element([](int& id, auto x, auto v, size_t i)
+   {
+      id = static_cast<int>(i);
+      x = vec3(i, 0, -1.0 * i);
+      v = vec3(1, 2, 3);
+   });
+
+   // Unit stride position update through apply_blocked
+   soa.template apply_blocked<64>([](size_t, size_t n, int*, auto x, auto v)
+   {
+      for(size_t j = 0; j < n; j += (x + j).run_length())
+      {
+         size_t run = std::min((x + j).run_length(), n - j);
+         for(size_t c = 0; c < 3; c++)
+         {
+            double* xc = (x + j).component(c);
+            const double* vc = (v + j).component(c);
+            for(size_t k = 0; k < run; k++) xc[k] += 0.5 * vc[k];
+         }
+      }
+   });
+
+   std::vector<size_t> reversed(soa.size());
+   std::iota(reversed.rbegin(), reversed.rend(), 0);
+   soa.reorder(reversed);
+   soa.reorder(xlib::execution::par.threads(4), reversed);
+   soa.reorder(reversed);
+
+   soa.erase_if([](int id, auto, auto, size_t) { return id % 2 == 1; });
+   ASSERT_EQ(soa.size(), 501u);
+   for(size_t i = 0; i < soa.size(); i++)
+   {
+      size_t id = soa.template get_data<0>()[i];
+      ASSERT_EQ(id, 1000 - 2 * i);
+      ASSERT_EQ(soa.template get_data<1>()[i].load(), vec3(id + 0.5, 1, -1.0 * id + 1.5));
+   }
+
+   std::vector<double> speed(soa.size());
+   xlib::batch::norm(xlib::execution::par.threads(4).chunk(10), soa.template get_data<2>(), speed);
+   for(double s: speed) ASSERT_DOUBLE_EQ(s, std::sqrt(14.));
+}
+
+TEST(vec_column, static_soa)
+{
+   check_soa<xlib::vec_column<double,3>>();
+   check_soa<xlib::vec_column<double,3,4>>();
+}
+
+TEST(vec_column, batch)
+{
+   using vec3 = vec<float,3>;
+   xlib::vec_column<float,3,8> a(1003), b(1003), c(1003);
+   for(size_t i = 0; i < a.size(); i++)
+   {
+      a[i] = vec3(i, 1, 2);
+      b[i] = vec3(-1, i, 0.5f);
+   }
+   std::vector<float> d(a.size());
+   xlib::batch::dot(a, b, d);
+   xlib::batch::cross(xlib::execution::par.threads(4), a, b, c);
+   for(size_t i = 0; i < a.size(); i++)
+   {
+      ASSERT_FLOAT_EQ(d[i], a[i].load().dot(b[i].load()));
+      ASSERT_EQ(c[i].load(), a[i].load().cross(b[i].load()));
+   }
+
+   // In place, out aliasing an input
+   xlib::batch::cross(a, b, a);
+   for(size_t i = 0; i < a.size(); i++) ASSERT_EQ(a[i].load(), c[i].load());
+}
@@ -0,0 +1,102 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <random>
+
+#include <xlib/core/vec_batch.h>
+
+using xlib::vec;
+
+static_assert(vec<int,3>(1, 2, 3).dot(vec<int,3>(4, 5, 6)) == 32.f, "constexpr dot");
+static_assert(vec<double,3>(1, 0, 0).cross(vec<double,3>(0, 1, 0)) == vec<double,3>(0, 0, 1), "constexpr cross");
+static_assert(std::is_same<decltype(vec<int,2>().dot(vec<int,2>())), float>::value, "integer dot promotes");
+static_assert(std::is_trivially_copyable<vec<float,3>>::value, "vec is trivially copyable");
+
+TEST(vector, arithmetic)
+{
+   vec<double,3> a(1, 2, 3), b(4, 5, 6);
+   EXPECT_EQ(a + b, (vec<double,3>(5, 7, 9)));
+   EXPECT_EQ(b - a, (vec<double,3>(3, 3, 3)));
+   EXPECT_EQ(2. * a, (vec<double,3>(2, 4, 6)));
+   EXPECT_EQ(-a, (vec<double,3>(-1, -2, -3)));
+   EXPECT_EQ(xlib::cross(a, b), (vec<double,3>(-3, 6, -3)));
+   EXPECT_DOUBLE_EQ(xlib::dot(a, b), 32.);
+   EXPECT_DOUBLE_EQ((vec<double,2>(3, 4).norm()), 5.);
+}
+
+template < class T, size_t N >
+std::vector<vec<T,N>> random_vecs(size_t n, unsigned seed)
+{
+   std::mt19937 gen(seed);
+   std::uniform_real_distribution<double> dist(-10., 10.);
+   std::vector<vec<T,N>> v(n);
+   for(auto& x: v)
+   {
+      for(size_t j = 0; j < N; j++) x[j] = static_cast<T>(dist(gen));
+   }
+   return v;
+}
+
+template < class T, size_t N >
+void check_batch(size_t n)
+{
+   using R = xlib::promote_fp_t<T>;
+   auto a = random_vecs<T,N>(n, 1);
+   auto b = random_vecs<T,N>(n, 2);
+   std::vector<R> dots(n), norms(n);
+   xlib::batch::dot(a.data(), b.data(), dots.data(), n);
+   xlib::batch::norm(a.data(), norms.data(), n);
+   for(size_t i = 0; i < n; i++)
+   {
+      ASSERT_NEAR(dots[i], a[i].dot(b[i]), 1e-4 * std::abs(a[i].dot(b[i])) + 1e-4) << i;
+      ASSERT_NEAR(norms[i], a[i].norm(), 1e-5 * a[i].norm()) << i;
+   }
+   if constexpr(N == 3)
+   {
+      std::vector<vec<R,3>> crosses(n);
+      xlib::batch::cross(a.data(), b.data(), crosses.data(), n);
+      for(size_t i = 0; i < n; i++)
+      {
+         auto c = a[i].cross(b[i]);
+         for(size_t j = 0; j < 3; j++) ASSERT_NEAR(crosses[i][j], c[j], 1e-4 * std::abs(c[j]) + 1e-4) << i;
+      }
+   }
+}
+
+TEST(vector, batch_matches_scalar)
+{
+   // Odd sizes exercise the scalar tails of the SIMD kernels
+   for(size_t n: {0, 1, 3, 4, 5, 17, 1001})
+   {
+      check_batch<float,3>(n);
+      check_batch<float,4>(n);
+      check_batch<double,3>(n);
+      check_batch<double,2>(n);
+      check_batch<int,3>(n);
+   }
+}
+
+TEST(vector, batch_columns)
+{
+   using vec3 = vec<double,3>;
+   xlib::static_soa<vec3*, std::vector<vec3>, double*, std::vector<vec3>> soa;
+   soa.resize(10007);
+   auto a = random_vecs<double,3>(soa.size(), 3);
+   auto b = random_vecs<double,3>(soa.size(), 4);
+   std::copy(a.begin(), a.end(), soa.get_data<0>());
+   soa.get_data<1>() = b;
+
+   xlib::batch::dot(soa.get_data<0>(), soa.get_data<1>(), soa.get_data<2>());
+   xlib::batch::cross(xlib::execution::par.threads(4).chunk(100), soa.get_data<0>(), soa.get_data<1>(), soa.get_data<3>());
+   for(size_t i = 0; i < soa.size(); i++)
+   {
+      ASSERT_DOUBLE_EQ(soa.get_data<2>()[i], a[i].dot(b[i]));
+      ASSERT_EQ(soa.get_data<3>()[i], a[i].cross(b[i]));
+   }
+
+   std::vector<double> norms(soa.size());
+   xlib::batch::norm(xlib::execution::par.threads(4), soa.get_data<1>(), norms);
+   for(size_t i = 0; i < soa.size(); i++)
+   {
+      ASSERT_DOUBLE_EQ(norms[i], b[i].norm());
+   }
+}